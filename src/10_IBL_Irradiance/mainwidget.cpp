@@ -8,12 +8,9 @@
 
 MainWidget::MainWidget(QWidget *parent)
         : QOpenGLWidget(parent),
-          hdrTexture(nullptr),
           envCubemap(nullptr),
           irradianceMap(nullptr),
           debugSkybox_texture(nullptr),
-          captureFBO(nullptr),
-          cubeGeometry(nullptr),
           skybox_geometry(nullptr),
           sphereGeometry(nullptr),
           camera(nullptr) {
@@ -21,7 +18,7 @@ MainWidget::MainWidget(QWidget *parent)
     // Create two shader program
     // the first one use for offscreen rendering
     // the second for default framebuffer rendering
-    for (int i=0; i<4; i++) {
+    for (int i=0; i<2; i++) {
         programs.push_back(new QOpenGLShaderProgram(this));
     }
 
@@ -49,23 +46,28 @@ void MainWidget::initializeGL() {
 
     // ----- add shader from source file/code ----- //
     initShaders();
-    initTexture();
     loadDebugCubeMap();
     // --------------------------------------- //
 
     glSetting();
     initGeometry();
 
-    captureFBO = createFBOPointer(0);
-    renderEnvCubeMap(512);
-    renderIrradianceMap(128);
+    // diffuse only, the irradiance map comes straight from the cache after the first run
+    IBLSettings settings;
+    settings.specular = false;
+    IBLMaps maps = IBLPrecompute().load("src/texture/HDR/newport_loft.hdr", settings);
+    // empty when the HDR cannot be read
+    if (maps.envCubemap == nullptr)
+        close();
+    envCubemap = maps.envCubemap;
+    irradianceMap = maps.irradianceMap;
 }
 
 void MainWidget::paintGL() {
 
     QOpenGLFramebufferObject::bindDefault();
 
-    SHADER(2)->bind();
+    SHADER(0)->bind();
     glClearColor(0.15f, 0.15f, 0.15f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glEnable(GL_DEPTH_TEST);
@@ -84,24 +86,24 @@ void MainWidget::paintGL() {
             QVector3D(300.0f, 300.0f, 300.0f)
     };
 
-    SHADER(2)->setUniformValue("albedo", QVector3D(0.65f, 0.0f, 0.0f));
-    SHADER(2)->setUniformValue("ao", 1.0f);
-    SHADER(2)->setUniformValue("camPos", camera->getCameraPosition());
+    SHADER(0)->setUniformValue("albedo", QVector3D(0.65f, 0.0f, 0.0f));
+    SHADER(0)->setUniformValue("ao", 1.0f);
+    SHADER(0)->setUniformValue("camPos", camera->getCameraPosition());
 
     glActiveTexture(GL_TEXTURE0);
-    SHADER(2)->setUniformValue("irradianceMap", 0);
+    SHADER(0)->setUniformValue("irradianceMap", 0);
     irradianceMap->bind();
 
     for (int i=0; i<lightPositions.count(); i++) {
         QString lightPos = QString("lightPositions[") + QString::number(i) + QString("]");
         QString lightCol =QString("lightColors[") + QString::number(i) + QString("]");
-        SHADER(2)->setUniformValue(lightPos.toStdString().c_str(), lightPositions[i]);
-        SHADER(2)->setUniformValue(lightCol.toStdString().c_str(), lightColors[i]);
+        SHADER(0)->setUniformValue(lightPos.toStdString().c_str(), lightPositions[i]);
+        SHADER(0)->setUniformValue(lightCol.toStdString().c_str(), lightColors[i]);
 
         model.setToIdentity();
         model.translate(lightPositions[i]);
         sphereGeometry->drawGeometry(
-                SHADER(2),
+                SHADER(0),
                 model,
                 camera->getCameraView(),
                 camera->getCameraProjection());
@@ -111,16 +113,16 @@ void MainWidget::paintGL() {
     int nrColumns = 6;
     float spacing = 2.5;
     for (int row = 0; row < nrRows; row++) {
-        SHADER(2)->setUniformValue("metallic", float(row)/ float(nrRows));
+        SHADER(0)->setUniformValue("metallic", float(row)/ float(nrRows));
         for (int col = 0; col < nrColumns; col++) {
-            SHADER(2)->setUniformValue("roughness", qBound(0.05f,(float)col / (float)nrColumns,1.0f));
+            SHADER(0)->setUniformValue("roughness", qBound(0.05f,(float)col / (float)nrColumns,1.0f));
             model.setToIdentity();
             model.translate((col - (nrColumns / 2.0)) * spacing + 1.2f,
                             (row - (nrRows / 2.0)) * spacing + 1.2f,
                             0.0f);
 
             sphereGeometry->drawGeometry(
-                    SHADER(2),
+                    SHADER(0),
                     model,
                     camera->getCameraView(),
                     camera->getCameraProjection());
@@ -128,10 +130,10 @@ void MainWidget::paintGL() {
     }
 
     // Render background
-    SHADER(3)->bind();
+    SHADER(1)->bind();
     glDepthFunc(GL_LEQUAL);
     skybox_geometry->drawGeometry(
-            SHADER(3),
+            SHADER(1),
             camera->getCameraView(),
             camera->getCameraProjection(),
             irradianceMap);
@@ -143,92 +145,37 @@ void MainWidget::resizeGL(int width, int height) {
     qreal aspect = qreal(width) / qreal(height ? height : 1);
     camera->setCameraPerspective(aspect);
 
-    if (captureFBO != nullptr) {
-        delete captureFBO;
-        captureFBO = nullptr;
-    }
-    captureFBO = createFBOPointer(0);
-
     return QOpenGLWidget::resizeGL(width, height);
 }
 
 void MainWidget::initShaders() {
-    // for cube box
-    if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/CubeMap.vs.glsl"))
+    if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/PBRIrradiance.vs.glsl"))
         close();
-    if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/Shaders/EquirectangularToMap.fs.glsl"))
+    if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/Shaders/PBRIrradiance.fs.glsl"))
         close();
     if (!SHADER(0)->link())
         close();
     if (!SHADER(0)->bind())
         close();
 
-    // irradiance
-    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/CubeMap.vs.glsl"))
+    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/Background.vs.glsl"))
         close();
-    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/Shaders/IrradianceConvolution.fs.glsl"))
+    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/Shaders/Background.fs.glsl"))
         close();
     if (!SHADER(1)->link())
         close();
     if (!SHADER(1)->bind())
         close();
-
-    if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/PBRIrradiance.vs.glsl"))
-        close();
-    if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/Shaders/PBRIrradiance.fs.glsl"))
-        close();
-    if (!SHADER(2)->link())
-        close();
-    if (!SHADER(2)->bind())
-        close();
-
-    if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/Background.vs.glsl"))
-        close();
-    if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/Shaders/Background.fs.glsl"))
-        close();
-    if (!SHADER(3)->link())
-        close();
-    if (!SHADER(3)->bind())
-        close();
 }
 
 void MainWidget::initGeometry() {
-    cubeGeometry = new CubeGeometry;
-    cubeGeometry->initGeometry();
-    cubeGeometry->setupAttributePointer(SHADER(0));
-
     sphereGeometry = new SphereGeometry;
     sphereGeometry->initGeometry();
-    sphereGeometry->setupAttributePointer(SHADER(2));
+    sphereGeometry->setupAttributePointer(SHADER(0));
 
     skybox_geometry = new SkyboxGeometry;
     skybox_geometry->initGeometry();
-    skybox_geometry->setupAttributePointer(SHADER(3));
-}
-
-void MainWidget::initTexture() {
-    loadHDRTextrue();
-    generateEnvCubeMap(512);
-    generateIrradianceMap(128);
-}
-
-void MainWidget::loadHDRTextrue() {
-    int width, height, channels;
-    stbi_set_flip_vertically_on_load(true);
-    float *image = stbi_loadf("src/texture/HDR/newport_loft.hdr", &width, &height, &channels, 0);
-
-    hdrTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
-    hdrTexture->create();
-    hdrTexture->setSize(width, height, channels);
-    hdrTexture->setFormat(QOpenGLTexture::RGB32F);
-    hdrTexture->allocateStorage();
-
-    hdrTexture->setData(0,0,QOpenGLTexture::RGB,QOpenGLTexture::Float32, image,Q_NULLPTR);
-    hdrTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
-    hdrTexture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    hdrTexture->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
-
-    stbi_image_free(image);
+    skybox_geometry->setupAttributePointer(SHADER(1));
 }
 
 void MainWidget::loadDebugCubeMap() {
@@ -257,109 +204,9 @@ void MainWidget::loadDebugCubeMap() {
     debugSkybox_texture->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
 }
 
-void MainWidget::generateEnvCubeMap(int precision) {
-    envCubemap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-    envCubemap->create();
-    envCubemap->setSize(precision, precision, 3);
-    envCubemap->setFormat(QOpenGLTexture::RGB32F);
-    envCubemap->allocateStorage();
-    envCubemap->bind();
-
-    envCubemap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    envCubemap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    envCubemap->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
-}
-
-void MainWidget::generateIrradianceMap(int precision) {
-    irradianceMap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-    irradianceMap->create();
-    irradianceMap->setSize(precision, precision, 3);
-    irradianceMap->setFormat(QOpenGLTexture::RGB32F);
-    irradianceMap->allocateStorage();
-    irradianceMap->bind();
-
-    irradianceMap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    irradianceMap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    irradianceMap->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
-}
-
-void MainWidget::renderEnvCubeMap(int precision) {
-    // rendering
-    SHADER(0)->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(0)->setUniformValue("equirectangularMap", 0);
-    hdrTexture->bind();
-    SHADER(0)->setUniformValue("projection", captureProjection);
-
-    glViewport(0, 0, precision * devicePixelRatio(), precision * devicePixelRatio());
-    captureFBO->bind();
-    for(int i=0; i<captureViews.count(); ++i) {
-        SHADER(0)->setUniformValue("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap->textureId(), 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        cubeGeometry->drawGeometry(
-                SHADER(0), hdrTexture);
-    }
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-}
-
-void MainWidget::renderIrradianceMap(int precision) {
-    // rendering
-    SHADER(1)->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(1)->setUniformValue("environmentMap", 0);
-    envCubemap->bind();
-    SHADER(1)->setUniformValue("projection", captureProjection);
-
-    glViewport(0, 0, precision * devicePixelRatio(), precision * devicePixelRatio());
-    captureFBO->bind();
-    for(int i=0; i<captureViews.count(); ++i) {
-        SHADER(1)->setUniformValue("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap->textureId(), 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        cubeGeometry->drawGeometry(
-                SHADER(1), envCubemap);
-    }
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-}
-
 void MainWidget::glSetting() {
     // Enable depth buffer
     glEnable(GL_DEPTH_TEST);
-
-    // Setting
-    captureProjection.setToIdentity();
-    captureProjection.perspective(90.0f, 1.0f, 0.1f, 10.0f);
-
-    QMatrix4x4 lookAt_1;
-    lookAt_1.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(1.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_2;
-    lookAt_2.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(-1.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_3;
-    lookAt_3.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f));
-    QMatrix4x4 lookAt_4;
-    lookAt_4.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f));
-    QMatrix4x4 lookAt_5;
-    lookAt_5.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_6;
-    lookAt_6.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    captureViews << lookAt_1 << lookAt_2 << lookAt_3 << lookAt_4 << lookAt_5 << lookAt_6;
-}
-
-QOpenGLFramebufferObject* MainWidget::createFBOPointer(int sampleCount) {
-    QOpenGLFramebufferObjectFormat format;
-    format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-    format.setInternalTextureFormat(QOpenGLTexture::RGB32F);
-    format.setSamples(sampleCount);
-
-    QSize frameBufferSize(width() * devicePixelRatio(), height() * devicePixelRatio());
-    return new QOpenGLFramebufferObject(frameBufferSize, format);
 }
 
 void MainWidget::cleanup() {
@@ -369,22 +216,16 @@ void MainWidget::cleanup() {
     qDeleteAll(programs);
     programs.clear();
     delete camera;
-    delete hdrTexture;
     delete envCubemap;
     delete irradianceMap;
     delete debugSkybox_texture;
-    delete captureFBO;
-    delete cubeGeometry;
     delete skybox_geometry;
     delete sphereGeometry;
 
     camera = nullptr;
-    hdrTexture = nullptr;
     envCubemap = nullptr;
     irradianceMap = nullptr;
     debugSkybox_texture = nullptr;
-    captureFBO = nullptr;
-    cubeGeometry = nullptr;
     skybox_geometry = nullptr;
     sphereGeometry = nullptr;
 
@@ -11,12 +11,11 @@
 #include <QOpenGLFramebufferObjectFormat>
 
 #include "Helper/Camera.h"
-#include "Helper/CubeGeometry.h"
 #include "Helper/SkyboxGeometry.h"
 #include "Helper/SphereGeometry.h"
+#include "Helper/IBLPrecompute.h"
 
 class Camera;
-class CubeGeometry;
 class SkyboxGeometry;
 class SphereGeometry;
 
@@ -39,17 +38,9 @@ protected:
 
     void initShaders();
     void initGeometry();
-    void initTexture();
 
     void glSetting();
-    void loadHDRTextrue();
     void loadDebugCubeMap();
-    void generateEnvCubeMap(int precision);
-    void generateIrradianceMap(int precision);
-    void renderEnvCubeMap(int precision);
-    void renderIrradianceMap(int precision);
-
-    QOpenGLFramebufferObject* createFBOPointer(int sampleCount=0);
 
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
@@ -58,12 +49,10 @@ protected:
 
 private:
     QList<QOpenGLShaderProgram *> programs;
-    QOpenGLTexture *hdrTexture;
     QOpenGLTexture *envCubemap;
     QOpenGLTexture *debugSkybox_texture;
     QOpenGLTexture *irradianceMap;
 
-    CubeGeometry *cubeGeometry;
     SkyboxGeometry *skybox_geometry;
     SphereGeometry *sphereGeometry;
 
@@ -71,8 +60,6 @@ private:
     QMatrix4x4 model;
     QPoint mousePos;
 
-    QOpenGLFramebufferObject *captureFBO;
-
     QList<QString> faces{
             QString("src/texture/CubeMap/right.jpg"),
             QString("src/texture/CubeMap/left.jpg"),
@@ -82,9 +69,6 @@ private:
             QString("src/texture/CubeMap/back.jpg"),
     };
 
-    QMatrix4x4 captureProjection;
-    QVector<QMatrix4x4> captureViews;
-
 public slots:
     void cleanup();
 };
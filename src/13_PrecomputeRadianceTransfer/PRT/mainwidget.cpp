@@ -58,12 +58,12 @@ void MainWidget::paintGL() {
 
     // if receive the rotate signal, then rotate light function coefficient
     if (autoRotateSwitcher) {
-        QVector<QVector3D> transformedLightCoefficient = rotateLightCoefficient();
+        const QVector<QVector3D>& rotatedLightCoefficient = rotateLightCoefficient();
 
         SHADER(0)->setUniformValueArray(
                 "LightSHCoefficient",
-                transformedLightCoefficient.data(),
-                transformedLightCoefficient.count());
+                rotatedLightCoefficient.constData(),
+                rotatedLightCoefficient.count());
 
         phi += 1;
         update();
@@ -115,7 +115,7 @@ void MainWidget::initLightAndTransferFunction(QString lightData, QString Transfe
     diffuseObj.readFromDisk(TransferData);
 }
 
-QVector<QVector3D> MainWidget::rotateLightCoefficient() {
+const QVector<QVector3D>& MainWidget::rotateLightCoefficient() {
     // band
     int band = qSqrt(lightPattern.coefficient.count());
 
@@ -124,9 +124,10 @@ QVector<QVector3D> MainWidget::rotateLightCoefficient() {
     rotateMatrix.setToIdentity();
     rotateMatrix.rotate(QQuaternion::fromAxisAndAngle(QVector3D(0.0, 1.0, 0.0), (float)phi));
 
-    QVector<QVector3D> transformedLightCoefficient;
-    if (band <= 3) {
-        transformedLightCoefficient = SHRotation::FastSHRotate(band, rotateMatrix, lightPattern.coefficient);
+    if (band <= SHRotator::MaxBand) {
+        // fixed-size path, reuses the output buffer across frames
+        lightRotator.setRotation(rotateMatrix);
+        lightRotator.rotate(band, lightPattern.coefficient, transformedLightCoefficient);
     }
     else {
         transformedLightCoefficient = SHRotation::SHRotate(band, rotateMatrix, lightPattern.coefficient);
@@ -19,6 +19,7 @@
 #include "Utility/Lighting.h"
 #include "Utility/DiffuseObject.h"
 #include "Utility/SHRotation.h"
+#include "Utility/SHRotator.h"
 
 class Camera;
 class CustomGeometry;
@@ -42,7 +43,7 @@ protected:
     void initShaders();
     void initGeometry();
     void initLightAndTransferFunction(QString lightData, QString TransferData);
-    QVector<QVector3D> rotateLightCoefficient();
+    const QVector<QVector3D>& rotateLightCoefficient();
 
     void glSetting();
 
@@ -66,6 +67,9 @@ private:
     Lighting lightPattern;
     DiffuseObject diffuseObj;
 
+    SHRotator lightRotator;
+    QVector<QVector3D> transformedLightCoefficient;
+
     int phi;
     bool autoRotateSwitcher = false;
 
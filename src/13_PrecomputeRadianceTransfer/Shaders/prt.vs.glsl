@@ -1,5 +1,5 @@
 #version 460 core
-#define SHBAND2 9
+#define MAX_SHBAND2 36
 
 uniform mat4 model;
 uniform mat4 view;
@@ -10,18 +10,29 @@ layout (location = 1) in vec2 aCoord;
 layout (location = 2) in vec3 aNormal;
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec3 aBitangent;
-layout (location = 5) in vec3 ObjectSHCoefficient[SHBAND2];
 
-uniform vec3 LightSHCoefficient[SHBAND2];
+// [vertex][coefficient][rgb], see CustomGeometry::setupObjectSHCoefficient
+layout (std430, binding = 0) readonly buffer ObjectSHCoefficientBuffer {
+    float ObjectSHCoefficient[];
+};
+
+uniform int SHBandPower2;
+uniform int ObjectSHBandPower2;
+uniform vec3 LightSHCoefficient[MAX_SHBAND2];
 
 out vec3 Color;
 
 void main() {
     gl_Position = projection * view * model * vec4(aPos, 1.0f);
 
+    int base = gl_VertexID * ObjectSHBandPower2 * 3;
     vec3 accColor = vec3(0.0, 0.0, 0.0);
-    for (int i = 0; i < SHBAND2; ++i) {
-        accColor += LightSHCoefficient[i] * ObjectSHCoefficient[i];
+    for (int i = 0; i < SHBandPower2; ++i) {
+        vec3 objectCoefficient = vec3(
+                ObjectSHCoefficient[base + i * 3 + 0],
+                ObjectSHCoefficient[base + i * 3 + 1],
+                ObjectSHCoefficient[base + i * 3 + 2]);
+        accColor += LightSHCoefficient[i] * objectCoefficient;
     }
     Color = accColor;
 }
@@ -3,20 +3,19 @@
 void BVHTree::build(Object &obj) {
     qDebug() << "BVHTree: Start building";
 
-    int numbersOfTriangles = obj.getIndices().count() / 3;
-    _triangles.clear();
+    const QVector<quint64>& indices = obj.getIndices();
+    const QVector<SampleVertexData>& vertices = obj.getVerticesData();
 
-    QVector<quint64> indices = obj.getIndices();
-    QVector<SampleVertexData> vertices = obj.getVerticesData();
+    int numbersOfTriangles = indices.count() / 3;
+    _triangles.clear();
+    _triangles.reserve(numbersOfTriangles);
 
     // get each triangle
     for (int i = 0; i < numbersOfTriangles; i++) {
         // for loop every triangle
         int offset = 3 * i; // each triangle start point/vertex
 
-        Triangle triangle;
-        QVector<QVector3D> v;
-        v.resize(3);
+        QVector3D v[3];
         unsigned int index;
 
         for (int j = 0; j < 3; j++) {
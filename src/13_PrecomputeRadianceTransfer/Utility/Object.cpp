@@ -20,14 +20,6 @@ void Object::initGeometry(const QString& modelFilePath, QVector3D albedo, bool c
     processNode(scene->mRootNode, scene, calcTangent);
 }
 
-QVector<SampleVertexData> Object::getVerticesData() {
-    return vertices;
-}
-
-QVector<quint64> Object::getIndices() {
-    return indices;
-}
-
 void Object::processNode(aiNode *node, const aiScene *scene, bool calcTangent) {
     // process each mesh located at the current node
     for(unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -36,8 +36,8 @@ public:
     void processNode(aiNode *node, const aiScene *scene, bool calcTangent);
     void processMesh(aiMesh *mesh, const aiScene *scene, bool calcTangent);
 
-    QVector<SampleVertexData> getVerticesData();
-    QVector<quint64> getIndices();
+    const QVector<SampleVertexData>& getVerticesData() const { return vertices; }
+    const QVector<quint64>& getIndices() const { return indices; }
 
     // Project to SH function.
     virtual void processingData(int mode, int band, int numbersOfSampler, int bounce) = 0;
@@ -0,0 +1,203 @@
+#include "SHRotator.h"
+
+#include <cmath>
+
+// offset of each band matrix inside m_bandMatrix
+static const int BandMatrixOffset[SHRotator::MaxBand] = {0, 0, 9, 34, 83};
+
+// X(+90) rotation for every band, row major, same constants as SHRotation::rotate_X with a = 1.
+// X(-90) is the transpose.
+static const float RotateX90[9 + 25 + 49 + 81] = {
+        // band 1
+        0.0f, 1.0f, 0.0f,
+        -1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f,
+        // band 2
+        0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, -0.5f, 0.0f, -0.8660253882f,
+        -1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, -0.8660253882f, 0.0f, 0.5f,
+        // band 3
+        0.0f, 0.0f, 0.0f, -0.7905694842f, 0.0f, 0.6123724580f, 0.0f,
+        0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, -0.6123724580f, 0.0f, -0.7905694842f, 0.0f,
+        0.7905694842f, 0.0f, 0.6123724580f, 0.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f, -0.25f, 0.0f, -0.9682458639f,
+        -0.6123724580f, 0.0f, 0.7905694842f, 0.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f, -0.9682458639f, 0.0f, 0.25f,
+        // band 4
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -0.9354143739f, 0.0f, 0.3535533845f, 0.0f,
+        0.0f, -0.75f, 0.0f, 0.6614378095f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -0.3535533845f, 0.0f, -0.9354143739f, 0.0f,
+        0.0f, 0.6614378095f, 0.0f, 0.75f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f, 0.375f, 0.0f, 0.5590170026f, 0.0f, 0.7395099998f,
+        0.9354143739f, 0.0f, 0.3535533845f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f, 0.5590170026f, 0.0f, 0.5f, 0.0f, -0.6614378691f,
+        -0.3535533845f, 0.0f, 0.9354143739f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 0.0f, 0.7395099998f, 0.0f, -0.6614378691f, 0.0f, 0.125f,
+};
+
+template <int N>
+static inline void applyBandMatrix(const float *matrix, const QVector3D *in, QVector3D *out) {
+    for (int i = 0; i < N; i++) {
+        float r = 0.0f, g = 0.0f, b = 0.0f;
+        for (int j = 0; j < N; j++) {
+            const float m = matrix[i * N + j];
+            r += m * in[j].x();
+            g += m * in[j].y();
+            b += m * in[j].z();
+        }
+        out[i] = QVector3D(r, g, b);
+    }
+}
+
+SHRotator::SHRotator() : m_alpha(0.0f), m_beta(0.0f), m_gamma(0.0f) {
+    computeZTable(0.0f, m_cosAlpha, m_sinAlpha);
+    computeZTable(0.0f, m_cosBeta, m_sinBeta);
+    computeZTable(0.0f, m_cosGamma, m_sinGamma);
+
+    for (int l = 1; l < MaxBand; l++)
+        computeBandMatrix(l);
+}
+
+void SHRotator::setRotation(const QMatrix4x4 &rotateMatrix) {
+    // same zyz decomposition as SHRotation::SHRotate
+    QMatrix3x3 n_rotateMatrix = rotateMatrix.normalMatrix();
+    const float *m = n_rotateMatrix.constData();
+
+    float alpha, beta, gamma;
+    if (fabsf(m[8]) < 1.0f) {
+        float sinb = sqrtf(1.0f - m[8] * m[8]);
+        alpha = atan2f(m[7], m[6]);
+        beta = atan2f(sinb, m[8]);
+        gamma = atan2f(m[5], -m[2]);
+    }
+    else {
+        // rotation around z only (beta = 0) or z flipped (beta = pi)
+        alpha = atan2f(-m[3], m[4]);
+        beta = m[8] > 0.0f ? 0.0f : float(M_PI);
+        gamma = 0.0f;
+    }
+
+    setRotation(alpha, beta, gamma);
+}
+
+void SHRotator::setRotation(float alpha, float beta, float gamma) {
+    if (alpha == m_alpha && beta == m_beta && gamma == m_gamma)
+        return;
+
+    // only rebuild the z tables of the angles that actually changed
+    if (alpha != m_alpha)
+        computeZTable(alpha, m_cosAlpha, m_sinAlpha);
+    if (beta != m_beta)
+        computeZTable(beta, m_cosBeta, m_sinBeta);
+    if (gamma != m_gamma)
+        computeZTable(gamma, m_cosGamma, m_sinGamma);
+
+    m_alpha = alpha;
+    m_beta = beta;
+    m_gamma = gamma;
+
+    for (int l = 1; l < MaxBand; l++)
+        computeBandMatrix(l);
+}
+
+void SHRotator::computeZTable(float angle, float *c, float *s) {
+    // cos/sin(m * angle) by angle addition, one sincos per angle
+    c[0] = 1.0f;
+    s[0] = 0.0f;
+    c[1] = cosf(angle);
+    s[1] = sinf(angle);
+    for (int m = 2; m < MaxBand; m++) {
+        c[m] = c[m - 1] * c[1] - s[m - 1] * s[1];
+        s[m] = s[m - 1] * c[1] + c[m - 1] * s[1];
+    }
+}
+
+void SHRotator::computeBandMatrix(int l) {
+    const int n = 2 * l + 1;
+    const float *x90 = RotateX90 + BandMatrixOffset[l];
+    float *D = m_bandMatrix + BandMatrixOffset[l];
+    float T[9 * 9];
+
+    // T = X(+90) * Z(gamma), z only mixes column pair (l-m, l+m)
+    for (int i = 0; i < n * n; i++)
+        T[i] = x90[i];
+    for (int r = 0; r < n; r++) {
+        for (int m = 1; m <= l; m++) {
+            float a = T[r * n + l - m];
+            float b = T[r * n + l + m];
+            T[r * n + l - m] = a * m_cosGamma[m] - b * m_sinGamma[m];
+            T[r * n + l + m] = a * m_sinGamma[m] + b * m_cosGamma[m];
+        }
+    }
+
+    // T = Z(beta) * T, z only mixes row pair (l-m, l+m)
+    for (int m = 1; m <= l; m++) {
+        for (int col = 0; col < n; col++) {
+            float a = T[(l - m) * n + col];
+            float b = T[(l + m) * n + col];
+            T[(l - m) * n + col] = m_cosBeta[m] * a + m_sinBeta[m] * b;
+            T[(l + m) * n + col] = -m_sinBeta[m] * a + m_cosBeta[m] * b;
+        }
+    }
+
+    // D = X(-90) * T = transpose(X(+90)) * T
+    for (int r = 0; r < n; r++) {
+        for (int col = 0; col < n; col++) {
+            float sum = 0.0f;
+            for (int k = 0; k < n; k++)
+                sum += x90[k * n + r] * T[k * n + col];
+            D[r * n + col] = sum;
+        }
+    }
+
+    // D = Z(alpha) * D
+    for (int m = 1; m <= l; m++) {
+        for (int col = 0; col < n; col++) {
+            float a = D[(l - m) * n + col];
+            float b = D[(l + m) * n + col];
+            D[(l - m) * n + col] = m_cosAlpha[m] * a + m_sinAlpha[m] * b;
+            D[(l + m) * n + col] = -m_sinAlpha[m] * a + m_cosAlpha[m] * b;
+        }
+    }
+}
+
+void SHRotator::rotate(unsigned int band, const QVector3D *inLightCoefficient, QVector3D *outLightCoefficient) const {
+    Q_ASSERT(band <= MaxBand);
+    Q_ASSERT(inLightCoefficient != outLightCoefficient);
+
+    if (band == 0)
+        return;
+
+    outLightCoefficient[0] = inLightCoefficient[0];
+    if (band > 1)
+        applyBandMatrix<3>(m_bandMatrix + BandMatrixOffset[1], inLightCoefficient + 1, outLightCoefficient + 1);
+    if (band > 2)
+        applyBandMatrix<5>(m_bandMatrix + BandMatrixOffset[2], inLightCoefficient + 4, outLightCoefficient + 4);
+    if (band > 3)
+        applyBandMatrix<7>(m_bandMatrix + BandMatrixOffset[3], inLightCoefficient + 9, outLightCoefficient + 9);
+    if (band > 4)
+        applyBandMatrix<9>(m_bandMatrix + BandMatrixOffset[4], inLightCoefficient + 16, outLightCoefficient + 16);
+}
+
+void SHRotator::rotate(unsigned int band, const QVector<QVector3D> &inLightCoefficient, QVector<QVector3D> &outLightCoefficient) const {
+    int bandPower2 = band * band;
+    Q_ASSERT(inLightCoefficient.count() >= bandPower2);
+
+    // keeps the capacity, so reusing the same output only allocates once
+    if (outLightCoefficient.count() != bandPower2)
+        outLightCoefficient.resize(bandPower2);
+
+    rotate(band, inLightCoefficient.constData(), outLightCoefficient.data());
+}
+
+void SHRotator::rotateBatch(unsigned int band, const QVector3D *inLightCoefficient, QVector3D *outLightCoefficient, int numbersOfProbe) const {
+    int bandPower2 = band * band;
+
+#pragma omp parallel for if (numbersOfProbe > 256)
+    for (int i = 0; i < numbersOfProbe; i++) {
+        rotate(band, inLightCoefficient + i * bandPower2, outLightCoefficient + i * bandPower2);
+    }
+}
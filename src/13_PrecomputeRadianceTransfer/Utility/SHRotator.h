@@ -0,0 +1,47 @@
+#ifndef INHOUSE_QTOPENGL_PRT_SHROTATOR_H
+#define INHOUSE_QTOPENGL_PRT_SHROTATOR_H
+
+
+#include <QVector>
+#include <QVector3D>
+#include <QMatrix4x4>
+
+/*
+ * Allocation-free SH rotation for band 0-4 (up to 25 coefficients).
+ *
+ * The rotation is decomposed as R = Rz(alpha) * Ry(beta) * Rz(gamma) and every band is
+ * rotated with D = Z(alpha) * X(-90) * Z(beta) * X(+90) * Z(gamma). X(+-90) are constant,
+ * Z only needs cos/sin(m * angle), so setRotation() bakes the per-band matrices once and
+ * rotate()/rotateBatch() are plain fixed-size matrix-vector products for any number of probes.
+ */
+class SHRotator {
+public:
+    static const int MaxBand = 5;
+    static const int MaxCoefficient = MaxBand * MaxBand;
+
+    SHRotator();
+
+    void setRotation(const QMatrix4x4 &rotateMatrix);
+    void setRotation(float alpha, float beta, float gamma);
+
+    void rotate(unsigned int band, const QVector3D *inLightCoefficient, QVector3D *outLightCoefficient) const;
+    void rotate(unsigned int band, const QVector<QVector3D> &inLightCoefficient, QVector<QVector3D> &outLightCoefficient) const;
+
+    // probes are stored one after another, band * band coefficients each
+    void rotateBatch(unsigned int band, const QVector3D *inLightCoefficient, QVector3D *outLightCoefficient, int numbersOfProbe) const;
+
+private:
+    static void computeZTable(float angle, float *c, float *s);
+    void computeBandMatrix(int l);
+
+    // band 1 - 4 matrices packed one after another: 3x3, 5x5, 7x7, 9x9
+    float m_bandMatrix[9 + 25 + 49 + 81];
+
+    float m_alpha, m_beta, m_gamma;
+    float m_cosAlpha[MaxBand], m_sinAlpha[MaxBand];
+    float m_cosBeta[MaxBand], m_sinBeta[MaxBand];
+    float m_cosGamma[MaxBand], m_sinGamma[MaxBand];
+};
+
+
+#endif
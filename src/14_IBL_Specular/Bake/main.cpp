@@ -0,0 +1,112 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QFloat16>
+#include <QDebug>
+
+#include <cmath>
+#include <cstdio>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "Helper/IBLCache.h"
+#include "Helper/IBLReference.h"
+
+// every channel of a level as float, without the row padding
+static QVector<float> unpackLevel(const KTXFile &file, int level, int channels) {
+    int size = qMax(1, int(file.width) >> level);
+    int rowFloats = size * channels;
+    int rowPitch = (rowFloats * int(sizeof(qfloat16)) + 3) & ~3;
+
+    QVector<float> texels(rowFloats * size * int(file.faces));
+    for (int row = 0; row < size * int(file.faces); row++)
+        qFloatFromFloat16(texels.data() + row * rowFloats,
+                          reinterpret_cast<const qfloat16*>(file.levels[level].constData() + row * rowPitch), rowFloats);
+    return texels;
+}
+
+// per level difference of the cached (GPU) map to the reference, relative to the reference energy
+static void compare(const char *name, const QString &path, const KTXFile &reference) {
+    KTXFile cached;
+    if (!cached.load(path)) {
+        std::printf("  %-12s not cached, run a viewer first\n", name);
+        return;
+    }
+    if (cached.width != reference.width || cached.faces != reference.faces || cached.levelCount() != reference.levelCount() ||
+        cached.glInternalFormat != reference.glInternalFormat) {
+        std::printf("  %-12s layout differs from the reference\n", name);
+        return;
+    }
+
+    // RG16F for the BRDF LUT, RGBA16F for the prefiltered map, RGB16F for the other cube maps
+    int channels = reference.glInternalFormat == 0x822F ? 2 : reference.glInternalFormat == 0x881A ? 4 : 3;
+    for (int level = 0; level < reference.levelCount(); level++) {
+        QVector<float> a = unpackLevel(cached, level, channels);
+        QVector<float> b = unpackLevel(reference, level, channels);
+        double maxError = 0.0, squaredError = 0.0, squaredReference = 0.0;
+        for (int i = 0; i < a.count(); i++) {
+            double error = std::fabs(a[i] - b[i]);
+            maxError = qMax(maxError, error);
+            squaredError += error * error;
+            squaredReference += double(b[i]) * b[i];
+        }
+        std::printf("  %-12s level %2d  max abs %10.5f  relative rms %8.5f\n", name, level, maxError,
+                    squaredReference > 0.0 ? std::sqrt(squaredError / squaredReference) : 0.0);
+    }
+}
+
+static bool bakeFile(const QString &path, const IBLSettings &settings, bool compareOnly) {
+    IBLCachePaths paths = IBLCache::paths(path, settings);
+    if (paths.envCubemap.isEmpty())
+        return false;
+    std::printf("%s\n", qPrintable(QFileInfo(path).fileName()));
+
+    QElapsedTimer timer;
+    timer.start();
+    IBLReference reference;
+    if (!reference.loadEnvironment(path, settings.envSize))
+        return false;
+    std::printf("  environment and SH     %8lld ms\n", timer.restart());
+
+    struct Map {
+        const char *name;
+        QString path;
+        KTXFile file;
+    };
+    QVector<Map> maps;
+    maps << Map{"environment", paths.envCubemap, reference.envCubemap()};
+    maps << Map{"irradiance", paths.irradianceMap, reference.irradianceMap(settings.irradianceSize)};
+    std::printf("  irradiance             %8lld ms\n", timer.restart());
+    maps << Map{"prefilter", paths.prefilterMap, reference.prefilterMap(settings.prefilterSize, settings.prefilterSamples)};
+    std::printf("  prefilter              %8lld ms\n", timer.restart());
+    maps << Map{"brdf", paths.brdfLUTTexture, IBLReference::brdfLUT(settings.brdfSize, settings.brdfSamples)};
+    std::printf("  brdf                   %8lld ms\n", timer.restart());
+
+    for (const auto &map : maps) {
+        if (compareOnly)
+            compare(map.name, map.path, map.file);
+        else if (!map.file.save(map.path))
+            std::printf("  failed to write %s\n", qPrintable(map.path));
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    // usage: InHouse_IBLBake [--compare] [hdr files ...]
+    // fills the IBL cache without a GPU, or with --compare checks the cached GPU maps against the reference
+    QStringList files = app.arguments().mid(1);
+    bool compareOnly = files.removeAll("--compare") > 0;
+    if (files.isEmpty())
+        files << "src/texture/HDR/newport_loft.hdr";
+
+    IBLSettings settings;
+    int failed = 0;
+    for (const auto &file : files) {
+        if (!bakeFile(file, settings, compareOnly))
+            failed++;
+    }
+    return failed ? -1 : 0;
+}
@@ -13,17 +13,16 @@
 #include <QDebug>
 
 #include "Helper/Camera.h"
-#include "Helper/CubeGeometry.h"
 #include "Helper/SkyboxGeometry.h"
 #include "Helper/SphereGeometry.h"
 #include "Helper/RectangleGeometry.h"
+#include "Helper/IBLPrecompute.h"
 
 #ifndef DEBUG
 #define DEBUG false
 #endif
 
 class Camera;
-class CubeGeometry;
 class SkyboxGeometry;
 class SphereGeometry;
 class RectangleGeometry;
@@ -50,18 +49,7 @@ protected:
     void initTexture();
 
     void glSetting();
-    void loadHDRTextrue();
     void loadDebugCubeMap();
-    void generateEnvCubeMap(int precision);
-    void generateIrradianceMap(int precision);
-    void generatePrefilterMap(int precision);
-    void generateBRDFMap(int precision);
-    void renderEnvCubeMap(int precision);
-    void renderIrradianceMap(int precision);
-    void renderPrefilterMap(int precision);
-    void renderBRDFMap(int precision);
-
-    QOpenGLFramebufferObject* createFBOPointer(int sampleCount=0);
 
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
@@ -70,7 +58,6 @@ protected:
 
 private:
     QList<QOpenGLShaderProgram *> programs;
-    QOpenGLTexture *hdrTexture;
     QOpenGLTexture *envCubemap;
     QOpenGLTexture *debugSkybox_texture;
     QOpenGLTexture *irradianceMap;
@@ -78,7 +65,6 @@ private:
     QOpenGLTexture *brdfLUTTexture;
     QOpenGLTexture *debugTexture;
 
-    CubeGeometry *cubeGeometry;
     SkyboxGeometry *skybox_geometry;
     SphereGeometry *sphereGeometry;
     RectangleGeometry *QuadGeometry;
@@ -87,8 +73,6 @@ private:
     QMatrix4x4 model;
     QPoint mousePos;
 
-    QOpenGLFramebufferObject *captureFBO;
-
     QList<QString> faces{
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/CubeMap/right.jpg"),
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/CubeMap/left.jpg"),
@@ -98,9 +82,6 @@ private:
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/CubeMap/back.jpg"),
     };
 
-    QMatrix4x4 captureProjection;
-    QVector<QMatrix4x4> captureViews;
-
 public slots:
     void cleanup();
 };
@@ -13,17 +13,17 @@
 #include <QDebug>
 
 #include "Helper/Camera.h"
-#include "Helper/CubeGeometry.h"
 #include "Helper/SkyboxGeometry.h"
 #include "Helper/SphereGeometry.h"
 #include "Helper/RectangleGeometry.h"
+#include "Helper/IBLPrecompute.h"
+#include "Helper/TextureStreamer.h"
 
 #ifndef DEBUG
 #define DEBUG false
 #endif
 
 class Camera;
-class CubeGeometry;
 class SkyboxGeometry;
 class SphereGeometry;
 class RectangleGeometry;
@@ -50,21 +50,10 @@ protected:
     void initTexture();
 
     void glSetting();
-    void loadHDRTextrue();
     void loadDebugCubeMap();
-    void generateEnvCubeMap(int precision);
-    void generateIrradianceMap(int precision);
-    void generatePrefilterMap(int precision);
-    void generateBRDFMap(int precision);
-    void renderEnvCubeMap(int precision);
-    void renderIrradianceMap(int precision);
-    void renderPrefilterMap(int precision);
-    void renderBRDFMap(int precision);
 
     void loadMaterialTextures();
 
-    QOpenGLFramebufferObject* createFBOPointer(int sampleCount=0);
-
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
@@ -72,7 +61,6 @@ protected:
 
 private:
     QList<QOpenGLShaderProgram *> programs;
-    QOpenGLTexture *hdrTexture;
     QOpenGLTexture *envCubemap;
     QOpenGLTexture *debugSkybox_texture;
     QOpenGLTexture *irradianceMap;
@@ -80,7 +68,6 @@ private:
     QOpenGLTexture *brdfLUTTexture;
     QOpenGLTexture *debugTexture;
 
-    CubeGeometry *cubeGeometry;
     SkyboxGeometry *skybox_geometry;
     SphereGeometry *sphereGeometry;
     RectangleGeometry *QuadGeometry;
@@ -89,8 +76,6 @@ private:
     QMatrix4x4 model;
     QPoint mousePos;
 
-    QOpenGLFramebufferObject *captureFBO;
-
     QList<QString> faces{
             QString("src/texture/CubeMap/CubeMap/right.jpg"),
             QString("src/texture/CubeMap/CubeMap/left.jpg"),
@@ -100,10 +85,10 @@ private:
             QString("src/texture/CubeMap/CubeMap/back.jpg"),
     };
 
-    QMatrix4x4 captureProjection;
-    QVector<QMatrix4x4> captureViews;
-
     // albedo texture
+    // the material textures stream in, placeholders until then
+    TextureStreamer *textureStreamer = nullptr;
+
     QList<QOpenGLTexture*> albedo_textures;
     QList<QString> albedoTextureFilePath{
             QString("src/texture/PBR/beatenMetal/beatenMetal-albedo.png"),
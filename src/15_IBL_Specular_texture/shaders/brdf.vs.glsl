@@ -1,12 +0,0 @@
-#version 460 core
-
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aCoord;
-
-out vec2 coord;
-
-void main()
-{
-    coord = aCoord;
-    gl_Position = vec4(aPos, 1.0);
-}
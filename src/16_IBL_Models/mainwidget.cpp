@@ -9,15 +9,12 @@
 
 MainWidget::MainWidget(QWidget *parent)
         : QOpenGLWidget(parent),
-          hdrTexture(nullptr),
           envCubemap(nullptr),
           irradianceMap(nullptr),
           prefilterMap(nullptr),
           debugTexture(nullptr),
           debugSkybox_texture(nullptr),
           brdfLUTTexture(nullptr),
-          captureFBO(nullptr),
-          cubeGeometry(nullptr),
           skybox_geometry(nullptr),
           sphereGeometry(nullptr),
           QuadGeometry(nullptr),
@@ -27,7 +24,7 @@ MainWidget::MainWidget(QWidget *parent)
     // Create two shader program
     // the first one use for offscreen rendering
     // the second for default framebuffer rendering
-    for (int i=0; i<7; i++) {
+    for (int i=0; i<3; i++) {
         programs.push_back(new QOpenGLShaderProgram(this));
     }
 
@@ -62,18 +59,24 @@ void MainWidget::initializeGL() {
     glSetting();
     initGeometry();
 
-    captureFBO = createFBOPointer(0);
-    renderEnvCubeMap(512);
-    renderIrradianceMap(128);
-    renderPrefilterMap(128);
-    renderBRDFMap(512);
+    // environment, irradiance, prefiltered map and BRDF LUT, straight from the cache after the first run
+    IBLMaps maps = IBLPrecompute().load("src/texture/HDR/newport_loft.hdr");
+    // empty when the HDR cannot be read
+    if (maps.envCubemap == nullptr)
+        close();
+    envCubemap = maps.envCubemap;
+    irradianceMap = maps.irradianceMap;
+    prefilterMap = maps.prefilterMap;
+    brdfLUTTexture = maps.brdfLUTTexture;
 }
 
 void MainWidget::paintGL() {
 
+    textureStreamer->collect();
+
     QOpenGLFramebufferObject::bindDefault();
 
-    SHADER(3)->bind();
+    SHADER(0)->bind();
     glClearColor(0.15f, 0.15f, 0.15f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glEnable(GL_DEPTH_TEST);
@@ -92,65 +95,65 @@ void MainWidget::paintGL() {
             QVector3D(300.0f, 300.0f, 300.0f)
     };
 
-    SHADER(3)->setUniformValue("camPos", camera->getCameraPosition());
+    SHADER(0)->setUniformValue("camPos", camera->getCameraPosition());
 
     glActiveTexture(GL_TEXTURE0);
-    SHADER(3)->setUniformValue("irradianceMap", 0);
+    SHADER(0)->setUniformValue("irradianceMap", 0);
     irradianceMap->bind();
 
     glActiveTexture(GL_TEXTURE1);
-    SHADER(3)->setUniformValue("prefilterMap", 1);
+    SHADER(0)->setUniformValue("prefilterMap", 1);
     prefilterMap->bind();
 
     glActiveTexture(GL_TEXTURE2);
-    SHADER(3)->setUniformValue("brdfLUT", 2);
+    SHADER(0)->setUniformValue("brdfLUT", 2);
     brdfLUTTexture->bind();
 
     for (int i=0; i<lightPositions.count(); i++) {
         QString lightPos = QString("lightPositions[") + QString::number(i) + QString("]");
         QString lightCol =QString("lightColors[") + QString::number(i) + QString("]");
-        SHADER(3)->setUniformValue(lightPos.toStdString().c_str(), lightPositions[i]);
-        SHADER(3)->setUniformValue(lightCol.toStdString().c_str(), lightColors[i]);
+        SHADER(0)->setUniformValue(lightPos.toStdString().c_str(), lightPositions[i]);
+        SHADER(0)->setUniformValue(lightCol.toStdString().c_str(), lightColors[i]);
     }
 
-    SHADER(3)->bind();
+    SHADER(0)->bind();
     model.setToIdentity();
     model.rotate(75,0,1,0);
 
     glActiveTexture(GL_TEXTURE3);
-    SHADER(3)->setUniformValue("albedoMap", 3);
+    SHADER(0)->setUniformValue("albedoMap", 3);
     albedo_textures[0]->bind();
 
     glActiveTexture(GL_TEXTURE4);
-    SHADER(3)->setUniformValue("metallicMap", 4);
+    SHADER(0)->setUniformValue("metallicMap", 4);
     metallic_textures[0]->bind();
 
     glActiveTexture(GL_TEXTURE5);
-    SHADER(3)->setUniformValue("roughnessMap", 5);
+    SHADER(0)->setUniformValue("roughnessMap", 5);
     roughness_textures[0]->bind();
 
     glActiveTexture(GL_TEXTURE6);
-    SHADER(3)->setUniformValue("aoMap", 6);
+    SHADER(0)->setUniformValue("aoMap", 6);
     ao_textures[0]->bind();
 
     glActiveTexture(GL_TEXTURE7);
-    SHADER(3)->setUniformValue("normalMap", 7);
+    SHADER(0)->setUniformValue("normalMap", 7);
     normal_textures[0]->bind();
 
     customGeometry->drawGeometry(
-            SHADER(3),
+            SHADER(0),
             model,
             camera->getCameraView(),
             camera->getCameraProjection());
 
     // Render background
-    SHADER(5)->bind();
+    SHADER(1)->bind();
     glActiveTexture(GL_TEXTURE0);
-    SHADER(5)->setUniformValue("map", 0);
+    SHADER(1)->setUniformValue("map", 0);
     envCubemap->bind();
     glDepthFunc(GL_LEQUAL);
     skybox_geometry->drawGeometry(
-            SHADER(5),
+            SHADER(1),
             camera->getCameraView(),
             camera->getCameraProjection());
     envCubemap->release();
@@ -162,173 +165,91 @@ void MainWidget::resizeGL(int width, int height) {
     qreal aspect = qreal(width) / qreal(height ? height : 1);
     camera->setCameraPerspective(aspect);
 
-    if (captureFBO != nullptr) {
-        delete captureFBO;
-        captureFBO = nullptr;
-    }
-    captureFBO = createFBOPointer(0);
-
     return QOpenGLWidget::resizeGL(width, height);
 }
 
 void MainWidget::initShaders() {
-    // for cube box
-    if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/16_IBL_Models/shaders/cubemap.vs.glsl"))
+    if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/16_IBL_Models/shaders/pbr.vs.glsl"))
         close();
-    if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/16_IBL_Models/shaders/equirectangular_to_map.fs.glsl"))
+    if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/16_IBL_Models/shaders/pbr.fs.glsl"))
         close();
     if (!SHADER(0)->link())
         close();
     if (!SHADER(0)->bind())
         close();
 
-    // irradiance
-    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/16_IBL_Models/shaders/cubemap.vs.glsl"))
+    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/16_IBL_Models/shaders/background.vs.glsl"))
         close();
-    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/16_IBL_Models/shaders/irradiance_convolution.fs.glsl"))
+    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/16_IBL_Models/shaders/background.fs.glsl"))
         close();
     if (!SHADER(1)->link())
         close();
     if (!SHADER(1)->bind())
         close();
 
-    // prefilter
-    if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/16_IBL_Models/shaders/cubemap.vs.glsl"))
+    // Debug shader
+    if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/ScreenPlane.vs.glsl"))
         close();
-    if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/16_IBL_Models/shaders/prefilter.fs.glsl"))
+    if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/Shaders/ScreenPlane.fs.glsl"))
         close();
     if (!SHADER(2)->link())
         close();
     if (!SHADER(2)->bind())
         close();
-
-    if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/16_IBL_Models/shaders/pbr.vs.glsl"))
-        close();
-    if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/16_IBL_Models/shaders/pbr.fs.glsl"))
-        close();
-    if (!SHADER(3)->link())
-        close();
-    if (!SHADER(3)->bind())
-        close();
-
-    if (!SHADER(4)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/16_IBL_Models/shaders/brdf.vs.glsl"))
-        close();
-    if (!SHADER(4)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/16_IBL_Models/shaders/brdf.fs.glsl"))
-        close();
-    if (!SHADER(4)->link())
-        close();
-    if (!SHADER(4)->bind())
-        close();
-
-    if (!SHADER(5)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/16_IBL_Models/shaders/background.vs.glsl"))
-        close();
-    if (!SHADER(5)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/16_IBL_Models/shaders/background.fs.glsl"))
-        close();
-    if (!SHADER(5)->link())
-        close();
-    if (!SHADER(5)->bind())
-        close();
-
-    // Debug shader
-    if (!SHADER(6)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/ScreenPlane.vs.glsl"))
-        close();
-    if (!SHADER(6)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/Shaders/ScreenPlane.fs.glsl"))
-        close();
-    if (!SHADER(6)->link())
-        close();
-    if (!SHADER(6)->bind())
-        close();
 }
 
 void MainWidget::initGeometry() {
-    cubeGeometry = new CubeGeometry;
-    cubeGeometry->initGeometry();
-    cubeGeometry->setupAttributePointer(SHADER(0));
-
     sphereGeometry = new SphereGeometry;
     sphereGeometry->initGeometry();
-    sphereGeometry->setupAttributePointer(SHADER(3));
+    sphereGeometry->setupAttributePointer(SHADER(0));
 
     QuadGeometry = new RectangleGeometry;
     QuadGeometry->initGeometry();
-    QuadGeometry->setupAttributePointer(SHADER(4));
+    QuadGeometry->setupAttributePointer(SHADER(2));
 
     skybox_geometry = new SkyboxGeometry;
     skybox_geometry->initGeometry();
-    skybox_geometry->setupAttributePointer(SHADER(5));
+    skybox_geometry->setupAttributePointer(SHADER(1));
 
     customGeometry = new CustomGeometry(QString("src/resource/Cerberus_by_Andrew_Maximov/Cerberus_LP.FBX"));
     customGeometry = new CustomGeometry(QString("src/resource/Cerberus_by_Andrew_Maximov/Cerberus_LP.FBX"));
     customGeometry->initGeometry();
-    customGeometry->setupAttributePointer(SHADER(3));
+    customGeometry->setupAttributePointer(SHADER(0));
 }
 
 void MainWidget::initTexture() {
     debugTexture = new QOpenGLTexture(QImage(QString("src/texture/wall.jpg")).mirrored(false, true));
 
-    loadHDRTextrue();
     loadMaterialTextures();
-    generateEnvCubeMap(512);
-    generateIrradianceMap(128);
-    generatePrefilterMap(128);
-    generateBRDFMap(512);
 }
 
 void MainWidget::loadMaterialTextures() {
-    for (const auto& alebdoFilePath : albedoTextureFilePath) {
-        auto* alebdoTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
-        auto imageData = QImage(alebdoFilePath).convertToFormat(QImage::Format_RGBA8888);
-
-        alebdoTexture->create();
-        alebdoTexture->setSize(imageData.width(), imageData.height(), imageData.depth());
-        alebdoTexture->setFormat(QOpenGLTexture::SRGB8); // gamma correct
-        alebdoTexture->setMipLevels(alebdoTexture->maximumMipLevels());
-        alebdoTexture->allocateStorage();
-        alebdoTexture->bind();
-
-        alebdoTexture->setData(0, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, imageData.constBits());
-        alebdoTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
-        alebdoTexture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-        alebdoTexture->setMagnificationFilter(QOpenGLTexture::Linear);
-        alebdoTexture->generateMipMaps();
-
-        albedo_textures << alebdoTexture;
-    }
+    // decoded and uploaded in the background, a new frame is asked for whenever one is ready;
+    // block compressed, the first run writes the caches next to the images
+    textureStreamer = new TextureStreamer(this);
+    connect(textureStreamer, &TextureStreamer::textureReady, this, QOverload<>::of(&MainWidget::update));
 
-    for (const auto& metalicFilePath : metalTextureFilePath) {
-        metallic_textures << new QOpenGLTexture(QImage(metalicFilePath));
-    }
+    // sized once, the streamer swaps the textures in through their addresses
+    albedo_textures.resize(albedoTextureFilePath.count());
+    metallic_textures.resize(metalTextureFilePath.count());
+    roughness_textures.resize(roughnessTextureFilePath.count());
+    ao_textures.resize(aoTextureFilePath.count());
+    normal_textures.resize(normalTextureFilePath.count());
 
-    for (const auto& roughnessFilePath : roughnessTextureFilePath) {
-        roughness_textures << new QOpenGLTexture(QImage(roughnessFilePath));
-    }
+    for (int i = 0; i < albedo_textures.count(); i++)
+        textureStreamer->load(&albedo_textures[i], albedoTextureFilePath[i], QOpenGLTexture::SRGB_DXT1, QOpenGLTexture::ClampToEdge); // gamma correct
 
-    for (const auto& aoFilePath : aoTextureFilePath) {
-        ao_textures << new QOpenGLTexture(QImage(aoFilePath));
-    }
+    for (int i = 0; i < metallic_textures.count(); i++)
+        textureStreamer->load(&metallic_textures[i], metalTextureFilePath[i], QOpenGLTexture::R_ATI1N_UNorm, QOpenGLTexture::Repeat, Qt::black);
 
-    for (const auto& normalFilePath : normalTextureFilePath) {
-        normal_textures << new QOpenGLTexture(QImage(normalFilePath));
-    }
-}
+    for (int i = 0; i < roughness_textures.count(); i++)
+        textureStreamer->load(&roughness_textures[i], roughnessTextureFilePath[i], QOpenGLTexture::R_ATI1N_UNorm);
 
-void MainWidget::loadHDRTextrue() {
-    int width, height, channels;
-    stbi_set_flip_vertically_on_load(true);
-    float *image = stbi_loadf("src/texture/HDR/newport_loft.hdr", &width, &height, &channels, 0);
+    for (int i = 0; i < ao_textures.count(); i++)
+        textureStreamer->load(&ao_textures[i], aoTextureFilePath[i], QOpenGLTexture::R_ATI1N_UNorm, QOpenGLTexture::Repeat, Qt::white);
 
-    hdrTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
-    hdrTexture->create();
-    hdrTexture->setSize(width, height, channels);
-    hdrTexture->setFormat(QOpenGLTexture::RGB32F);
-    hdrTexture->allocateStorage();
-
-    hdrTexture->setData(0,0,QOpenGLTexture::RGB,QOpenGLTexture::Float32, image,Q_NULLPTR);
-    hdrTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
-    hdrTexture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    hdrTexture->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
-
-    stbi_image_free(image);
+    for (int i = 0; i < normal_textures.count(); i++)
+        textureStreamer->load(&normal_textures[i], normalTextureFilePath[i], QOpenGLTexture::RG_ATI2N_UNorm, QOpenGLTexture::Repeat, QColor(128, 128, 255));
 }
 
 void MainWidget::loadDebugCubeMap() {
@@ -359,188 +280,10 @@ void MainWidget::loadDebugCubeMap() {
     debugSkybox_texture->generateMipMaps();
 }
 
-void MainWidget::generateEnvCubeMap(int precision) {
-    envCubemap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-    envCubemap->create();
-    envCubemap->setSize(precision, precision, 3);
-    envCubemap->setFormat(QOpenGLTexture::RGB32F);
-    envCubemap->setMipLevels(envCubemap->maximumMipLevels());
-    envCubemap->allocateStorage();
-    envCubemap->bind();
-
-    envCubemap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    envCubemap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    envCubemap->setMagnificationFilter(QOpenGLTexture::Linear);
-}
-
-void MainWidget::generateIrradianceMap(int precision) {
-    irradianceMap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-    irradianceMap->create();
-    irradianceMap->setSize(precision, precision, 3);
-    irradianceMap->setFormat(QOpenGLTexture::RGB32F);
-    irradianceMap->allocateStorage();
-    irradianceMap->bind();
-
-    irradianceMap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    irradianceMap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    irradianceMap->setMagnificationFilter(QOpenGLTexture::Linear);
-}
-
-void MainWidget::generatePrefilterMap(int precision) {
-    prefilterMap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-    prefilterMap->create();
-    prefilterMap->setSize(precision, precision, 3);
-    prefilterMap->setFormat(QOpenGLTexture::RGB32F);
-    prefilterMap->setMipLevels(prefilterMap->maximumMipLevels());
-    prefilterMap->allocateStorage();
-    prefilterMap->bind();
-
-    prefilterMap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    prefilterMap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    prefilterMap->setMagnificationFilter(QOpenGLTexture::Linear);
-    prefilterMap->generateMipMaps();
-}
-
-void MainWidget::generateBRDFMap(int precision) {
-    brdfLUTTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
-    brdfLUTTexture->create();
-    brdfLUTTexture->setSize(precision, precision, 3);
-    brdfLUTTexture->setFormat(QOpenGLTexture::RGB32F);prefilterMap->allocateStorage();
-    brdfLUTTexture->allocateStorage();
-    brdfLUTTexture->bind();
-
-    brdfLUTTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
-    brdfLUTTexture->setMinificationFilter(QOpenGLTexture::Linear);
-    brdfLUTTexture->setMagnificationFilter(QOpenGLTexture::Linear);
-}
-
-void MainWidget::renderEnvCubeMap(int precision) {
-    // rendering
-    SHADER(0)->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(0)->setUniformValue("equirectangularMap", 0);
-    hdrTexture->bind();
-    SHADER(0)->setUniformValue("projection", captureProjection);
-
-    glViewport(0, 0, precision * devicePixelRatio(), precision * devicePixelRatio());
-    captureFBO->bind();
-    for(int i=0; i<captureViews.count(); ++i) {
-        SHADER(0)->setUniformValue("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap->textureId(), 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        cubeGeometry->drawGeometry(
-                SHADER(0), hdrTexture);
-    }
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-
-    envCubemap->bind();
-    envCubemap->generateMipMaps();
-    envCubemap->release();
-}
-
-void MainWidget::renderIrradianceMap(int precision) {
-    // rendering
-    SHADER(1)->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(1)->setUniformValue("environmentMap", 0);
-    envCubemap->bind();
-    SHADER(1)->setUniformValue("projection", captureProjection);
-
-    glViewport(0, 0, precision * devicePixelRatio(), precision * devicePixelRatio());
-    captureFBO->bind();
-    for(int i=0; i<captureViews.count(); ++i) {
-        SHADER(1)->setUniformValue("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap->textureId(), 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        cubeGeometry->drawGeometry(
-                SHADER(1), envCubemap);
-    }
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-}
-
-void MainWidget::renderPrefilterMap(int precision) {
-    SHADER(2)->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(2)->setUniformValue("environmentMap", 0);
-    envCubemap->bind();
-    SHADER(2)->setUniformValue("projection", captureProjection);
-
-    captureFBO->bind();
-    unsigned int maxMipLevels = prefilterMap->maximumMipLevels();
-    for (unsigned int mip = 0; mip < maxMipLevels; ++mip) {
-        unsigned int mipWidth  = 128 * std::pow(0.5, mip);
-        unsigned int mipHeight = 128 * std::pow(0.5, mip);
-
-        glViewport(0, 0, mipWidth * devicePixelRatio(), mipHeight * devicePixelRatio());
-        float roughness = (float)mip / (float)(maxMipLevels - 1);
-        SHADER(2)->setUniformValue("roughness", roughness);
-        for (int i=0; i<captureViews.count(); ++i) {
-            SHADER(2)->setUniformValue("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap->textureId(), mip);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            cubeGeometry->drawGeometry(
-                    SHADER(2), envCubemap);
-        }
-    }
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-}
-
-void MainWidget::renderBRDFMap(int precision) {
-    SHADER(4)->bind();
-
-    glViewport(0, 0, precision * devicePixelRatio(), precision * devicePixelRatio());
-    captureFBO->bind();
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture->textureId(), 0);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    QuadGeometry->drawGeometry(
-            SHADER(4));
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-}
-
 void MainWidget::glSetting() {
     // Enable depth buffer
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-
-    // Setting
-    captureProjection.setToIdentity();
-    captureProjection.perspective(90.0f, 1.0f, 0.1f, 10.0f);
-
-    QMatrix4x4 lookAt_1;
-    lookAt_1.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(1.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_2;
-    lookAt_2.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(-1.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_3;
-    lookAt_3.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f));
-    QMatrix4x4 lookAt_4;
-    lookAt_4.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f));
-    QMatrix4x4 lookAt_5;
-    lookAt_5.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_6;
-    lookAt_6.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    captureViews << lookAt_1 << lookAt_2 << lookAt_3 << lookAt_4 << lookAt_5 << lookAt_6;
-}
-
-QOpenGLFramebufferObject* MainWidget::createFBOPointer(int sampleCount) {
-    QOpenGLFramebufferObjectFormat format;
-    format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-    format.setInternalTextureFormat(QOpenGLTexture::RGB32F);
-    format.setSamples(sampleCount);
-    format.setMipmap(true);
-
-    QSize frameBufferSize(width() * devicePixelRatio(), height() * devicePixelRatio());
-    return new QOpenGLFramebufferObject(frameBufferSize, format);
 }
 
 void MainWidget::cleanup() {
@@ -549,6 +292,9 @@ void MainWidget::cleanup() {
     // delete programs
     qDeleteAll(programs);
     programs.clear();
+    // before the material textures, it still owns the ones that are not swapped in
+    delete textureStreamer;
+    textureStreamer = nullptr;
     qDeleteAll(albedo_textures);
     albedo_textures.clear();
     qDeleteAll(metallic_textures);
@@ -561,30 +307,24 @@ void MainWidget::cleanup() {
     normal_textures.clear();
 
     delete camera;
-    delete hdrTexture;
     delete envCubemap;
     delete irradianceMap;
     delete prefilterMap;
     delete brdfLUTTexture;
     delete debugTexture;
     delete debugSkybox_texture;
-    delete captureFBO;
-    delete cubeGeometry;
     delete skybox_geometry;
     delete sphereGeometry;
     delete QuadGeometry;
     delete customGeometry;
 
     camera = nullptr;
-    hdrTexture = nullptr;
     envCubemap = nullptr;
     irradianceMap = nullptr;
     prefilterMap = nullptr;
     brdfLUTTexture = nullptr;
     debugTexture = nullptr;
     debugSkybox_texture = nullptr;
-    captureFBO = nullptr;
-    cubeGeometry = nullptr;
     skybox_geometry = nullptr;
     sphereGeometry = nullptr;
     QuadGeometry = nullptr;
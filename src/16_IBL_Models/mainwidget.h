@@ -13,10 +13,11 @@
 #include <QDebug>
 
 #include "Helper/Camera.h"
-#include "Helper/CubeGeometry.h"
 #include "Helper/SkyboxGeometry.h"
 #include "Helper/SphereGeometry.h"
 #include "Helper/RectangleGeometry.h"
+#include "Helper/IBLPrecompute.h"
+#include "Helper/TextureStreamer.h"
 #include "Helper/CustomGeometry.h"
 
 #ifndef DEBUG
@@ -24,7 +25,6 @@
 #endif
 
 class Camera;
-class CubeGeometry;
 class SkyboxGeometry;
 class SphereGeometry;
 class RectangleGeometry;
@@ -52,21 +52,10 @@ protected:
     void initTexture();
 
     void glSetting();
-    void loadHDRTextrue();
     void loadDebugCubeMap();
-    void generateEnvCubeMap(int precision);
-    void generateIrradianceMap(int precision);
-    void generatePrefilterMap(int precision);
-    void generateBRDFMap(int precision);
-    void renderEnvCubeMap(int precision);
-    void renderIrradianceMap(int precision);
-    void renderPrefilterMap(int precision);
-    void renderBRDFMap(int precision);
 
     void loadMaterialTextures();
 
-    QOpenGLFramebufferObject* createFBOPointer(int sampleCount=0);
-
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
@@ -74,7 +63,6 @@ protected:
 
 private:
     QList<QOpenGLShaderProgram *> programs;
-    QOpenGLTexture *hdrTexture;
     QOpenGLTexture *envCubemap;
     QOpenGLTexture *debugSkybox_texture;
     QOpenGLTexture *irradianceMap;
@@ -82,7 +70,6 @@ private:
     QOpenGLTexture *brdfLUTTexture;
     QOpenGLTexture *debugTexture;
 
-    CubeGeometry *cubeGeometry;
     SkyboxGeometry *skybox_geometry;
     SphereGeometry *sphereGeometry;
     RectangleGeometry *QuadGeometry;
@@ -92,8 +79,6 @@ private:
     QMatrix4x4 model;
     QPoint mousePos;
 
-    QOpenGLFramebufferObject *captureFBO;
-
     QList<QString> faces{
             QString("src/texture/CubeMap/CubeMap/right.jpg"),
             QString("src/texture/CubeMap/CubeMap/left.jpg"),
@@ -103,10 +88,10 @@ private:
             QString("src/texture/CubeMap/CubeMap/back.jpg"),
     };
 
-    QMatrix4x4 captureProjection;
-    QVector<QMatrix4x4> captureViews;
-
     // albedo texture
+    // the material textures stream in, placeholders until then
+    TextureStreamer *textureStreamer = nullptr;
+
     QList<QOpenGLTexture*> albedo_textures;
     QList<QString> albedoTextureFilePath{
             QString("src/resource/Cerberus_by_Andrew_Maximov/Textures/Cerberus_A.jpg")
@@ -68,7 +68,9 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
 
 vec3 getNormalFromMap()
 {
-    vec3 tangentNormal = texture(normalMap, coord).xyz * 2.0 - 1.0;
+    // BC5 stores x and y only
+    vec2 normalXY = texture(normalMap, coord).rg * 2.0 - 1.0;
+    vec3 tangentNormal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
 
     vec3 Q1  = dFdx(WorldPos);
     vec3 Q2  = dFdy(WorldPos);
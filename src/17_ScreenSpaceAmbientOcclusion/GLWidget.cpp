@@ -1,6 +1,7 @@
 #include "GLWidget.h"
 #include <QRandomGenerator>
 #include <QKeyEvent>
+#include <algorithm>
 
 #define SHADER(x) programs[x]
 
@@ -11,6 +12,7 @@ GLWidget::GLWidget(QWidget *parent)
           camera(nullptr),
           roomTexture(nullptr),
           gBufferFBO(nullptr),
+          gBufferResolveFBO(nullptr),
           ssaoFBO(nullptr),
           ssaoBlurFBO(nullptr),
           gPositionDepth(nullptr),
@@ -19,12 +21,14 @@ GLWidget::GLWidget(QWidget *parent)
           mask(nullptr),
           ssaoColorBuffer(nullptr),
           ssaoColorBufferBlur(nullptr),
+          ssaoHalf(nullptr),
+          ssaoHalfBlur(nullptr),
           noiseTexture(nullptr) {
 
     // Create two shader program
     // the first one use for offscreen rendering
     // the second for default framebuffer rendering
-    for (int i=0; i<6; i++) {
+    for (int i=0; i<9; i++) {
         programs.push_back(new QOpenGLShaderProgram(this));
     }
 
@@ -33,8 +37,8 @@ GLWidget::GLWidget(QWidget *parent)
     camera->setCameraNearClipPlane(0.1f);
     camera->setCameraFarClipPlane(50.0f);
 
-    gBufferTextures.clear();
-    gBufferTextures.resize(4);
+    // number keys pick the SSAO engine
+    setFocusPolicy(Qt::StrongFocus);
 }
 
 GLWidget::~GLWidget() {
@@ -62,8 +66,11 @@ void GLWidget::initializeGL() {
     generateGBufferTexture(width());
     generateSSAOColorBufferTexture(width());
     generateSSAOColorBufferBlurTexture(width());
+    generateSSAOHalfResolutionTextures(width());
+    generateGTAOHistoryTextures(width());
 
-    gBufferFBO = createGBufferFBOPointer();
+    gBufferFBO = createGBufferFBOPointer(multiSample);
+    gBufferResolveFBO = multiSample ? createGBufferFBOPointer(false) : nullptr;
     ssaoFBO = createSSAOFBOPointer();
     ssaoBlurFBO = createSSAOBlurFBOPointer();
 
@@ -90,6 +97,8 @@ void GLWidget::generateSSAOKernelAndSSAONoise() {
         sample *= scale;
         ssaoKernel.push_back(sample);
     }
+    // any prefix of the kernel covers all of it, the compute path takes as many samples as the radius needs
+    std::shuffle(ssaoKernel.begin(), ssaoKernel.end(), *randomEngine);
 
     for (unsigned int i = 0; i < 16; i++)
     {
@@ -123,58 +132,140 @@ void GLWidget::paintGL() {
     // ----- render gBuffer end ----- //
 
     if (multiSample) {
-        QOpenGLFramebufferObject::bindDefault();
-        getGBufferFBOAttachmentTexture();
+        // into the textures the passes below read
+        QRect rect(QPoint(0, 0), gBufferFBO->size());
+        for (int i = 0; i < 4; i++) {
+            QOpenGLFramebufferObject::blitFramebuffer(
+                    gBufferResolveFBO, rect, gBufferFBO, rect, GL_COLOR_BUFFER_BIT, GL_NEAREST, i, i);
+        }
     }
 
-    // ----- render ssaoFBO start ----- //
-    ssaoFBO->bind();
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    SHADER(2)->bind();
+    if (ssaoEngine == SSAOCompute) {
+        // ----- compute ssao start ----- //
+        SHADER(6)->bind();
 
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(2)->setUniformValue("gPositionDepth", 0);
-    if (multiSample)
-        glBindTexture(GL_TEXTURE_2D, gBufferTextures[0]);
-    else
+        glActiveTexture(GL_TEXTURE0);
+        SHADER(6)->setUniformValue("gPositionDepth", 0);
         glBindTexture(GL_TEXTURE_2D, gPositionDepth->textureId());
 
-    glActiveTexture(GL_TEXTURE1);
-    SHADER(2)->setUniformValue("gNormal", 1);
-    if (multiSample)
-        glBindTexture(GL_TEXTURE_2D, gBufferTextures[1]);
-    else
+        glActiveTexture(GL_TEXTURE1);
+        SHADER(6)->setUniformValue("gNormal", 1);
         glBindTexture(GL_TEXTURE_2D, gNormal->textureId());
 
-    glActiveTexture(GL_TEXTURE2);
-    SHADER(2)->setUniformValue("texNoise", 2);
-    glBindTexture(GL_TEXTURE_2D, noiseTexture->textureId());
+        glActiveTexture(GL_TEXTURE2);
+        SHADER(6)->setUniformValue("texNoise", 2);
+        glBindTexture(GL_TEXTURE_2D, noiseTexture->textureId());
 
-    SHADER(2)->setUniformValueArray(
-            "samples",
-            ssaoKernel.data(),
-            ssaoKernel.count());
+        SHADER(6)->setUniformValueArray(
+                "samples",
+                ssaoKernel.data(),
+                ssaoKernel.count());
+        SHADER(6)->setUniformValue("projection", camera->getCameraProjection());
 
-    SHADER(2)->setUniformValue("projection", camera->getCameraProjection());
+        glBindImageTexture(0, ssaoHalf->textureId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((ssaoHalf->width() + 7) / 8, (ssaoHalf->height() + 7) / 8, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        // ----- compute ssao end ----- //
+    }
+    else if (ssaoEngine == GTAO) {
+        // ----- gtao start ----- //
+        currentGTAOHistory = !currentGTAOHistory;
+        SHADER(8)->bind();
 
-    rectGeometry->drawGeometry(SHADER(2));
-    ssaoFBO->release();
-    // ----- render ssaoFBO end ----- //
+        glActiveTexture(GL_TEXTURE0);
+        SHADER(8)->setUniformValue("gPositionDepth", 0);
+        glBindTexture(GL_TEXTURE_2D, gPositionDepth->textureId());
 
-    // render ssaoFBOBlur start
-    ssaoBlurFBO->bind();
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    SHADER(3)->bind();
+        glActiveTexture(GL_TEXTURE1);
+        SHADER(8)->setUniformValue("gNormal", 1);
+        glBindTexture(GL_TEXTURE_2D, gNormal->textureId());
 
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(3)->setUniformValue("ssaoInput", 0);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer->textureId());
+        glActiveTexture(GL_TEXTURE2);
+        SHADER(8)->setUniformValue("history", 2);
+        glBindTexture(GL_TEXTURE_2D, gtaoHistory[!currentGTAOHistory]->textureId());
+
+        SHADER(8)->setUniformValue("projection", camera->getCameraProjection());
+        SHADER(8)->setUniformValue("inverseView", camera->getCameraView().inverted());
+        SHADER(8)->setUniformValue("previousViewProjection", previousViewProjection);
+        SHADER(8)->setUniformValue("frameIndex", int(frameIndex % 1024));
+
+        QOpenGLTexture *output = gtaoHistory[currentGTAOHistory];
+        glBindImageTexture(0, output->textureId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        glDispatchCompute((output->width() + 7) / 8, (output->height() + 7) / 8, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        // ----- gtao end ----- //
+    }
+
+    if (ssaoEngine != SSAOFragment) {
+        // ----- compute blur start ----- //
+        // depth aware, horizontal at half and vertical up to full resolution
+        SHADER(7)->bind();
 
-    rectGeometry->drawGeometry(SHADER(3));
-    ssaoBlurFBO->release();
-    // render ssaoFBOBlur end
+        glActiveTexture(GL_TEXTURE0);
+        SHADER(7)->setUniformValue("gPositionDepth", 0);
+        glBindTexture(GL_TEXTURE_2D, gPositionDepth->textureId());
+
+        QList<QOpenGLTexture*> blurInput{ssaoEngine == GTAO ? gtaoHistory[currentGTAOHistory] : ssaoHalf, ssaoHalfBlur};
+        QList<QOpenGLTexture*> blurOutput{ssaoHalfBlur, ssaoColorBufferBlur};
+        for (int pass = 0; pass < 2; pass++) {
+            glActiveTexture(GL_TEXTURE1);
+            SHADER(7)->setUniformValue("ssaoInput", 1);
+            glBindTexture(GL_TEXTURE_2D, blurInput[pass]->textureId());
+
+            // ivec2, setUniformValue would send floats
+            glUniform2i(SHADER(7)->uniformLocation("direction"), pass == 0 ? 1 : 0, pass == 0 ? 0 : 1);
+
+            glBindImageTexture(0, blurOutput[pass]->textureId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+            glDispatchCompute((blurOutput[pass]->width() + 7) / 8, (blurOutput[pass]->height() + 7) / 8, 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        }
+        glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        // ----- compute blur end ----- //
+    }
+    else {
+        // ----- render ssaoFBO start ----- //
+        ssaoFBO->bind();
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        SHADER(2)->bind();
+
+        glActiveTexture(GL_TEXTURE0);
+        SHADER(2)->setUniformValue("gPositionDepth", 0);
+        glBindTexture(GL_TEXTURE_2D, gPositionDepth->textureId());
+
+        glActiveTexture(GL_TEXTURE1);
+        SHADER(2)->setUniformValue("gNormal", 1);
+        glBindTexture(GL_TEXTURE_2D, gNormal->textureId());
+
+        glActiveTexture(GL_TEXTURE2);
+        SHADER(2)->setUniformValue("texNoise", 2);
+        glBindTexture(GL_TEXTURE_2D, noiseTexture->textureId());
+
+        SHADER(2)->setUniformValueArray(
+                "samples",
+                ssaoKernel.data(),
+                ssaoKernel.count());
+
+        SHADER(2)->setUniformValue("projection", camera->getCameraProjection());
+
+        rectGeometry->drawGeometry(SHADER(2));
+        ssaoFBO->release();
+        // ----- render ssaoFBO end ----- //
+
+        // render ssaoFBOBlur start
+        ssaoBlurFBO->bind();
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        SHADER(3)->bind();
+
+        glActiveTexture(GL_TEXTURE0);
+        SHADER(3)->setUniformValue("ssaoInput", 0);
+        glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer->textureId());
+
+        rectGeometry->drawGeometry(SHADER(3));
+        ssaoBlurFBO->release();
+        // render ssaoFBOBlur end
+    }
 
     // render default frame buffer
     QOpenGLFramebufferObject::bindDefault();
@@ -184,24 +275,15 @@ void GLWidget::paintGL() {
 
     glActiveTexture(GL_TEXTURE0);
     SHADER(4)->setUniformValue("gPositionDepth", 0);
-    if (multiSample)
-        glBindTexture(GL_TEXTURE_2D, gBufferTextures[0]);
-    else
-        glBindTexture(GL_TEXTURE_2D, gPositionDepth->textureId());
+    glBindTexture(GL_TEXTURE_2D, gPositionDepth->textureId());
 
     glActiveTexture(GL_TEXTURE1);
     SHADER(4)->setUniformValue("gNormal", 1);
-    if (multiSample)
-        glBindTexture(GL_TEXTURE_2D, gBufferTextures[1]);
-    else
-        glBindTexture(GL_TEXTURE_2D, gNormal->textureId());
+    glBindTexture(GL_TEXTURE_2D, gNormal->textureId());
 
     glActiveTexture(GL_TEXTURE2);
     SHADER(4)->setUniformValue("gAlbedo", 2);
-    if (multiSample)
-        glBindTexture(GL_TEXTURE_2D, gBufferTextures[2]);
-    else
-        glBindTexture(GL_TEXTURE_2D, gAlbedo->textureId());
+    glBindTexture(GL_TEXTURE_2D, gAlbedo->textureId());
 
     glActiveTexture(GL_TEXTURE3);
     SHADER(4)->setUniformValue("ssao", 3);
@@ -209,10 +291,7 @@ void GLWidget::paintGL() {
 
     glActiveTexture(GL_TEXTURE4);
     SHADER(4)->setUniformValue("mask", 4);
-    if (multiSample)
-        glBindTexture(GL_TEXTURE_2D, gBufferTextures[3]);
-    else
-        glBindTexture(GL_TEXTURE_2D, mask->textureId());
+    glBindTexture(GL_TEXTURE_2D, mask->textureId());
 
     QVector3D lightPos = QVector3D(2.0, 4.0, -2.0);
     QVector3D lightColor = QVector3D(0.5, 0.5, 0.5);
@@ -228,6 +307,10 @@ void GLWidget::paintGL() {
 
     rectGeometry->drawGeometry(SHADER(4));
 
+    // reprojection of the GTAO history
+    previousViewProjection = camera->getCameraProjection() * camera->getCameraView();
+    frameIndex++;
+
     // Debug
 //    QOpenGLFramebufferObject::bindDefault();
 //
@@ -237,33 +320,10 @@ void GLWidget::paintGL() {
 //
 //    glActiveTexture(GL_TEXTURE0);
 //    SHADER(5)->setUniformValue("map", 0);
-//    glBindTexture(GL_TEXTURE_2D, gBufferTextures[0]);
+//    glBindTexture(GL_TEXTURE_2D, gPositionDepth->textureId());
 //    rectGeometry->drawGeometry(SHADER(5));
 }
 
-void GLWidget::getGBufferFBOAttachmentTexture() {
-    if (gBufferTextures.size() != 4) {
-        gBufferTextures.clear();
-        gBufferTextures.resize(0);
-    }
-
-    QScopedPointer<QOpenGLFramebufferObject> tmpFBO;
-
-    for (int i = 0 ; i < 4; i++) {
-        tmpFBO.reset(new QOpenGLFramebufferObject(gBufferFBO->size()));
-        QOpenGLFramebufferObject::blitFramebuffer(
-                tmpFBO.data(),
-                QRect(0,0,width(),height()),
-                gBufferFBO,
-                QRect(0,0,width(),height()),
-                GL_COLOR_BUFFER_BIT,
-                GL_NEAREST,
-                i,
-                0);
-        gBufferTextures[i] = tmpFBO->takeTexture(0);
-    }
-}
-
 void GLWidget::resizeGL(int width, int height) {
     // Calculate aspect ratio
     qreal aspect = qreal(width) / qreal(height ? height : 1);
@@ -274,6 +334,11 @@ void GLWidget::resizeGL(int width, int height) {
         gBufferFBO = nullptr;
     }
 
+    if (gBufferResolveFBO != nullptr) {
+        delete gBufferResolveFBO;
+        gBufferResolveFBO = nullptr;
+    }
+
     if (ssaoFBO != nullptr) {
         delete ssaoFBO;
         ssaoFBO = nullptr;
@@ -284,7 +349,8 @@ void GLWidget::resizeGL(int width, int height) {
         ssaoBlurFBO = nullptr;
     }
 
-    gBufferFBO = createGBufferFBOPointer();
+    gBufferFBO = createGBufferFBOPointer(multiSample);
+    gBufferResolveFBO = multiSample ? createGBufferFBOPointer(false) : nullptr;
     ssaoFBO = createSSAOFBOPointer();
     ssaoBlurFBO = createSSAOBlurFBOPointer();
 
@@ -345,6 +411,22 @@ void GLWidget::initShaders() {
         close();
     if (!SHADER(5)->bind())
         close();
+
+    // compute ssao and its blur
+    if (!SHADER(6)->addShaderFromSourceFile(QOpenGLShader::Compute, "src/17_ScreenSpaceAmbientOcclusion/Shaders/ssao.cs.glsl"))
+        close();
+    if (!SHADER(6)->link())
+        close();
+
+    if (!SHADER(7)->addShaderFromSourceFile(QOpenGLShader::Compute, "src/17_ScreenSpaceAmbientOcclusion/Shaders/ssaoBlur.cs.glsl"))
+        close();
+    if (!SHADER(7)->link())
+        close();
+
+    if (!SHADER(8)->addShaderFromSourceFile(QOpenGLShader::Compute, "src/17_ScreenSpaceAmbientOcclusion/Shaders/gtao.cs.glsl"))
+        close();
+    if (!SHADER(8)->link())
+        close();
 }
 
 void GLWidget::initGeometry() {
@@ -427,6 +509,40 @@ void GLWidget::generateSSAOColorBufferBlurTexture(int precision) {
     ssaoColorBufferBlur->setMagnificationFilter(QOpenGLTexture::Nearest);
 }
 
+void GLWidget::generateSSAOHalfResolutionTextures(int precision) {
+    ssaoHalf = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    ssaoHalf->create();
+    ssaoHalf->setFormat(QOpenGLTexture::R32F);
+    ssaoHalf->setSize(qMax(1, precision / 2), qMax(1, precision / 2), 1);
+    ssaoHalf->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::Float32);
+    ssaoHalf->setMinificationFilter(QOpenGLTexture::Nearest);
+    ssaoHalf->setMagnificationFilter(QOpenGLTexture::Nearest);
+
+    ssaoHalfBlur = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    ssaoHalfBlur->create();
+    ssaoHalfBlur->setFormat(QOpenGLTexture::R32F);
+    ssaoHalfBlur->setSize(qMax(1, precision / 2), qMax(1, precision / 2), 1);
+    ssaoHalfBlur->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::Float32);
+    ssaoHalfBlur->setMinificationFilter(QOpenGLTexture::Nearest);
+    ssaoHalfBlur->setMagnificationFilter(QOpenGLTexture::Nearest);
+}
+
+void GLWidget::generateGTAOHistoryTextures(int precision) {
+    gtaoHistory.resize(2);
+
+    for (auto & historyTexture : gtaoHistory) {
+        historyTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+        historyTexture->create();
+        historyTexture->setFormat(QOpenGLTexture::RGBA16F);
+        historyTexture->setSize(qMax(1, precision / 2), qMax(1, precision / 2), 1);
+        historyTexture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::Float16);
+        historyTexture->setMinificationFilter(QOpenGLTexture::Nearest);
+        historyTexture->setMagnificationFilter(QOpenGLTexture::Nearest);
+        // no frames in it yet
+        glClearTexImage(historyTexture->textureId(), 0, GL_RGBA, GL_FLOAT, nullptr);
+    }
+}
+
 void GLWidget::generateNoiseTexture() {
     noiseTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
     noiseTexture->create();
@@ -441,29 +557,24 @@ void GLWidget::generateNoiseTexture() {
     noiseTexture->setWrapMode(QOpenGLTexture::Repeat);
 }
 
-QOpenGLFramebufferObject *GLWidget::createGBufferFBOPointer() {
+QOpenGLFramebufferObject *GLWidget::createGBufferFBOPointer(bool multisampled) {
     QOpenGLFramebufferObject *bufferObject;
 
-    if (multiSample) {
+    if (multisampled) {
+        // multisampled renderbuffers in the formats of the textures paintGL resolves them into
         QOpenGLFramebufferObjectFormat format;
         format.setAttachment(QOpenGLFramebufferObject::Depth);
-        format.setTextureTarget(QOpenGLTexture::Target2DMultisample);
+        format.setInternalTextureFormat(QOpenGLTexture::RGBA16F);
         format.setSamples(16);
 
         QSize frameBufferSize(width() * devicePixelRatio(), height() * devicePixelRatio());
         bufferObject = new QOpenGLFramebufferObject(frameBufferSize, format);
 
-        bufferObject->bind();
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, gPositionDepth->textureId(), 0);
-
         bufferObject->addColorAttachment(frameBufferSize, QOpenGLTexture::RGBA16F);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D_MULTISAMPLE, gNormal->textureId(), 0);
-
         bufferObject->addColorAttachment(frameBufferSize, QOpenGLTexture::RGBA8_UNorm);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D_MULTISAMPLE, gAlbedo->textureId(), 0);
-
         bufferObject->addColorAttachment(frameBufferSize, QOpenGLTexture::R8_UNorm);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D_MULTISAMPLE, mask->textureId(), 0);
+
+        bufferObject->bind();
 
         unsigned int attachments[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
         glDrawBuffers(4, attachments);
@@ -541,6 +652,7 @@ void GLWidget::cleanup() {
     delete rectGeometry;
 
     delete gBufferFBO;
+    delete gBufferResolveFBO;
     delete ssaoFBO;
     delete ssaoBlurFBO;
     delete gPositionDepth;
@@ -549,6 +661,10 @@ void GLWidget::cleanup() {
     delete mask;
     delete ssaoColorBuffer;
     delete ssaoColorBufferBlur;
+    delete ssaoHalf;
+    delete ssaoHalfBlur;
+    qDeleteAll(gtaoHistory);
+    gtaoHistory.clear();
     delete noiseTexture;
 
     camera = nullptr;
@@ -557,6 +673,7 @@ void GLWidget::cleanup() {
     roomTexture = nullptr;
 
     gBufferFBO = nullptr;
+    gBufferResolveFBO = nullptr;
     ssaoFBO = nullptr;
     ssaoBlurFBO = nullptr;
 
@@ -566,13 +683,23 @@ void GLWidget::cleanup() {
     mask = nullptr;
     ssaoColorBuffer = nullptr;
     ssaoColorBufferBlur = nullptr;
+    ssaoHalf = nullptr;
+    ssaoHalfBlur = nullptr;
     noiseTexture = nullptr;
 
-    //gBufferTextures.clear();  // got debug error
-
     doneCurrent();
 }
 
+void GLWidget::keyPressEvent(QKeyEvent *event) {
+    switch (event->key()) {
+        case Qt::Key_1: ssaoEngine = SSAOFragment; break;
+        case Qt::Key_2: ssaoEngine = SSAOCompute; break;
+        case Qt::Key_3: ssaoEngine = GTAO; break;
+        default: QOpenGLWidget::keyPressEvent(event); return;
+    }
+    update();
+}
+
 void GLWidget::mousePressEvent(QMouseEvent *event) {
     if (event->button() == Qt::LeftButton && event->modifiers() == Qt::AltModifier) {
         mousePos = event->pos();
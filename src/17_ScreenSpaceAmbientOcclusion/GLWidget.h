@@ -31,6 +31,9 @@ public:
 
     bool zoomInProcessing = false;
 
+    // the hemisphere kernel as fragment passes or in compute, or ground truth AO; all write ssaoColorBufferBlur
+    enum SSAOEngine { SSAOFragment, SSAOCompute, GTAO };
+
 protected:
     void initializeGL() override;
     void resizeGL(int width, int height) override;
@@ -42,20 +45,21 @@ protected:
 
     void glSetting();
 
+    void keyPressEvent(QKeyEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override ;
     void wheelEvent(QWheelEvent *event) override;
 
-    QOpenGLFramebufferObject* createGBufferFBOPointer();
+    QOpenGLFramebufferObject* createGBufferFBOPointer(bool multisampled);
     QOpenGLFramebufferObject* createSSAOFBOPointer();
     QOpenGLFramebufferObject* createSSAOBlurFBOPointer();
 
-    void getGBufferFBOAttachmentTexture();
-
     void generateGBufferTexture(int precision);
     void generateSSAOColorBufferTexture(int precision);
     void generateSSAOColorBufferBlurTexture(int precision);
+    void generateSSAOHalfResolutionTextures(int precision);
+    void generateGTAOHistoryTextures(int precision);
     void generateNoiseTexture();
 
     void generateSSAOKernelAndSSAONoise();
@@ -74,13 +78,21 @@ private:
     QMatrix4x4 model;
     QPoint mousePos;
 
-    QOpenGLFramebufferObject *gBufferFBO, *ssaoFBO, *ssaoBlurFBO;
+    // gBufferResolveFBO holds the gBuffer textures when gBufferFBO is multisampled
+    QOpenGLFramebufferObject *gBufferFBO, *gBufferResolveFBO, *ssaoFBO, *ssaoBlurFBO;
     QOpenGLTexture *gPositionDepth, *gNormal, *gAlbedo, *mask, *ssaoColorBuffer, *ssaoColorBufferBlur, *noiseTexture;
+    // compute path: occlusion and its horizontal blur at half resolution
+    QOpenGLTexture *ssaoHalf, *ssaoHalfBlur;
+    // half resolution, ping-ponged: occlusion, frames accumulated, linear depth
+    QVector<QOpenGLTexture*> gtaoHistory;
+    bool currentGTAOHistory = false;
+    QMatrix4x4 previousViewProjection;
+    unsigned int frameIndex = 0;
 
     QVector<QVector3D> ssaoKernel, ssaoNoise;
-    QVector<GLuint> gBufferTextures;
 
     bool multiSample = false;
+    SSAOEngine ssaoEngine = SSAOCompute;
 
 public slots:
     void cleanup();
@@ -0,0 +1,155 @@
+#version 460 core
+
+// ground truth ambient occlusion at half resolution. per pixel a few slices through the view vector, each
+// marched both ways in screen space for the highest horizon, with the cosine weighted visibility between
+// the two horizons integrated in closed form against the normal projected into the slice.
+// slice angle and step offsets change every frame and the result is blended into a reprojected history,
+// so a handful of taps converges over frames. writes occlusion like ssao.cs.glsl, 1 - visibility
+#define PI 3.1415926535897932
+#define HALF_PI 1.5707963267948966
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// occlusion (r), frames in it (g), linear depth it was computed at (b)
+layout (binding = 0, rgba16f) uniform writeonly image2D historyOutput;
+uniform sampler2D history;
+
+uniform sampler2D gPositionDepth;
+uniform sampler2D gNormal;
+
+uniform mat4 projection;
+uniform mat4 inverseView;
+uniform mat4 previousViewProjection;
+uniform int frameIndex;
+
+uniform int sliceCount = 2;
+uniform int stepsPerSlice = 4;
+uniform float radius = 0.5;
+// share of the radius over which a sample's weight fades out
+uniform float falloffRange = 0.615;
+uniform int maxHistory = 16;
+
+// the gBuffer texel a texel of the output stands for
+ivec2 gBufferTexel(ivec2 texel) {
+    return clamp(texel * textureSize(gPositionDepth, 0) / imageSize(historyOutput), ivec2(0), textureSize(gPositionDepth, 0) - 1);
+}
+
+float InterleavedGradientNoise(vec2 position) {
+    return fract(52.9829189 * fract(dot(position, vec2(0.06711056, 0.00583715))));
+}
+
+float VisibilityOfSlices(vec3 viewPos, vec3 normal, ivec2 texel, vec2 uv) {
+    vec3 viewDir = normalize(-viewPos);
+    vec2 gBufferSize = vec2(textureSize(gPositionDepth, 0));
+
+    // the radius in gBuffer texels
+    float screenRadius = radius * projection[1][1] * 0.5 * gBufferSize.y / -viewPos.z;
+    if (screenRadius < 1.0)
+        return 1.0;
+    // the first step leaves the pixel
+    float minStep = 1.0 / screenRadius;
+
+    float falloffMul = -1.0 / (falloffRange * radius);
+    float falloffAdd = (1.0 - falloffRange) / falloffRange + 1.0;
+
+    vec2 frameOffset = vec2(5.588238 * float(frameIndex % 64));
+    float sliceNoise = InterleavedGradientNoise(vec2(texel) + frameOffset);
+    float stepNoise = InterleavedGradientNoise(vec2(texel.yx) + frameOffset + 17.0);
+
+    float visibility = 0.0;
+    for (int slice = 0; slice < sliceCount; slice++) {
+        float phi = (float(slice) + sliceNoise) / float(sliceCount) * PI;
+        vec2 omega = vec2(cos(phi), sin(phi));
+
+        // the slice plane holds the view vector and the direction, screen and view y both point up
+        vec3 direction = vec3(omega, 0.0);
+        vec3 orthoDirection = direction - dot(direction, viewDir) * viewDir;
+        vec3 axis = normalize(cross(orthoDirection, viewDir));
+        vec3 projectedNormal = normal - axis * dot(normal, axis);
+        float projectedNormalLength = length(projectedNormal);
+        if (projectedNormalLength < 0.0001)
+            continue;
+
+        float cosNormal = clamp(dot(projectedNormal, viewDir) / projectedNormalLength, 0.0, 1.0);
+        float n = sign(dot(orthoDirection, projectedNormal)) * acos(cosNormal);
+
+        // start at the tangent plane on either side
+        float lowHorizonCos0 = cos(n + HALF_PI);
+        float lowHorizonCos1 = cos(n - HALF_PI);
+        float horizonCos0 = lowHorizonCos0;
+        float horizonCos1 = lowHorizonCos1;
+
+        for (int i = 0; i < stepsPerSlice; i++) {
+            // denser close to the pixel
+            float s = (float(i) + stepNoise) / float(stepsPerSlice);
+            s = mix(minStep, 1.0, s * s);
+            vec2 offset = omega * s * screenRadius / gBufferSize;
+
+            for (int side = 0; side < 2; side++) {
+                vec2 sampleUV = side == 0 ? uv + offset : uv - offset;
+                if (any(lessThan(sampleUV, vec2(0.0))) || any(greaterThanEqual(sampleUV, vec2(1.0))))
+                    continue;
+                vec4 samplePositionDepth = texture(gPositionDepth, sampleUV);
+                if (samplePositionDepth.w <= 0.0)
+                    continue;
+
+                vec3 delta = samplePositionDepth.xyz - viewPos;
+                float distance = length(delta);
+                float weight = clamp(distance * falloffMul + falloffAdd, 0.0, 1.0);
+                float sampleCos = dot(delta / distance, viewDir);
+
+                if (side == 0)
+                    horizonCos0 = max(horizonCos0, mix(lowHorizonCos0, sampleCos, weight));
+                else
+                    horizonCos1 = max(horizonCos1, mix(lowHorizonCos1, sampleCos, weight));
+            }
+        }
+
+        // horizon angles from the view vector, clamped to the hemisphere of the normal
+        float h0 = -acos(horizonCos1);
+        float h1 = acos(horizonCos0);
+        h0 = n + clamp(h0 - n, -HALF_PI, HALF_PI);
+        h1 = n + clamp(h1 - n, -HALF_PI, HALF_PI);
+
+        float arc0 = (cosNormal + 2.0 * h0 * sin(n) - cos(2.0 * h0 - n)) * 0.25;
+        float arc1 = (cosNormal + 2.0 * h1 * sin(n) - cos(2.0 * h1 - n)) * 0.25;
+        visibility += projectedNormalLength * (arc0 + arc1);
+    }
+
+    return visibility / float(sliceCount);
+}
+
+void main() {
+    ivec2 size = imageSize(historyOutput);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (texel.x >= size.x || texel.y >= size.y)
+        return;
+
+    vec4 positionDepth = texelFetch(gPositionDepth, gBufferTexel(texel), 0);
+    // nothing drawn
+    if (positionDepth.w <= 0.0) {
+        imageStore(historyOutput, texel, vec4(0.0));
+        return;
+    }
+
+    vec3 viewPos = positionDepth.xyz;
+    vec3 normal = normalize(texelFetch(gNormal, gBufferTexel(texel), 0).rgb);
+    vec2 uv = (vec2(gBufferTexel(texel)) + 0.5) / vec2(textureSize(gPositionDepth, 0));
+
+    float occlusion = 1.0 - clamp(VisibilityOfSlices(viewPos, normal, texel, uv), 0.0, 1.0);
+
+    // where this point was last frame, kept when the history there saw the same depth
+    vec4 previousClip = previousViewProjection * (inverseView * vec4(viewPos, 1.0));
+    vec2 previousUV = previousClip.xy / previousClip.w * 0.5 + 0.5;
+    float age = 0.0;
+    float accumulated = occlusion;
+    if (all(greaterThanEqual(previousUV, vec2(0.0))) && all(lessThan(previousUV, vec2(1.0)))) {
+        vec4 previous = texelFetch(history, ivec2(previousUV * vec2(size)), 0);
+        if (abs(previous.b - previousClip.w) < 0.05 * previousClip.w) {
+            age = min(previous.g, float(maxHistory - 1));
+            accumulated = mix(previous.r, occlusion, 1.0 / (age + 1.0));
+        }
+    }
+
+    imageStore(historyOutput, texel, vec4(accumulated, age + 1.0, positionDepth.w, 0.0));
+}
@@ -0,0 +1,89 @@
+#version 460 core
+
+// the hemisphere kernel of ssao.fs.glsl at half resolution, 8x8 texels a group. the group first loads the
+// linear depth around its tile into shared memory, samples landing in there skip the texture fetch.
+// the number of samples follows the size of the kernel on screen: few where it covers a handful of texels
+#define GROUP_SIZE 8
+#define TILE_APRON 8
+#define TILE_SIZE (GROUP_SIZE + 2 * TILE_APRON)
+
+layout (local_size_x = GROUP_SIZE, local_size_y = GROUP_SIZE, local_size_z = 1) in;
+
+layout (binding = 0, r32f) uniform writeonly image2D ssaoOutput;
+
+uniform sampler2D gPositionDepth;
+uniform sampler2D gNormal;
+uniform sampler2D texNoise;
+
+// shuffled, so every prefix spreads over the whole kernel
+uniform vec3 samples[128];
+uniform mat4 projection;
+
+uniform int minKernelSize = 8;
+uniform int maxKernelSize = 64;
+uniform float radius = 0.5;
+uniform float bias = 0.025;
+
+shared float depthTile[TILE_SIZE][TILE_SIZE];
+
+// the gBuffer texel a texel of the output stands for
+ivec2 gBufferTexel(ivec2 texel) {
+    return clamp(texel * textureSize(gPositionDepth, 0) / imageSize(ssaoOutput), ivec2(0), textureSize(gPositionDepth, 0) - 1);
+}
+
+void main() {
+    ivec2 size = imageSize(ssaoOutput);
+    ivec2 tileOrigin = ivec2(gl_WorkGroupID.xy) * GROUP_SIZE - TILE_APRON;
+
+    for (uint i = gl_LocalInvocationIndex; i < TILE_SIZE * TILE_SIZE; i += GROUP_SIZE * GROUP_SIZE) {
+        ivec2 local = ivec2(i % TILE_SIZE, i / TILE_SIZE);
+        depthTile[local.y][local.x] = texelFetch(gPositionDepth, gBufferTexel(tileOrigin + local), 0).w;
+    }
+    barrier();
+
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (texel.x >= size.x || texel.y >= size.y)
+        return;
+
+    vec4 positionDepth = texelFetch(gPositionDepth, gBufferTexel(texel), 0);
+    // nothing drawn
+    if (positionDepth.w <= 0.0) {
+        imageStore(ssaoOutput, texel, vec4(0.0));
+        return;
+    }
+
+    vec3 fragPos = positionDepth.xyz;
+    vec3 normal = normalize(texelFetch(gNormal, gBufferTexel(texel), 0).rgb);
+    vec3 randomVec = texelFetch(texNoise, texel & 3, 0).xyz;
+
+    // create TBN change-of-basis matrix: from tangent-space to view-space
+    vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
+    vec3 bitangent = cross(normal, tangent);
+    mat3 TBN = mat3(tangent, bitangent, normal);
+
+    // the kernel radius in output texels
+    float projectedRadius = radius * projection[1][1] * 0.5 * float(size.y) / -fragPos.z;
+    int kernelSize = clamp(int(projectedRadius), minKernelSize, maxKernelSize);
+
+    float occlusion = 0.0;
+    for (int i = 0; i < kernelSize; ++i) {
+        vec3 samplePos = fragPos + TBN * samples[i] * radius;
+
+        vec4 offset = projection * vec4(samplePos, 1.0);
+        vec2 uv = offset.xy / offset.w * 0.5 + 0.5;
+        // off screen occludes nothing
+        if (any(lessThan(uv, vec2(0.0))) || any(greaterThanEqual(uv, vec2(1.0))))
+            continue;
+
+        ivec2 sampleTexel = ivec2(uv * vec2(size));
+        ivec2 local = sampleTexel - tileOrigin;
+        float sampleDepth = all(greaterThanEqual(local, ivec2(0))) && all(lessThan(local, ivec2(TILE_SIZE))) ?
+                            depthTile[local.y][local.x] : texelFetch(gPositionDepth, gBufferTexel(sampleTexel), 0).w;
+        sampleDepth = -sampleDepth;
+
+        float rangeCheck = smoothstep(0.0, 1.0, radius / abs(fragPos.z - sampleDepth));
+        occlusion += (sampleDepth >= samplePos.z + bias ? 1.0 : 0.0) * rangeCheck;
+    }
+
+    imageStore(ssaoOutput, texel, vec4(occlusion / float(kernelSize)));
+}
@@ -0,0 +1,47 @@
+#version 460 core
+
+// one direction of the separable blur of ssao.cs.glsl. taps are weighted by a gaussian and by how close
+// their linear depth is to the one of the texel written, so occlusion does not bleed over silhouettes.
+// the output may be larger than the input, the vertical pass writes straight to full resolution
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout (binding = 0, r32f) uniform writeonly image2D blurOutput;
+
+uniform sampler2D ssaoInput;
+uniform sampler2D gPositionDepth;
+
+uniform ivec2 direction;
+// relative depth difference that costs a tap ~63% of its weight
+uniform float depthTolerance = 0.05;
+
+const int blurRadius = 4;
+const float sigma = 2.0;
+
+float linearDepth(ivec2 texel, ivec2 size) {
+    ivec2 gBufferSize = textureSize(gPositionDepth, 0);
+    return texelFetch(gPositionDepth, clamp(texel * gBufferSize / size, ivec2(0), gBufferSize - 1), 0).w;
+}
+
+void main() {
+    ivec2 size = imageSize(blurOutput);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (texel.x >= size.x || texel.y >= size.y)
+        return;
+
+    ivec2 inputSize = textureSize(ssaoInput, 0);
+    ivec2 center = texel * inputSize / size;
+    float depth = linearDepth(texel, size);
+
+    float result = 0.0;
+    float weightSum = 0.0;
+    for (int i = -blurRadius; i <= blurRadius; i++) {
+        ivec2 tap = clamp(center + direction * i, ivec2(0), inputSize - 1);
+        float depthWeight = exp(-abs(linearDepth(tap, inputSize) - depth) / (depthTolerance * max(depth, 0.0001)));
+        float weight = exp(-float(i * i) / (2.0 * sigma * sigma)) * depthWeight;
+
+        result += texelFetch(ssaoInput, tap, 0).r * weight;
+        weightSum += weight;
+    }
+
+    imageStore(blurOutput, texel, vec4(result / max(weightSum, 0.0001)));
+}
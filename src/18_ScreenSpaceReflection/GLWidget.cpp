@@ -1,6 +1,7 @@
 #include "GLWidget.h"
 #include <QKeyEvent>
 #include <QRandomGenerator>
+#include <cstring>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -9,14 +10,11 @@
 
 GLWidget::GLWidget(QWidget *parent)
         : QOpenGLWidget(parent),
-          hdrTexture(nullptr),
           envCubeMap(nullptr),
           irradianceMap(nullptr),
           prefilterMap(nullptr),
           BRDFMap(nullptr),
-          captureFBO(nullptr),
           gBuffer(nullptr),
-          cubeGeometry(nullptr),
           skyboxGeometry(nullptr),
           rectGeometry(nullptr),
           camera(nullptr),
@@ -27,7 +25,7 @@ GLWidget::GLWidget(QWidget *parent)
     // Create two shader program
     // the first one use for offscreen rendering
     // the second for default framebuffer rendering
-    for (int i=0; i<12; i++) {
+    for (int i=0; i<11; i++) {
         programs.push_back(new QOpenGLShaderProgram(this));
     }
 
@@ -36,6 +34,9 @@ GLWidget::GLWidget(QWidget *parent)
     camera->setCameraNearClipPlane(0.01);
     camera->setCameraFarClipPlane(1000.0);
 
+    // number keys pick the SSR quality
+    setFocusPolicy(Qt::StrongFocus);
+
     // ----- Init PreFrame ----- //
     preViewMatrix = camera->getCameraView();
 }
@@ -66,19 +67,27 @@ void GLWidget::initializeGL() {
     glSetting();
     initGeometry();
 
-    captureFBO = createFBOPointer(0);
     gBuffer    = createGBufferFBOPointer();
     pbrBuffer  = createSimpleFBOPointer();
     createSSRFBOPointer();
     compositeBuffer = createSimpleFBOPointer();
     createTAAFBOPointer();
 
-    renderEnvCubeMap(512);
-    renderIrradianceMap(128);
-    renderPrefilterMap(128);
-    renderBRDFMap(512);
-
-    myTimer.start();
+    // environment, irradiance, prefiltered map and BRDF LUT, straight from the cache after the first run
+    IBLMaps maps = IBLPrecompute().load("src/texture/HDR/newport_loft.hdr");
+    // empty when the HDR cannot be read
+    if (maps.envCubemap == nullptr)
+        close();
+    envCubeMap = maps.envCubemap;
+    irradianceMap = maps.irradianceMap;
+    prefilterMap = maps.prefilterMap;
+    BRDFMap = maps.brdfLUTTexture;
+
+    // trace, accumulate and upsample of the SSR pass
+    ssrTimer = new QOpenGLTimeMonitor(this);
+    ssrTimer->setSampleCount(4);
+    if (!ssrTimer->create())
+        qDebug() << "ERROR::SSR:: GPU timer queries are not available";
 }
 
 void GLWidget::paintGL() {
@@ -92,106 +101,85 @@ void GLWidget::paintGL() {
     bool renderDebugBackground = false;
     bool renderBackDrop = true;
 
-    float spacing = 8.0;
-    int nrColumns = 4;
-    QVector3D BackDropTr = QVector3D(0.0f, -3.5f, 0.0f);
-
     static QRandomGenerator *randomEngine = QRandomGenerator::global();
     static std::uniform_real_distribution<float> random(0, 1);
     QVector2D randomSeed = QVector2D(random(*randomEngine), random(*randomEngine));
 
+    textureStreamer->collect();
+
     // Render gBuffer
     if (renderGBuffer) {
+        // once, the SSR trace marches the depth pyramid built from it instead of a scene drawn into every mip level
         gBuffer->bind();
-
-        unsigned int maxMipLevels = gAlbedoSpec->maximumMipLevels();
-        for (unsigned int mip = 0; mip < maxMipLevels; ++mip) {
-            unsigned int mipWidth = width() * std::pow(0.5, mip);
-            unsigned int mipHeight = height() * std::pow(0.5, mip);
-
-            glViewport(0, 0, mipWidth * devicePixelRatio(), mipHeight * devicePixelRatio());
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gAlbedoSpec->textureId(), mip);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gExpensiveNormal->textureId(), mip);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gDepth->textureId(), mip);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, gExtraComponents->textureId(), mip);
+        {
+            glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
 
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            // nothing drawn is as far as it gets
+            const GLfloat farDepth[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+            glClearBufferfv(GL_COLOR, 2, farDepth);
             glEnable(GL_DEPTH_TEST);
 
-            SHADER(7)->bind();
+            // material grid and backdrop read model matrix and material layer from the instance buffer
+            SHADER(3)->bind();
             {
-                for (int col = 0; col < nrColumns; col++) {
-                    model.setToIdentity();
-                    model.translate((col - (nrColumns / 2.0) + 0.5f) * spacing,
-                                    0.005f,
-                                    0.0f);
-                    model.scale(3.5f);
-
-                    glActiveTexture(GL_TEXTURE0);
-                    SHADER(7)->setUniformValue("albedoMap", 0);
-                    albedo_textures[col]->bind();
-
-                    glActiveTexture(GL_TEXTURE1);
-                    SHADER(7)->setUniformValue("roughnessMap", 1);
-                    roughness_textures[col]->bind();
-
-                    glActiveTexture(GL_TEXTURE2);
-                    SHADER(7)->setUniformValue("normalMap", 2);
-                    normal_textures[col]->bind();
-
-                    glActiveTexture(GL_TEXTURE3);
-                    SHADER(7)->setUniformValue("metallicMap", 3);
-                    metallic_textures[col]->bind();
-
-                    glActiveTexture(GL_TEXTURE4);
-                    SHADER(7)->setUniformValue("skybox", 4);
-                    envCubeMap->bind();
-
-                    SHADER(7)->setUniformValue("PrevModel", model);
-                    SHADER(7)->setUniformValue("PrevView", preViewMatrix);
-                    SHADER(7)->setUniformValue("viewPos", camera->getCameraPosition());
-
-                    ShaderBall->drawGeometry(
-                            SHADER(7),
-                            model,
-                            camera->getCameraView(),
-                            camera->getCameraProjection());
-                }
+                glActiveTexture(GL_TEXTURE0);
+                SHADER(3)->setUniformValue("albedoMap", 0);
+                albedoTextureArray->bind();
+
+                glActiveTexture(GL_TEXTURE1);
+                SHADER(3)->setUniformValue("roughnessMap", 1);
+                roughnessTextureArray->bind();
+
+                glActiveTexture(GL_TEXTURE2);
+                SHADER(3)->setUniformValue("normalMap", 2);
+                normalTextureArray->bind();
+
+                glActiveTexture(GL_TEXTURE3);
+                SHADER(3)->setUniformValue("metallicMap", 3);
+                metallicTextureArray->bind();
+
+                glActiveTexture(GL_TEXTURE4);
+                SHADER(3)->setUniformValue("skybox", 4);
+                envCubeMap->bind();
+
+                SHADER(3)->setUniformValue("PrevView", preViewMatrix);
+                SHADER(3)->setUniformValue("viewPos", camera->getCameraPosition());
+
+                ShaderBall->drawGeometryInstanced(
+                        SHADER(3),
+                        camera->getCameraView(),
+                        camera->getCameraProjection(),
+                        MATERIAL_BALL_COLUMNS);
                 if (renderBackDrop) {
-                    model.setToIdentity();
-                    model.translate(BackDropTr);
-                    model.scale(30.0f);
-
-                    BackDrop->drawGeometry(
-                            SHADER(7),
-                            model,
+                    BackDrop->drawGeometryInstanced(
+                            SHADER(3),
                             camera->getCameraView(),
-                            camera->getCameraProjection());
+                            camera->getCameraProjection(),
+                            1,
+                            MATERIAL_BALL_COLUMNS);
                 }
             }
         }
 
         gBuffer->release();
+
+        buildHiZBuffer();
     }
 
     // Render PBR
     if (renderPBRBuffer) {
         pbrBuffer->bind();
-
-        unsigned int maxMipLevels = bprColorTexture->maximumMipLevels();
-        for (unsigned int mip = 0; mip < maxMipLevels; ++mip) {
-            unsigned int mipWidth = width() * std::pow(0.5, mip);
-            unsigned int mipHeight = height() * std::pow(0.5, mip);
-
-            glViewport(0, 0, mipWidth * devicePixelRatio(), mipHeight * devicePixelRatio());
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, bprColorTexture->textureId(), mip);
+        {
+            glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, bprColorTexture->textureId(), 0);
 
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
             glEnable(GL_DEPTH_TEST);
 
-            SHADER(6)->bind();
+            SHADER(2)->bind();
             {
                 // Render balls
                 QVector<QVector3D> lightPositions{
@@ -207,66 +195,55 @@ void GLWidget::paintGL() {
                         QVector3D(300.0f, 300.0f, 300.0f)
                 };
 
-                for (int col = 0; col < nrColumns; col++) {
-                    model.setToIdentity();
-                    model.translate((col - (nrColumns / 2.0) + 0.5f) * spacing,
-                                    0.005f,
-                                    0.0f);
-                    model.scale(3.5f);
+                SHADER(2)->setUniformValue("camPos", camera->getCameraPosition());
 
-                    SHADER(6)->setUniformValue("camPos", camera->getCameraPosition());
+                glActiveTexture(GL_TEXTURE0);
+                SHADER(2)->setUniformValue("irradianceMap", 0);
+                irradianceMap->bind();
 
-                    glActiveTexture(GL_TEXTURE0);
-                    SHADER(6)->setUniformValue("irradianceMap", 0);
-                    irradianceMap->bind();
+                glActiveTexture(GL_TEXTURE1);
+                SHADER(2)->setUniformValue("prefilterMap", 1);
+                prefilterMap->bind();
 
-                    glActiveTexture(GL_TEXTURE1);
-                    SHADER(6)->setUniformValue("prefilterMap", 1);
-                    prefilterMap->bind();
+                glActiveTexture(GL_TEXTURE2);
+                SHADER(2)->setUniformValue("brdfLUT", 2);
+                BRDFMap->bind();
 
-                    glActiveTexture(GL_TEXTURE2);
-                    SHADER(6)->setUniformValue("brdfLUT", 2);
-                    BRDFMap->bind();
+                glActiveTexture(GL_TEXTURE3);
+                SHADER(2)->setUniformValue("albedoMap", 3);
+                albedoTextureArray->bind();
 
-                    glActiveTexture(GL_TEXTURE3);
-                    SHADER(6)->setUniformValue("albedoMap", 3);
-                    albedo_textures[col]->bind();
+                glActiveTexture(GL_TEXTURE4);
+                SHADER(2)->setUniformValue("metallicMap", 4);
+                metallicTextureArray->bind();
 
-                    glActiveTexture(GL_TEXTURE4);
-                    SHADER(6)->setUniformValue("metallicMap", 4);
-                    metallic_textures[col]->bind();
+                glActiveTexture(GL_TEXTURE5);
+                SHADER(2)->setUniformValue("roughnessMap", 5);
+                roughnessTextureArray->bind();
 
-                    glActiveTexture(GL_TEXTURE5);
-                    SHADER(6)->setUniformValue("roughnessMap", 5);
-                    roughness_textures[col]->bind();
+                glActiveTexture(GL_TEXTURE6);
+                SHADER(2)->setUniformValue("aoMap", 6);
+                aoTextureArray->bind();
 
-                    glActiveTexture(GL_TEXTURE6);
-                    SHADER(6)->setUniformValue("aoMap", 6);
-                    ao_textures[col]->bind();
+                glActiveTexture(GL_TEXTURE7);
+                SHADER(2)->setUniformValue("normalMap", 7);
+                normalTextureArray->bind();
 
-                    glActiveTexture(GL_TEXTURE7);
-                    SHADER(6)->setUniformValue("normalMap", 7);
-                    normal_textures[col]->bind();
+                SHADER(2)->setUniformValueArray("lightPositions", lightPositions.data(), lightPositions.size());
+                SHADER(2)->setUniformValueArray("lightColors", lightColors.data(), lightColors.size());
 
-                    SHADER(6)->setUniformValueArray("lightPositions", lightPositions.data(), lightPositions.size());
-                    SHADER(6)->setUniformValueArray("lightColors", lightColors.data(), lightColors.size());
-
-                    ShaderBall->drawGeometry(
-                            SHADER(6),
-                            model,
-                            camera->getCameraView(),
-                            camera->getCameraProjection());
-                }
+                ShaderBall->drawGeometryInstanced(
+                        SHADER(2),
+                        camera->getCameraView(),
+                        camera->getCameraProjection(),
+                        MATERIAL_BALL_COLUMNS);
                 if (renderBackDrop) {
-                    model.setToIdentity();
-                    model.translate(BackDropTr);
-                    model.scale(30.0f);
-
-                    BackDrop->drawGeometry(
-                            SHADER(6),
-                            model,
+                    BackDrop->drawGeometryInstanced(
+                            SHADER(2),
                             camera->getCameraView(),
-                            camera->getCameraProjection());
+                            camera->getCameraProjection(),
+                            1,
+                            MATERIAL_BALL_COLUMNS);
                 }
             }
         }
@@ -276,75 +253,154 @@ void GLWidget::paintGL() {
 
     // Render SSR
     if (renderSSRBuffer) {
-        ssrBuffer[CurrentSSR]->bind();
+        // trace and accumulate at the resolution of the quality mode, then back to the gBuffer's.
+        // timed per pass; a frame is only timed once the previous timing has come back, nothing waits on it
+        bool timeSSR = ssrTimer->isCreated() && !ssrTimerPending;
+        if (timeSSR)
+            ssrTimer->recordSample();
 
-        unsigned int maxMipLevels = ssrTexture[CurrentSSR]->maximumMipLevels();
-        for (unsigned int mip = 0; mip < maxMipLevels; ++mip) {
-            unsigned int mipWidth = width() * std::pow(0.5, mip);
-            unsigned int mipHeight = height() * std::pow(0.5, mip);
+        QVector2D LinMAD(
+                (camera->getCameraNearClipPlane() - camera->getCameraFarClipPlane()) / ( 2.0 * camera->getCameraNearClipPlane() * camera->getCameraFarClipPlane()),
+                (camera->getCameraNearClipPlane() + camera->getCameraFarClipPlane()) / ( 2.0 * camera->getCameraNearClipPlane() * camera->getCameraFarClipPlane()));
 
-            glViewport(0, 0, mipWidth * devicePixelRatio(), mipHeight * devicePixelRatio());
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssrTexture[CurrentSSR]->textureId(), mip);
+        ssrBuffer[0]->bind();
+        {
+            glViewport(0, 0, ssrTraceTexture->width(), ssrTraceTexture->height());
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssrTraceTexture->textureId(), 0);
 
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
             glDisable(GL_BLEND);
 
-            SHADER(8)->bind();
+            SHADER(4)->bind();
 
             glActiveTexture(GL_TEXTURE0);
-            SHADER(8)->setUniformValue("gFinalImage", 0);
+            SHADER(4)->setUniformValue("gFinalImage", 0);
             bprColorTexture->bind();
 
             glActiveTexture(GL_TEXTURE1);
-            SHADER(8)->setUniformValue("gNormal", 1);
+            SHADER(4)->setUniformValue("gNormal", 1);
             gExpensiveNormal->bind();
 
             glActiveTexture(GL_TEXTURE2);
-            SHADER(8)->setUniformValue("gExtraComponents", 2);
+            SHADER(4)->setUniformValue("gExtraComponents", 2);
             gExtraComponents->bind();
 
             glActiveTexture(GL_TEXTURE3);
-            SHADER(8)->setUniformValue("gDepth", 3);
+            SHADER(4)->setUniformValue("gDepth", 3);
             gDepth->bind();
 
             glActiveTexture(GL_TEXTURE4);
-            SHADER(8)->setUniformValue("BRDF", 4);
+            SHADER(4)->setUniformValue("BRDF", 4);
             BRDFMap->bind();
 
-            glActiveTexture(GL_TEXTURE4);
-            SHADER(8)->setUniformValue("noiseTexture", 4);
-            noiseTexture->bind();
-
             glActiveTexture(GL_TEXTURE5);
-            SHADER(8)->setUniformValue("PreviousReflection", 5);
-            ssrTexture[!CurrentSSR]->bind();
+            SHADER(4)->setUniformValue("noiseTexture", 5);
+            noiseTexture->bind();
 
             glActiveTexture(GL_TEXTURE6);
-            SHADER(8)->setUniformValue("gAlbedo", 6);
+            SHADER(4)->setUniformValue("gAlbedo", 6);
             gAlbedoSpec->bind();
 
-            SHADER(8)->setUniformValue("view", camera->getCameraView());
-            SHADER(8)->setUniformValue("projection", camera->getCameraProjection());
-            SHADER(8)->setUniformValue("camPos", camera->getCameraPosition());
-            SHADER(8)->setUniformValue("Resolution", QVector2D(width(), height()));
+            glActiveTexture(GL_TEXTURE7);
+            SHADER(4)->setUniformValue("hiZBuffer", 7);
+            hiZTexture->bind();
+
+            SHADER(4)->setUniformValue("view", camera->getCameraView());
+            SHADER(4)->setUniformValue("projection", camera->getCameraProjection());
+            SHADER(4)->setUniformValue("camPos", camera->getCameraPosition());
+            SHADER(4)->setUniformValue("Resolution", QVector2D(ssrTraceTexture->width(), ssrTraceTexture->height()));
+            SHADER(4)->setUniformValue("LinMAD", LinMAD);
+            SHADER(4)->setUniformValue("frameIndex", int(frameIndex % 1024));
+
+            rectGeometry->drawGeometry(SHADER(4));
+        }
+        ssrBuffer[0]->release();
+
+        if (timeSSR)
+            ssrTimer->recordSample();
+
+        // temporal accumulation into the history
+        ssrBuffer[1]->bind();
+        {
+            glViewport(0, 0, ssrTexture[CurrentSSR]->width(), ssrTexture[CurrentSSR]->height());
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssrTexture[CurrentSSR]->textureId(), 0);
 
-            QVector2D LinMAD(
-                    (camera->getCameraNearClipPlane() - camera->getCameraFarClipPlane()) / ( 2.0 * camera->getCameraNearClipPlane() * camera->getCameraFarClipPlane()),
-                    (camera->getCameraNearClipPlane() + camera->getCameraFarClipPlane()) / ( 2.0 * camera->getCameraNearClipPlane() * camera->getCameraFarClipPlane()));
-            SHADER(8)->setUniformValue("LinMAD", LinMAD);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            SHADER(9)->bind();
 
-            float time = (float)myTimer.elapsed() * 1.0 / 1000.0;
-            SHADER(8)->setUniformValue("Time", time);
+            glActiveTexture(GL_TEXTURE0);
+            SHADER(9)->setUniformValue("currentReflection", 0);
+            ssrTraceTexture->bind();
 
-            SHADER(8)->setUniformValue("ID", TotalFrames);
-            SHADER(8)->setUniformValue("isMoving", isMoving);
+            glActiveTexture(GL_TEXTURE1);
+            SHADER(9)->setUniformValue("historyReflection", 1);
+            ssrTexture[!CurrentSSR]->bind();
 
-            rectGeometry->drawGeometry(SHADER(8));
+            glActiveTexture(GL_TEXTURE2);
+            SHADER(9)->setUniformValue("gExtraComponents", 2);
+            gExtraComponents->bind();
+
+            rectGeometry->drawGeometry(SHADER(9));
+        }
+        ssrBuffer[1]->release();
+
+        if (timeSSR)
+            ssrTimer->recordSample();
+
+        // bilateral upsample
+        if (ssrQuality != SSRFull) {
+            ssrBuffer[0]->bind();
+
+            glViewport(0, 0, ssrUpsampledTexture->width(), ssrUpsampledTexture->height());
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssrUpsampledTexture->textureId(), 0);
+
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            SHADER(10)->bind();
+
+            glActiveTexture(GL_TEXTURE0);
+            SHADER(10)->setUniformValue("reflection", 0);
+            ssrTexture[CurrentSSR]->bind();
+
+            glActiveTexture(GL_TEXTURE1);
+            SHADER(10)->setUniformValue("gNormal", 1);
+            gExpensiveNormal->bind();
+
+            glActiveTexture(GL_TEXTURE2);
+            SHADER(10)->setUniformValue("gDepth", 2);
+            gDepth->bind();
+
+            SHADER(10)->setUniformValue("LinMAD", LinMAD);
+
+            rectGeometry->drawGeometry(SHADER(10));
+
+            ssrBuffer[0]->release();
+        }
+
+        if (timeSSR) {
+            ssrTimer->recordSample();
+            ssrTimerPending = true;
         }
 
-        ssrBuffer[CurrentSSR]->release();
         CurrentSSR = !CurrentSSR;
+        frameIndex++;
+    }
+
+    if (ssrTimerPending && ssrTimer->isResultAvailable()) {
+        QVector<GLuint64> intervals = ssrTimer->waitForIntervals();
+        ssrTimer->reset();
+        ssrTimerPending = false;
+
+        for (int pass = 0; pass < 3; pass++)
+            ssrPassTime[pass] += intervals[pass] / 1.0e6;
+        if (++ssrTimedFrames == 120) {
+            qDebug() << "SSR at 1 /" << int(ssrQuality) << "resolution, ms per frame: trace" << ssrPassTime[0] / ssrTimedFrames
+                     << "accumulate" << ssrPassTime[1] / ssrTimedFrames << "upsample" << ssrPassTime[2] / ssrTimedFrames;
+            ssrPassTime[0] = ssrPassTime[1] = ssrPassTime[2] = 0.0;
+            ssrTimedFrames = 0;
+        }
     }
 
     // Render Composite
@@ -352,12 +408,7 @@ void GLWidget::paintGL() {
     {
         compositeBuffer->bind();
 
-        if (isMoving)
-            TotalFrames = 0;
-        else
-            TotalFrames++;
-
-        SHADER(9)->bind();
+        SHADER(5)->bind();
         glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, compositeTexture->textureId(), 0);
 
@@ -366,20 +417,18 @@ void GLWidget::paintGL() {
         glEnable(GL_DEPTH_TEST);
 
         glActiveTexture(GL_TEXTURE0);
-        SHADER(9)->setUniformValue("gReflectionSampler", 0);
-        if (TotalFrames >=250 )
+        SHADER(5)->setUniformValue("gReflectionSampler", 0);
+        // the newest history when it already is at full resolution
+        if (ssrQuality == SSRFull)
             glBindTexture(GL_TEXTURE_2D, ssrTexture[!CurrentSSR]->textureId());
         else
-            glBindTexture(GL_TEXTURE_2D, ssrTexture[CurrentSSR]->textureId());
+            glBindTexture(GL_TEXTURE_2D, ssrUpsampledTexture->textureId());
 
         glActiveTexture(GL_TEXTURE1);
-        SHADER(9)->setUniformValue("gColorSampler", 1);
+        SHADER(5)->setUniformValue("gColorSampler", 1);
         glBindTexture(GL_TEXTURE_2D, bprColorTexture->textureId());
 
-        SHADER(9)->setUniformValue("TotalFrames", TotalFrames);
-        SHADER(9)->setUniformValue("isMoving", isMoving);
-        
-        rectGeometry->drawGeometry(SHADER(9));
+        rectGeometry->drawGeometry(SHADER(5));
 
         compositeBuffer->release();
     }
@@ -397,27 +446,27 @@ void GLWidget::paintGL() {
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glEnable(GL_DEPTH_TEST);
 
-        SHADER(10)->bind();
+        SHADER(6)->bind();
 
         glActiveTexture(GL_TEXTURE0);
-        SHADER(10)->setUniformValue("sCurrentFrame", 0);
+        SHADER(6)->setUniformValue("sCurrentFrame", 0);
         glBindTexture(GL_TEXTURE_2D, compositeTexture->textureId());
 
         glActiveTexture(GL_TEXTURE1);
-        SHADER(10)->setUniformValue("sLastFrame", 1);
+        SHADER(6)->setUniformValue("sLastFrame", 1);
         glBindTexture(GL_TEXTURE_2D, TAATexture[TAACurrentBuffer]->textureId());
 
         glActiveTexture(GL_TEXTURE2);
-        SHADER(10)->setUniformValue("sVelocityBuffer", 2);
+        SHADER(6)->setUniformValue("sVelocityBuffer", 2);
         glBindTexture(GL_TEXTURE_2D, gExtraComponents->textureId());
 
         glActiveTexture(GL_TEXTURE3);
-        SHADER(10)->setUniformValue("sDepthBuffer", 3);
+        SHADER(6)->setUniformValue("sDepthBuffer", 3);
         glBindTexture(GL_TEXTURE_2D, gDepth->textureId());
 
-        SHADER(10)->setUniformValue("iResolution", QVector2D(width(), height()));
+        SHADER(6)->setUniformValue("iResolution", QVector2D(width(), height()));
 
-        rectGeometry->drawGeometry(SHADER(10));
+        rectGeometry->drawGeometry(SHADER(6));
 
         TAABuffer[TAACurrentBuffer]->release();
         TAACurrentBuffer = !TAACurrentBuffer;
@@ -429,15 +478,15 @@ void GLWidget::paintGL() {
         glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
         glClearColor(0.15f, 0.15f, 0.15f, 1.0f);
 
-        SHADER(11)->bind();
+        SHADER(7)->bind();
         glActiveTexture(GL_TEXTURE0);
-        SHADER(11)->setUniformValue("colorBuffer", 0);
+        SHADER(7)->setUniformValue("colorBuffer", 0);
         if (renderTAABuffer)
             glBindTexture(GL_TEXTURE_2D, TAATexture[TAACurrentBuffer]->textureId());
         else
             glBindTexture(GL_TEXTURE_2D, compositeTexture->textureId());
 
-        rectGeometry->drawGeometry(SHADER(11));
+        rectGeometry->drawGeometry(SHADER(7));
     }
 
     // Debug Render Background
@@ -496,49 +545,48 @@ void GLWidget::initShaders() {
 
     // PBR Shader
     {
-        // use for render env cube map
-        if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/15_IBL_Specular_texture/shaders/cubemap.vs.glsl"))
+        if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/18_ScreenSpaceReflection/Shaders/Version3/pbr.vs.glsl"))
             close();
-        if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/15_IBL_Specular_texture/shaders/equirectangular_to_map.fs.glsl"))
+        if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/pbr.fs.glsl"))
             close();
         if (!SHADER(2)->link())
             close();
         if (!SHADER(2)->bind())
             close();
+    }
 
-        // irradiance map
-        if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/15_IBL_Specular_texture/shaders/cubemap.vs.glsl"))
+    // SSR Shader
+    {
+        if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/18_ScreenSpaceReflection/Shaders/Version3/gBuffer.vs.glsl"))
             close();
-        if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/15_IBL_Specular_texture/shaders/irradiance_convolution.fs.glsl"))
+        if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/gBuffer.fs.glsl"))
             close();
         if (!SHADER(3)->link())
             close();
         if (!SHADER(3)->bind())
             close();
 
-        // prefilter map
-        if (!SHADER(4)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/15_IBL_Specular_texture/shaders/cubemap.vs.glsl"))
+        if (!SHADER(4)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/18_ScreenSpaceReflection/Shaders/Version3/SSR.vs.glsl"))
             close();
-        if (!SHADER(4)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/15_IBL_Specular_texture/shaders/prefilter.fs.glsl"))
+        if (!SHADER(4)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/SSR.fs.glsl"))
             close();
         if (!SHADER(4)->link())
             close();
         if (!SHADER(4)->bind())
             close();
 
-        // BRDF map
-        if (!SHADER(5)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/15_IBL_Specular_texture/shaders/brdf.vs.glsl"))
+        if (!SHADER(5)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/ScreenPlane.vs.glsl"))
             close();
-        if (!SHADER(5)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/15_IBL_Specular_texture/shaders/brdf.fs.glsl"))
+        if (!SHADER(5)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/composite.fs.glsl"))
             close();
         if (!SHADER(5)->link())
             close();
         if (!SHADER(5)->bind())
             close();
 
-        if (!SHADER(6)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/15_IBL_Specular_texture/shaders/pbr.vs.glsl"))
+        if (!SHADER(6)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/ScreenPlane.vs.glsl"))
             close();
-        if (!SHADER(6)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/15_IBL_Specular_texture/shaders/pbr.fs.glsl"))
+        if (!SHADER(6)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/TAA.fs.glsl"))
             close();
         if (!SHADER(6)->link())
             close();
@@ -546,67 +594,46 @@ void GLWidget::initShaders() {
             close();
     }
 
-    // SSR Shader
-    {
-        if (!SHADER(7)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/18_ScreenSpaceReflection/Shaders/Version3/gBuffer.vs.glsl"))
-            close();
-        if (!SHADER(7)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/gBuffer.fs.glsl"))
-            close();
-        if (!SHADER(7)->link())
-            close();
-        if (!SHADER(7)->bind())
-            close();
-
-        if (!SHADER(8)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/18_ScreenSpaceReflection/Shaders/Version3/SSR.vs.glsl"))
-            close();
-        if (!SHADER(8)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/SSR.fs.glsl"))
-            close();
-        if (!SHADER(8)->link())
-            close();
-        if (!SHADER(8)->bind())
-            close();
-
-        if (!SHADER(9)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/ScreenPlane.vs.glsl"))
-            close();
-        if (!SHADER(9)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/composite.fs.glsl"))
-            close();
-        if (!SHADER(9)->link())
-            close();
-        if (!SHADER(9)->bind())
-            close();
+    if (!SHADER(7)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/18_ScreenSpaceReflection/Shaders/Version3/debugScreen.vs.glsl"))
+        close();
+    if (!SHADER(7)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/debugScreen.fs.glsl"))
+        close();
+    if (!SHADER(7)->link())
+        close();
+    if (!SHADER(7)->bind())
+        close();
 
-        if (!SHADER(10)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/Shaders/ScreenPlane.vs.glsl"))
-            close();
-        if (!SHADER(10)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/TAA.fs.glsl"))
-            close();
-        if (!SHADER(10)->link())
-            close();
-        if (!SHADER(10)->bind())
-            close();
-    }
+    // Hi-Z depth pyramid
+    if (!SHADER(8)->addShaderFromSourceFile(QOpenGLShader::Compute, "src/18_ScreenSpaceReflection/Shaders/Version3/HiZ.cs.glsl"))
+        close();
+    if (!SHADER(8)->link())
+        close();
 
-    if (!SHADER(11)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/18_ScreenSpaceReflection/Shaders/Version3/debugScreen.vs.glsl"))
+    // SSR temporal accumulation and bilateral upsample
+    if (!SHADER(9)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/18_ScreenSpaceReflection/Shaders/Version3/SSR.vs.glsl"))
+        close();
+    if (!SHADER(9)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/SSRResolve.fs.glsl"))
+        close();
+    if (!SHADER(9)->link())
         close();
-    if (!SHADER(11)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/debugScreen.fs.glsl"))
+
+    if (!SHADER(10)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/18_ScreenSpaceReflection/Shaders/Version3/SSR.vs.glsl"))
         close();
-    if (!SHADER(11)->link())
+    if (!SHADER(10)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/18_ScreenSpaceReflection/Shaders/Version3/SSRUpsample.fs.glsl"))
         close();
-    if (!SHADER(11)->bind())
+    if (!SHADER(10)->link())
         close();
 }
 
 void GLWidget::initGeometry() {
-    cubeGeometry = new CubeGeometry;
-    cubeGeometry->initGeometry();
-    cubeGeometry->setupAttributePointer(SHADER(2));
-
     rectGeometry = new RectangleGeometry;
     rectGeometry->initGeometry();
-    rectGeometry->setupAttributePointer(SHADER(5));
     rectGeometry->setupAttributePointer(SHADER(1));
-    rectGeometry->setupAttributePointer(SHADER(8));
+    rectGeometry->setupAttributePointer(SHADER(4));
+    rectGeometry->setupAttributePointer(SHADER(5));
+    rectGeometry->setupAttributePointer(SHADER(7));
     rectGeometry->setupAttributePointer(SHADER(9));
-    rectGeometry->setupAttributePointer(SHADER(11));
+    rectGeometry->setupAttributePointer(SHADER(10));
 
     skyboxGeometry = new SkyboxGeometry;
     skyboxGeometry->initGeometry();
@@ -614,145 +641,71 @@ void GLWidget::initGeometry() {
 
     BackDrop = new CustomGeometry(QString("src/18_ScreenSpaceReflection/Models/BackDrop.obj"));
     BackDrop->initGeometry();
-    BackDrop->setupAttributePointer(SHADER(6));
-    BackDrop->setupAttributePointer(SHADER(7));
+    BackDrop->setupAttributePointer(SHADER(2));
+    BackDrop->setupAttributePointer(SHADER(3));
 
     ShaderBall = new CustomGeometry(QString("src/18_ScreenSpaceReflection/Models/ShaderBall.obj"));
     ShaderBall->initGeometry();
-    ShaderBall->setupAttributePointer(SHADER(6));
-    ShaderBall->setupAttributePointer(SHADER(7));
+    ShaderBall->setupAttributePointer(SHADER(2));
+    ShaderBall->setupAttributePointer(SHADER(3));
+
+    createInstanceBuffer();
+}
+
+void GLWidget::createInstanceBuffer() {
+    float spacing = 8.0;
+    QVector3D BackDropTr = QVector3D(0.0f, -3.5f, 0.0f);
+
+    // nothing in the grid moves, the buffer is written once and every pass draws it instanced
+    QVector<InstanceData> instances(MATERIAL_BALL_COLUMNS + 1);
+    for (int col = 0; col < MATERIAL_BALL_COLUMNS; col++) {
+        model.setToIdentity();
+        model.translate((col - (MATERIAL_BALL_COLUMNS / 2.0) + 0.5f) * spacing,
+                        0.005f,
+                        0.0f);
+        model.scale(3.5f);
+        memcpy(instances[col].model, model.constData(), sizeof(instances[col].model));
+        instances[col].material = QVector4D(col, 0.0f, 0.0f, 0.0f);
+    }
+
+    // the backdrop keeps the material of the last ball, as it did when it was drawn after the loop
+    model.setToIdentity();
+    model.translate(BackDropTr);
+    model.scale(30.0f);
+    memcpy(instances[MATERIAL_BALL_COLUMNS].model, model.constData(), sizeof(instances[MATERIAL_BALL_COLUMNS].model));
+    instances[MATERIAL_BALL_COLUMNS].material = QVector4D(MATERIAL_BALL_COLUMNS - 1, 0.0f, 0.0f, 0.0f);
+
+    glCreateBuffers(1, &instanceBuffer);
+    glNamedBufferStorage(instanceBuffer, instances.count() * sizeof(InstanceData), instances.constData(), 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_DATA_BINDING, instanceBuffer);
 }
 
 void GLWidget::initTexture() {
 
-    loadHDRTexture();
     loadMaterialTextures();
 
-    generateEnvCubeMap(512);
-    generateIrradianceMap(128);
-    generatePrefilterMap(128);
-    generateBRDFMap(512);
-
     // SSR
     generateGBufferTexture(512);
     generatePBRColorBufferTexture(512);
     generateSSRBufferTexture(512);
     generateTAABufferTexture(512);
     generateCompositeBufferTexture(512);
+    generateHiZBufferTexture();
     
     noiseTexture = new QOpenGLTexture(QImage(QString("src/texture/LDR_RGBA_0.png")).convertToFormat(QImage::Format_RGBA8888));
 }
 
 void GLWidget::loadMaterialTextures() {
-    for (const auto& alebdoFilePath : albedoTextureFilePath) {
-        auto* alebdoTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
-        auto imageData = QImage(alebdoFilePath).convertToFormat(QImage::Format_RGBA8888);
-
-        alebdoTexture->create();
-        alebdoTexture->setSize(imageData.width(), imageData.height(), imageData.depth());
-        alebdoTexture->setFormat(QOpenGLTexture::SRGB8); // gamma correct
-        alebdoTexture->setMipLevels(alebdoTexture->maximumMipLevels());
-        alebdoTexture->allocateStorage();
-        alebdoTexture->bind();
-
-        alebdoTexture->setData(0, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, imageData.constBits());
-        alebdoTexture->setWrapMode(QOpenGLTexture::Repeat);
-        alebdoTexture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-        alebdoTexture->setMagnificationFilter(QOpenGLTexture::Linear);
-        alebdoTexture->generateMipMaps();
-
-        albedo_textures << alebdoTexture;
-    }
-
-    for (const auto& metalicFilePath : metalTextureFilePath) {
-        metallic_textures << new QOpenGLTexture(QImage(metalicFilePath));
-    }
-
-    for (const auto& roughnessFilePath : roughnessTextureFilePath) {
-        roughness_textures << new QOpenGLTexture(QImage(roughnessFilePath));
-    }
-
-    for (const auto& aoFilePath : aoTextureFilePath) {
-        ao_textures << new QOpenGLTexture(QImage(aoFilePath));
-    }
-
-    for (const auto& normalFilePath : normalTextureFilePath) {
-        normal_textures << new QOpenGLTexture(QImage(normalFilePath));
-    }
-}
-
-void GLWidget::loadHDRTexture() {
-    int width, height, channels;
-    stbi_set_flip_vertically_on_load(true);
-    float *image = stbi_loadf("src/texture/HDR/newport_loft.hdr", &width, &height, &channels, 0);
-
-    hdrTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
-    hdrTexture->create();
-    hdrTexture->setSize(width, height, channels);
-    hdrTexture->setFormat(QOpenGLTexture::RGB32F);
-    hdrTexture->allocateStorage();
-
-    hdrTexture->setData(0,0,QOpenGLTexture::RGB,QOpenGLTexture::Float32, image,Q_NULLPTR);
-    hdrTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
-    hdrTexture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    hdrTexture->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
-
-    stbi_image_free(image);
-}
-
-void GLWidget::generateEnvCubeMap(int precision) {
-    envCubeMap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-    envCubeMap->create();
-    envCubeMap->setSize(precision, precision, 1);
-    envCubeMap->setFormat(QOpenGLTexture::RGB32F);
-    envCubeMap->setMipLevels(envCubeMap->maximumMipLevels());
-    envCubeMap->allocateStorage();
-    envCubeMap->bind();
-
-    envCubeMap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    envCubeMap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    envCubeMap->setMagnificationFilter(QOpenGLTexture::Linear);
-}
-
-void GLWidget::generateIrradianceMap(int precision) {
-    irradianceMap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-    irradianceMap->create();
-    irradianceMap->setSize(precision, precision, 1);
-    irradianceMap->setFormat(QOpenGLTexture::RGB32F);
-    irradianceMap->allocateStorage();
-    irradianceMap->bind();
-
-    irradianceMap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    irradianceMap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    irradianceMap->setMagnificationFilter(QOpenGLTexture::Linear);
-}
-
-void GLWidget::generatePrefilterMap(int precision) {
-    prefilterMap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-    prefilterMap->create();
-    prefilterMap->setSize(precision, precision, 1);
-    prefilterMap->setFormat(QOpenGLTexture::RGB32F);
-    prefilterMap->setMipLevels(prefilterMap->maximumMipLevels());
-    prefilterMap->allocateStorage();
-    prefilterMap->bind();
-
-    prefilterMap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    prefilterMap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    prefilterMap->setMagnificationFilter(QOpenGLTexture::Linear);
-    prefilterMap->generateMipMaps();
-}
-
-void GLWidget::generateBRDFMap(int precision) {
-    BRDFMap = new QOpenGLTexture(QOpenGLTexture::Target2D);
-    BRDFMap->create();
-    BRDFMap->setSize(precision, precision, 1);
-    BRDFMap->setFormat(QOpenGLTexture::RGB32F);prefilterMap->allocateStorage();
-    BRDFMap->allocateStorage();
-    BRDFMap->bind();
-
-    BRDFMap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    BRDFMap->setMinificationFilter(QOpenGLTexture::Linear);
-    BRDFMap->setMagnificationFilter(QOpenGLTexture::Linear);
+    // decoded and uploaded in the background, a new frame is asked for whenever one is ready;
+    // block compressed, the first run writes the caches next to the images
+    textureStreamer = new TextureStreamer(this);
+    connect(textureStreamer, &TextureStreamer::textureReady, this, QOverload<>::of(&GLWidget::update));
+
+    textureStreamer->loadArray(&albedoTextureArray, albedoTextureFilePath, QOpenGLTexture::SRGB_DXT1); // gamma correct
+    textureStreamer->loadArray(&metallicTextureArray, metalTextureFilePath, QOpenGLTexture::R_ATI1N_UNorm, QOpenGLTexture::Repeat, Qt::black);
+    textureStreamer->loadArray(&roughnessTextureArray, roughnessTextureFilePath, QOpenGLTexture::R_ATI1N_UNorm);
+    textureStreamer->loadArray(&aoTextureArray, aoTextureFilePath, QOpenGLTexture::R_ATI1N_UNorm, QOpenGLTexture::Repeat, Qt::white);
+    textureStreamer->loadArray(&normalTextureArray, normalTextureFilePath, QOpenGLTexture::RG_ATI2N_UNorm, QOpenGLTexture::Repeat, QColor(128, 128, 255));
 }
 
 void GLWidget::generateGBufferTexture(int precision) {
@@ -763,12 +716,12 @@ void GLWidget::generateGBufferTexture(int precision) {
         gBufferTexture->create();
         gBufferTexture->setFormat(QOpenGLTexture::RGBA32F);
         gBufferTexture->setSize(precision, precision, 1);
-        gBufferTexture->setMipLevels(gBufferTexture->maximumMipLevels());
+        // drawn at full size only, coarser depth comes from the Hi-Z pyramid
+        gBufferTexture->setMipLevels(1);
         gBufferTexture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::Float32);
         gBufferTexture->setWrapMode(QOpenGLTexture::Repeat);
-        gBufferTexture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-        gBufferTexture->setMagnificationFilter(QOpenGLTexture::Nearest);
-        gBufferTexture->generateMipMaps();
+        // read a texel at a time, a lower resolution SSR trace must not average across edges
+        gBufferTexture->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
     }
     gAlbedoSpec = gBufferTextures[0];
     gExpensiveNormal = gBufferTextures[1];
@@ -781,12 +734,11 @@ void GLWidget::generatePBRColorBufferTexture(int precision) {
     bprColorTexture->create();
     bprColorTexture->setFormat(QOpenGLTexture::RGBA32F);
     bprColorTexture->setSize(precision, precision, 1);
-    bprColorTexture->setMipLevels(bprColorTexture->maximumMipLevels());
+    bprColorTexture->setMipLevels(1);
     bprColorTexture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::Float32);
     bprColorTexture->setWrapMode(QOpenGLTexture::Repeat);
-    bprColorTexture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+    bprColorTexture->setMinificationFilter(QOpenGLTexture::Linear);
     bprColorTexture->setMagnificationFilter(QOpenGLTexture::Nearest);
-    bprColorTexture->generateMipMaps();
 }
 
 void GLWidget::generateCompositeBufferTexture(int precision) {
@@ -803,20 +755,84 @@ void GLWidget::generateCompositeBufferTexture(int precision) {
 }
 
 void GLWidget::generateSSRBufferTexture(int precision) {
+    // the trace and its history at the resolution of the quality mode, RGBA16F is plenty for reflections
+    qDeleteAll(ssrTexture);
+    delete ssrTraceTexture;
+    delete ssrUpsampledTexture;
+
+    auto createTexture = [](int size, QOpenGLTexture::Filter filter) {
+        auto *texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+        texture->create();
+        texture->setFormat(QOpenGLTexture::RGBA16F);
+        texture->setSize(size, size, 1);
+        texture->setMipLevels(1);
+        texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::Float16);
+        texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+        texture->setMinMagFilters(filter, filter);
+        return texture;
+    };
+
+    int tracePrecision = qMax(1, precision / int(ssrQuality));
+    ssrTraceTexture = createTexture(tracePrecision, QOpenGLTexture::Nearest);
+
+    // reprojected bilinearly, alpha counts the frames in it and starts at zero
     ssrTexture.resize(2);
-
     for (auto & ssrTex : ssrTexture) {
-        ssrTex = new QOpenGLTexture(QOpenGLTexture::Target2D);
-        ssrTex->create();
-        ssrTex->setFormat(QOpenGLTexture::RGBA32F);
-        ssrTex->setSize(precision, precision, 1);
-        ssrTex->setMipLevels(ssrTex->maximumMipLevels());
-        ssrTex->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::Float32);
-        ssrTex->setWrapMode(QOpenGLTexture::Repeat);
-        ssrTex->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-        ssrTex->setMagnificationFilter(QOpenGLTexture::Nearest);
-        ssrTex->generateMipMaps();
+        ssrTex = createTexture(tracePrecision, QOpenGLTexture::Linear);
+        glClearTexImage(ssrTex->textureId(), 0, GL_RGBA, GL_FLOAT, nullptr);
     }
+
+    ssrUpsampledTexture = createTexture(precision, QOpenGLTexture::Linear);
+}
+
+void GLWidget::setSSRQuality(SSRQuality quality) {
+    if (quality == ssrQuality)
+        return;
+    ssrQuality = quality;
+
+    // before initializeGL the textures are made at this quality anyway
+    if (ssrTexture.isEmpty())
+        return;
+    makeCurrent();
+    generateSSRBufferTexture(gDepth->width());
+    doneCurrent();
+    update();
+}
+
+void GLWidget::generateHiZBufferTexture() {
+    // nearest and farthest depth, every level down to 1x1
+    hiZTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    hiZTexture->create();
+    hiZTexture->setFormat(QOpenGLTexture::RG32F);
+    hiZTexture->setSize(gDepth->width(), gDepth->height(), 1);
+    hiZTexture->setMipLevels(hiZTexture->maximumMipLevels());
+    hiZTexture->allocateStorage(QOpenGLTexture::RG, QOpenGLTexture::Float32);
+    hiZTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
+    hiZTexture->setMinMagFilters(QOpenGLTexture::NearestMipMapNearest, QOpenGLTexture::Nearest);
+}
+
+void GLWidget::buildHiZBuffer() {
+    SHADER(8)->bind();
+
+    glActiveTexture(GL_TEXTURE0);
+    SHADER(8)->setUniformValue("gDepth", 0);
+    gDepth->bind();
+
+    // level 0 copies gDepth, every other one reduces the level before it
+    for (int level = 0; level < hiZTexture->mipLevels(); level++) {
+        int levelWidth = qMax(1, hiZTexture->width() >> level);
+        int levelHeight = qMax(1, hiZTexture->height() >> level);
+
+        SHADER(8)->setUniformValue("level", level);
+        glBindImageTexture(0, hiZTexture->textureId(), qMax(level - 1, 0), GL_FALSE, 0, GL_READ_ONLY, GL_RG32F);
+        glBindImageTexture(1, hiZTexture->textureId(), level, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+        glDispatchCompute((levelWidth + 7) / 8, (levelHeight + 7) / 8, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG32F);
+    glBindImageTexture(1, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
 }
 
 void GLWidget::generateTAABufferTexture(int precision) {
@@ -836,133 +852,10 @@ void GLWidget::generateTAABufferTexture(int precision) {
     }
 }
 
-void GLWidget::renderEnvCubeMap(int precision) {
-    // rendering
-    SHADER(2)->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(2)->setUniformValue("equirectangularMap", 0);
-    hdrTexture->bind();
-    SHADER(2)->setUniformValue("projection", captureProjection);
-
-    glViewport(0, 0, precision * devicePixelRatio(), precision * devicePixelRatio());
-    captureFBO->bind();
-    for(int i=0; i<captureViews.count(); ++i) {
-        SHADER(2)->setUniformValue("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubeMap->textureId(), 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        cubeGeometry->drawGeometry(
-                SHADER(2), hdrTexture);
-    }
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-
-    envCubeMap->bind();
-    envCubeMap->generateMipMaps();
-    envCubeMap->release();
-}
-
-void GLWidget::renderIrradianceMap(int precision) {
-    // rendering
-    SHADER(3)->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(3)->setUniformValue("environmentMap", 0);
-    envCubeMap->bind();
-    SHADER(3)->setUniformValue("projection", captureProjection);
-
-    glViewport(0, 0, precision * devicePixelRatio(), precision * devicePixelRatio());
-    captureFBO->bind();
-    for(int i=0; i<captureViews.count(); ++i) {
-        SHADER(3)->setUniformValue("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap->textureId(), 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        cubeGeometry->drawGeometry(
-                SHADER(3), envCubeMap);
-    }
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-}
-
-void GLWidget::renderPrefilterMap(int precision) {
-    SHADER(4)->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(4)->setUniformValue("environmentMap", 0);
-    envCubeMap->bind();
-    SHADER(4)->setUniformValue("projection", captureProjection);
-
-    captureFBO->bind();
-    unsigned int maxMipLevels = prefilterMap->maximumMipLevels();
-    for (unsigned int mip = 0; mip < maxMipLevels; ++mip) {
-        unsigned int mipWidth  = 128 * std::pow(0.5, mip);
-        unsigned int mipHeight = 128 * std::pow(0.5, mip);
-
-        glViewport(0, 0, mipWidth * devicePixelRatio(), mipHeight * devicePixelRatio());
-        float roughness = (float)mip / (float)(maxMipLevels - 1);
-        SHADER(4)->setUniformValue("roughness", roughness);
-        for (int i=0; i<captureViews.count(); ++i) {
-            SHADER(4)->setUniformValue("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap->textureId(), mip);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            cubeGeometry->drawGeometry(
-                    SHADER(4), envCubeMap);
-        }
-    }
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-}
-
-void GLWidget::renderBRDFMap(int precision) {
-    SHADER(5)->bind();
-
-    glViewport(0, 0, precision * devicePixelRatio(), precision * devicePixelRatio());
-    captureFBO->bind();
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, BRDFMap->textureId(), 0);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    rectGeometry->drawGeometry(
-            SHADER(5));
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-}
-
 void GLWidget::glSetting() {
     // Enable depth buffer
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-
-    // Setting
-    captureProjection.setToIdentity();
-    captureProjection.perspective(90.0f, 1.0f, 0.1f, 10.0f);
-
-    QMatrix4x4 lookAt_1;
-    lookAt_1.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(1.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_2;
-    lookAt_2.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(-1.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_3;
-    lookAt_3.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f));
-    QMatrix4x4 lookAt_4;
-    lookAt_4.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f));
-    QMatrix4x4 lookAt_5;
-    lookAt_5.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_6;
-    lookAt_6.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    captureViews << lookAt_1 << lookAt_2 << lookAt_3 << lookAt_4 << lookAt_5 << lookAt_6;
-}
-
-QOpenGLFramebufferObject* GLWidget::createFBOPointer(int sampleCount) {
-    QOpenGLFramebufferObjectFormat format;
-    format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-    format.setInternalTextureFormat(QOpenGLTexture::RGB32F);
-    format.setSamples(sampleCount);
-    format.setMipmap(true);
-
-    QSize frameBufferSize(width() * devicePixelRatio(), height() * devicePixelRatio());
-    return new QOpenGLFramebufferObject(frameBufferSize, format);
 }
 
 QOpenGLFramebufferObject* GLWidget::createSimpleFBOPointer() {
@@ -986,7 +879,6 @@ QOpenGLFramebufferObject *GLWidget::createGBufferFBOPointer() {
     format.setAttachment(QOpenGLFramebufferObject::Depth);
     format.setTextureTarget(QOpenGLTexture::Target2D);
     format.setSamples(0);
-    format.setMipmap(true);
 
     QSize frameBufferSize(width() * devicePixelRatio(), height() * devicePixelRatio());
     bufferObject = new QOpenGLFramebufferObject(frameBufferSize, format);
@@ -1051,50 +943,69 @@ void GLWidget::cleanup() {
     // delete programs
     qDeleteAll(programs);
     programs.clear();
-    qDeleteAll(albedo_textures);
-    albedo_textures.clear();
-    qDeleteAll(metallic_textures);
-    metallic_textures.clear();
-    qDeleteAll(roughness_textures);
-    roughness_textures.clear();
-    qDeleteAll(ao_textures);
-    ao_textures.clear();
-    qDeleteAll(normal_textures);
-    normal_textures.clear();
+    // before the arrays, it still owns the ones that are not swapped in
+    delete textureStreamer;
+    textureStreamer = nullptr;
+    delete albedoTextureArray;
+    delete metallicTextureArray;
+    delete roughnessTextureArray;
+    delete aoTextureArray;
+    delete normalTextureArray;
+    albedoTextureArray = nullptr;
+    metallicTextureArray = nullptr;
+    roughnessTextureArray = nullptr;
+    aoTextureArray = nullptr;
+    normalTextureArray = nullptr;
+    if (instanceBuffer)
+        glDeleteBuffers(1, &instanceBuffer);
+    instanceBuffer = 0;
 
     delete camera;
-    delete hdrTexture;
     delete envCubeMap;
     delete irradianceMap;
     delete prefilterMap;
     delete BRDFMap;
-    delete captureFBO;
-    delete cubeGeometry;
     delete skyboxGeometry;
     delete rectGeometry;
     delete BackDrop;
     delete ShaderBall;
     delete gBuffer;
+    delete hiZTexture;
+    qDeleteAll(ssrTexture);
+    ssrTexture.clear();
+    delete ssrTraceTexture;
+    delete ssrUpsampledTexture;
+    delete ssrTimer;
     delete noiseTexture;
 
     camera = nullptr;
-    hdrTexture = nullptr;
     envCubeMap = nullptr;
     irradianceMap = nullptr;
     prefilterMap = nullptr;
     BRDFMap = nullptr;
-    captureFBO = nullptr;
-    cubeGeometry = nullptr;
     skyboxGeometry = nullptr;
     rectGeometry = nullptr;
     BackDrop = nullptr;
     ShaderBall = nullptr;
     gBuffer = nullptr;
+    hiZTexture = nullptr;
+    ssrTraceTexture = nullptr;
+    ssrUpsampledTexture = nullptr;
+    ssrTimer = nullptr;
     noiseTexture = nullptr;
 
     doneCurrent();
 }
 
+void GLWidget::keyPressEvent(QKeyEvent *event) {
+    switch (event->key()) {
+        case Qt::Key_1: setSSRQuality(SSRFull); break;
+        case Qt::Key_2: setSSRQuality(SSRHalf); break;
+        case Qt::Key_3: setSSRQuality(SSRQuarter); break;
+        default: QOpenGLWidget::keyPressEvent(event);
+    }
+}
+
 void GLWidget::mousePressEvent(QMouseEvent *event) {
     if (event->button() == Qt::LeftButton && event->modifiers() == Qt::AltModifier) {
 
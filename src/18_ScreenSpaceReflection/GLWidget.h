@@ -6,6 +6,7 @@
 #include <QOpenGLWidget>
 #include <QOpenGLTexture>
 #include <QOpenGLShaderProgram>
+#include <QOpenGLTimeMonitor>
 #include <QtWidgets/QApplication>
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLFunctions_4_5_Core>
@@ -14,14 +15,19 @@
 #include <QDebug>
 
 #include "Helper/Camera.h"
-#include "Helper/CubeGeometry.h"
 #include "Helper/CustomGeometry.h"
 #include "Helper/SkyboxGeometry.h"
 #include "Helper/SphereGeometry.h"
 #include "Helper/RectangleGeometry.h"
+#include "Helper/IBLPrecompute.h"
+#include "Helper/TextureStreamer.h"
+
+// shader balls of the material grid, each one uses its own layer of the material texture arrays
+#define MATERIAL_BALL_COLUMNS 4
+// instance buffer of gBuffer.vs.glsl and pbr.vs.glsl: the balls followed by the backdrop
+#define INSTANCE_DATA_BINDING 0
 
 class Camera;
-class CubeGeometry;
 class SkyboxGeometry;
 class SphereGeometry;
 class RectangleGeometry;
@@ -39,6 +45,10 @@ public:
 
     bool zoomInProcessing = false;
 
+    // resolution the reflections are traced and accumulated at, 1 / value of the gBuffer's
+    enum SSRQuality { SSRFull = 1, SSRHalf = 2, SSRQuarter = 4 };
+    void setSSRQuality(SSRQuality quality);
+
 protected:
     void initializeGL() override;
     void resizeGL(int width, int height) override;
@@ -49,18 +59,6 @@ protected:
     void initTexture();
 
     void glSetting();
-    void loadHDRTexture();
-
-    // ----- PBR functions ----- //
-    void generateEnvCubeMap(int precision);
-    void generateIrradianceMap(int precision);
-    void generatePrefilterMap(int precision);
-    void generateBRDFMap(int precision);
-
-    void renderEnvCubeMap(int precision);
-    void renderIrradianceMap(int precision);
-    void renderPrefilterMap(int precision);
-    void renderBRDFMap(int precision);
 
     // ----- SSR functions ----- //
     void generateGBufferTexture(int precision);
@@ -68,11 +66,14 @@ protected:
     void generateSSRBufferTexture(int precision);
     void generateTAABufferTexture(int precision);
     void generateCompositeBufferTexture(int precision);
+    void generateHiZBufferTexture();
+    // min/max depth pyramid of gDepth, after the gBuffer pass
+    void buildHiZBuffer();
 
     void loadMaterialTextures();
+    void createInstanceBuffer();
 
     // ----- FrameBuffers ----- //
-    QOpenGLFramebufferObject* createFBOPointer(int sampleCount=0);
     QOpenGLFramebufferObject* createGBufferFBOPointer();
     QOpenGLFramebufferObject* createSimpleFBOPointer();
     void createSSRFBOPointer();
@@ -82,6 +83,7 @@ protected:
     void updatePreStatues();
     QMatrix4x4 preViewMatrix;
 
+    void keyPressEvent(QKeyEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
@@ -89,7 +91,6 @@ protected:
 
 private:
     QList<QOpenGLShaderProgram *> programs;
-    QOpenGLTexture *hdrTexture;
     QOpenGLTexture *envCubeMap;
     QOpenGLTexture *irradianceMap;
     QOpenGLTexture *prefilterMap;
@@ -98,29 +99,36 @@ private:
 
     QOpenGLTexture *gAlbedoSpec, *gExpensiveNormal, *gDepth, *gExtraComponents, *bprColorTexture, *compositeTexture;
     QVector<QOpenGLTexture*> gBufferTextures;
+    // accumulated reflections, ping-ponged
     QVector<QOpenGLTexture*> ssrTexture;
+    QOpenGLTexture *ssrTraceTexture = nullptr;
+    QOpenGLTexture *ssrUpsampledTexture = nullptr;
     QVector<QOpenGLTexture*> TAATexture;
+    QOpenGLTexture *hiZTexture = nullptr;
 
-    CubeGeometry *cubeGeometry;
     SkyboxGeometry *skyboxGeometry;
     RectangleGeometry *rectGeometry;
     CustomGeometry *BackDrop;
     CustomGeometry *ShaderBall;
+    GLuint instanceBuffer = 0;
 
     Camera *camera;
     QMatrix4x4 model;
     QPoint mousePos;
 
-    QOpenGLFramebufferObject *captureFBO;
     QOpenGLFramebufferObject *gBuffer, *pbrBuffer, *compositeBuffer;
     QVector<QOpenGLFramebufferObject*> ssrBuffer;
     bool CurrentSSR = false;
+    SSRQuality ssrQuality = SSRHalf;
+    unsigned int frameIndex = 0;
+    QOpenGLTimeMonitor *ssrTimer = nullptr;
+    bool ssrTimerPending = false;
+    double ssrPassTime[3] = {};
+    int ssrTimedFrames = 0;
     QVector<QOpenGLFramebufferObject*> TAABuffer;
     bool TAACurrentBuffer = false;
 
     bool isMoving = false; // camera is moving ?
-    int TotalFrames = 0;
-    QTime myTimer;
 
     QList<QString> faces{
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/CubeMap/right.jpg"),
@@ -131,11 +139,11 @@ private:
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/CubeMap/back.jpg")
     };
 
-    QMatrix4x4 captureProjection;
-    QVector<QMatrix4x4> captureViews;
+    // the material arrays stream in, placeholders until then
+    TextureStreamer *textureStreamer = nullptr;
 
     // albedo texture
-    QList<QOpenGLTexture*> albedo_textures;
+    QOpenGLTexture *albedoTextureArray = nullptr;
     QList<QString> albedoTextureFilePath{
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/PBR/beatenMetal/beatenMetal-albedo.png"),
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/PBR/rusted_iron/albedo.png"),
@@ -145,7 +153,7 @@ private:
     };
 
     // metallic texture
-    QList<QOpenGLTexture*> metallic_textures;
+    QOpenGLTexture *metallicTextureArray = nullptr;
     QList<QString> metalTextureFilePath{
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/PBR/beatenMetal/beatenMetal-Metallic.png"),
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/PBR/rusted_iron/metallic.png"),
@@ -155,7 +163,7 @@ private:
     };
 
     // roughness texture
-    QList<QOpenGLTexture*> roughness_textures;
+    QOpenGLTexture *roughnessTextureArray = nullptr;
     QList<QString> roughnessTextureFilePath{
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/PBR/beatenMetal/beatenMetal-Roughness.png"),
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/PBR/rusted_iron/roughness.png"),
@@ -165,7 +173,7 @@ private:
     };
 
     // ao texture
-    QList<QOpenGLTexture*> ao_textures;
+    QOpenGLTexture *aoTextureArray = nullptr;
     QList<QString> aoTextureFilePath{
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/PBR/beatenMetal/beatenMetal-ao.png"),
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/PBR/rusted_iron/ao.png"),
@@ -175,7 +183,7 @@ private:
     };
 
     // normal texture
-    QList<QOpenGLTexture*> normal_textures;
+    QOpenGLTexture *normalTextureArray = nullptr;
     QList<QString> normalTextureFilePath{
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/PBR/beatenMetal/beatenMetal-Normal.png"),
             QString("F:/CLionProjects/QtReference/src/17_qopengl_mess/images/PBR/rusted_iron/normal.png"),
@@ -0,0 +1,41 @@
+#version 460 core
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// one level of the depth pyramid SSR.fs.glsl marches: nearest (r) and farthest (g) depth under each texel.
+// level 0 copies the depth of the gBuffer, every other level reduces the 2x2 texels of the one below,
+// the last row and column take a third texel when the level below has an odd size
+layout (binding = 0, rg32f) uniform readonly image2D previousLevel;
+layout (binding = 1, rg32f) uniform writeonly image2D currentLevel;
+
+uniform sampler2D gDepth;
+uniform int level;
+
+void main() {
+    ivec2 size = imageSize(currentLevel);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (texel.x >= size.x || texel.y >= size.y)
+        return;
+
+    if (level == 0) {
+        float depth = texelFetch(gDepth, texel, 0).r;
+        imageStore(currentLevel, texel, vec4(depth, depth, 0.0, 0.0));
+        return;
+    }
+
+    ivec2 previousSize = imageSize(previousLevel);
+    ivec2 footprint = ivec2(2);
+    if (texel.x == size.x - 1 && (previousSize.x & 1) != 0)
+        footprint.x = 3;
+    if (texel.y == size.y - 1 && (previousSize.y & 1) != 0)
+        footprint.y = 3;
+
+    vec2 minMax = vec2(1.0, 0.0);
+    for (int y = 0; y < footprint.y; y++) {
+        for (int x = 0; x < footprint.x; x++) {
+            vec2 below = imageLoad(previousLevel, min(texel * 2 + ivec2(x, y), previousSize - 1)).rg;
+            minMax = vec2(min(minMax.x, below.x), max(minMax.y, below.y));
+        }
+    }
+    imageStore(currentLevel, texel, vec4(minMax, 0.0, 0.0));
+}
@@ -9,28 +9,27 @@ uniform sampler2D gNormal;
 uniform sampler2D gExtraComponents;
 uniform sampler2D gDepth;
 uniform sampler2D BRDF;
+// blue noise
 uniform sampler2D noiseTexture;
-uniform sampler2D PreviousReflection;
 uniform sampler2D gAlbedo;
+// nearest (r) and farthest (g) depth of the gBuffer under each texel, HiZ.cs.glsl
+uniform sampler2D hiZBuffer;
 
 uniform mat4 view;
 uniform mat4 projection;
 uniform vec3 camPos;
 uniform vec2 Resolution;
 uniform vec2 LinMAD;
-uniform float Time;
-uniform int ID;
-uniform bool isMoving;
+// picks the noise offset, SSRResolve.fs.glsl accumulates the frames
+uniform int frameIndex;
 
 uniform int maxSteps = 100;
-uniform int numBinarySearchSteps = 10;
 uniform float roughnessCutoff = 0.8;
-uniform float depthCutoff = -1.05;
 
-uniform float minRayStep = 0.01;
-uniform float maxRayStep = 0.05;
+// view space length of a ray, and how far behind its depth a surface is taken to reach
+uniform float maxRayDistance = 100.0;
+uniform float thickness = 0.5;
 
-const float rayIncrement = 1.04;
 const float searchDist = 5;
 const float searchDistInv = 0.2;
 const float maxDDepth = 1.0;
@@ -40,7 +39,6 @@ const float reflectionSpecularFalloffExponent = 3.0;
 const float MAX_REFLECTION_LOD = 4.0;
 
 float Roughness = 0.0;
-float rayStep = 0.05;
 float Metallic = 0.0;
 float near = 0.01;
 float far = 1000.0;
@@ -49,8 +47,7 @@ in vec2 Coords;
 out vec4 FragColor;
 
 vec3 PositionFromDepth(float depth);
-vec4 RayCast(vec3 dir, inout vec3 hitCoord, out float dDepth);
-vec3 BinarySearch(inout vec3 dir, inout vec3 hitCoord, inout float dDepth);
+vec4 RayCast(vec3 origin, vec3 dir);
 vec3 fresnelSchlick(float cosTheta, vec3 F0);
 vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness);
 float saturate(float x);
@@ -60,23 +57,7 @@ float ViewSpaceZFromDepth(float d) {
     return -1.0 / (LinMAD.x * d + LinMAD.y);
 }
 
-bool isSignificant(float dd) {
-    return dd < 0.05 && dd > depthCutoff;
-}
-
 void main() {
-    vec4 PrevReflection = texture(PreviousReflection, Coords);
-    if (ID > 251) {
-        FragColor = PrevReflection;
-        return;
-    }
-    if (ID == 251) {
-        FragColor = PrevReflection / 251;
-        return;
-    }
-
-    rayStep = minRayStep;
-
     vec2 MetallicEmissive = texture(gExtraComponents, Coords).rg;
     vec2 texelSize = 1.0 / vec2(textureSize(gExtraComponents, 0));
     Metallic = MetallicEmissive.r;
@@ -104,21 +85,20 @@ void main() {
 
     Roughness = texture(gNormal, Coords).w;
 
-    vec3 hitPos = viewPos;
-
     vec3 SSR;
     vec2 brdf = texture(BRDF, vec2(max(dot(worldNormal, viewDir), 0.0), Roughness)).rg;
 
     if (!isPlastic) {
-        vec2 NoiseScale = Resolution / 4.0; // unused
-        vec3 random = vec3(texture(noiseTexture, (Coords.xy * 1.0) + (1.0 - fract(Time))).rgb);
+        // a texel of blue noise per pixel, moved along the R2 sequence every frame
+        ivec2 noiseSize = textureSize(noiseTexture, 0);
+        ivec2 noiseOffset = ivec2(fract(vec2(0.7548776662, 0.5698402910) * float(frameIndex)) * vec2(noiseSize));
+        vec3 random = texelFetch(noiseTexture, (ivec2(gl_FragCoord.xy) + noiseOffset) % noiseSize, 0).rgb;
         random = dot(random, viewNormal) > 0.0 ? random : -random;
         float factor = Roughness * 0.20;
         vec3 hs = random * 2.0 - 1.0;
         vec3 jitt = hs * factor;
         vec3 reflected = normalize(reflect(normalize(viewPos), normalize(viewNormal)));
-        float dDepth = 0.0;
-        vec4 coords = RayCast(normalize(reflected + jitt) * max(minRayStep, -viewPos.z), hitPos, dDepth);
+        vec4 coords = RayCast(viewPos, normalize(reflected + jitt));
         vec2 centered_coords = abs(coords.xy * 2.0 - 1.0);
         float mixer = min(1.0, max(centered_coords.x, centered_coords.y));
 
@@ -137,9 +117,6 @@ void main() {
     vec3 Fresnel = fresnelSchlickRoughness(max(dot(worldNormal, viewDir), 0.0), F0, Roughness);
 
     FragColor = vec4(SSR * (1.0 - Roughness) * (Fresnel * brdf.x + brdf.y), 1.0);
-
-    if (!isMoving && ID <= 250)
-        FragColor = FragColor + PrevReflection;
 }
 
 vec3 PositionFromDepth(float depth) {
@@ -153,81 +130,83 @@ vec3 PositionFromDepth(float depth) {
     return viewSpacePostion.xyz;
 }
 
-vec3 BinarySearch(inout vec3 dir, inout vec3 hitCoord, inout float dDepth) {
-    float depth;
-
-    vec4 projectedCoord;
-
-    for (int i=0; i < numBinarySearchSteps; i++) {
-        projectedCoord = projection * vec4(hitCoord, 1.0);
-        projectedCoord.xy /= projectedCoord.w;
-        projectedCoord.xy = projectedCoord.xy * 0.5 + 0.5;
-
-        depth = ViewSpaceZFromDepth(textureLod(gDepth, projectedCoord.xy, 0.0).x);
-        dDepth = hitCoord.z - depth;
-
-        dir *= 0.5;
-        hitCoord += (dDepth > 0.0) ? dir : -dir;
-    }
-
-    projectedCoord = projection * vec4(hitCoord, 1.0);
-    projectedCoord.xy /= projectedCoord.w;
-    projectedCoord.xy = projectedCoord.xy * 0.5 + 0.5;
-
-    return vec3(projectedCoord.xy, dDepth);
+float LinearDepth(float depth) {
+    return -ViewSpaceZFromDepth(depth);
 }
 
-vec4 RayCast(vec3 dir, inout vec3 hitCoord, out float dDepth)
-{
-    dir *= rayStep;
-
-    float depth;
-    int steps = 0;
-    vec4 projectedCoord;
-
-    hitCoord += dir;
-    int miplevel = 0;
-    for (int i=0; i < maxSteps; i++) {
-        projectedCoord = projection * vec4(hitCoord, 1.0);
-        projectedCoord.xy /= projectedCoord.w;
-        projectedCoord.xy = projectedCoord.xy * 0.5 + 0.5;
+// xy in texels of level 0 of the depth pyramid, z the depth the gBuffer stores
+vec3 ScreenFromView(vec3 position) {
+    vec4 clip = projection * vec4(position, 1.0);
+    vec3 ndc = clip.xyz / clip.w;
+    return vec3((ndc.xy * 0.5 + 0.5) * vec2(textureSize(hiZBuffer, 0)), ndc.z * 0.5 + 0.5);
+}
 
-        depth = ViewSpaceZFromDepth(textureLod(gDepth, projectedCoord.xy, miplevel).x);
+// where the ray leaves the cell of the given level it is in at t, a hair past the border
+float CellExit(vec3 origin, vec3 ray, float t, int level) {
+    float cellSize = float(1 << level);
+    vec2 cell = floor((origin.xy + ray.xy * t) / cellSize);
+    vec2 border = (cell + step(0.0, ray.xy)) * cellSize + sign(ray.xy) * 0.01;
+
+    float exit = 1e30;
+    if (ray.x != 0.0)
+        exit = min(exit, (border.x - origin.x) / ray.x);
+    if (ray.y != 0.0)
+        exit = min(exit, (border.y - origin.y) / ray.y);
+    return exit;
+}
 
-        if (depth > 1000.0) {
-            continue;
+// marches the depth pyramid in screen space: a cell whose depths the ray misses is skipped whole and the
+// march goes on a level coarser, a cell it may hit is looked at a level finer, down to a single texel.
+// returns the texture coordinates and depth of the hit, zero when there is none
+vec4 RayCast(vec3 origin, vec3 dir) {
+    // clipped to the near plane
+    float rayLength = maxRayDistance;
+    if (dir.z > 0.0)
+        rayLength = min(rayLength, (-near - origin.z) / dir.z);
+
+    vec3 start = ScreenFromView(origin);
+    vec3 ray = ScreenFromView(origin + dir * rayLength) - start;
+
+    // and to the screen
+    vec2 size = vec2(textureSize(hiZBuffer, 0));
+    float tEnd = 1.0;
+    if (ray.x != 0.0)
+        tEnd = min(tEnd, ((ray.x > 0.0 ? size.x : 0.0) - start.x) / ray.x);
+    if (ray.y != 0.0)
+        tEnd = min(tEnd, ((ray.y > 0.0 ? size.y : 0.0) - start.y) / ray.y);
+
+    int topLevel = textureQueryLevels(hiZBuffer) - 1;
+    int level = 0;
+    // off the texel it starts on
+    float t = CellExit(start, ray, 0.0, 0);
+
+    for (int i = 0; i < maxSteps && t < tEnd; i++) {
+        ivec2 levelSize = textureSize(hiZBuffer, level);
+        ivec2 cell = clamp(ivec2(start.xy + ray.xy * t) >> level, ivec2(0), levelSize - 1);
+        vec2 minMax = texelFetch(hiZBuffer, cell, level).rg;
+
+        float tExit = min(CellExit(start, ray, t, level), tEnd);
+        float zEnter = start.z + ray.z * t;
+        float zExit = start.z + ray.z * tExit;
+
+        // does the segment in the cell pass through any of its surfaces, thickness deep
+        bool overlaps = max(zEnter, zExit) >= minMax.x &&
+                        LinearDepth(min(zEnter, zExit)) <= LinearDepth(minMax.y) + thickness;
+        if (!overlaps) {
+            t = tExit;
+            level = min(level + 1, topLevel);
         }
-
-        dDepth = hitCoord.z - depth;
-
-        if(isSignificant(dDepth) || (dir.z - dDepth) < 1.5) {
-            do {
-                depth = ViewSpaceZFromDepth(texture(gDepth, projectedCoord.xy, miplevel).x);
-                dDepth = hitCoord.z - depth;
-
-                if (miplevel > 0 && isSignificant(dDepth)) {
-                    miplevel--;
-                }
-                else if(miplevel == 0 && isSignificant(dDepth)) {
-                    return vec4(BinarySearch(dir, hitCoord, dDepth), 1.0);
-                }
-                else
-                    break;
-            } while(miplevel > 0 && isSignificant(dDepth));
-            miplevel--;
+        else if (level > 0) {
+            level--;
+        }
+        else {
+            // where it reaches the surface, or right here when it already is behind it
+            float tHit = zEnter < minMax.x ? clamp((minMax.x - start.z) / ray.z, t, tExit) : t;
+            return vec4((start.xy + ray.xy * tHit) / size, start.z + ray.z * tHit, 1.0);
         }
-
-        hitCoord += dir;
-        dir *= rayIncrement;
-        steps++;
-        miplevel++;
-        miplevel = clamp(miplevel, 0, 5);
     }
 
-    if (depth < 1000)
-        return vec4(0.0);
-
-    return vec4(BinarySearch(dir, hitCoord, dDepth), 1.0);
+    return vec4(0.0);
 }
 
 float saturate(float x) {
@@ -0,0 +1,57 @@
+#version 460 core
+
+// temporal accumulation of the traced reflections, at the trace resolution. the history is reprojected with
+// the velocity of the gBuffer, clipped to the spread of this frame's trace around the texel and blended in
+// by its age (alpha), so a still view converges while a moving one keeps up
+uniform sampler2D currentReflection;
+uniform sampler2D historyReflection;
+uniform sampler2D gExtraComponents;
+
+uniform int maxHistory = 32;
+// standard deviations the clip box reaches out from the mean
+uniform float varianceClip = 1.25;
+
+in vec2 Coords;
+out vec4 FragColor;
+
+// towards the center of the box until the color is inside
+vec3 ClipToBox(vec3 color, vec3 boxMin, vec3 boxMax) {
+    vec3 center = 0.5 * (boxMax + boxMin);
+    vec3 extent = 0.5 * (boxMax - boxMin) + 0.0001;
+    vec3 offset = color - center;
+    vec3 units = abs(offset / extent);
+    float maxUnit = max(units.x, max(units.y, units.z));
+    return maxUnit > 1.0 ? center + offset / maxUnit : color;
+}
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(currentReflection, 0);
+    vec3 current = texelFetch(currentReflection, texel, 0).rgb;
+
+    vec3 mean = vec3(0.0);
+    vec3 meanSquared = vec3(0.0);
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            vec3 neighbour = texelFetch(currentReflection, clamp(texel + ivec2(x, y), ivec2(0), size - 1), 0).rgb;
+            mean += neighbour;
+            meanSquared += neighbour * neighbour;
+        }
+    }
+    mean /= 9.0;
+    meanSquared /= 9.0;
+    vec3 sigma = sqrt(max(meanSquared - mean * mean, vec3(0.0)));
+
+    vec2 previousCoords = Coords - texture(gExtraComponents, Coords).zw;
+    if (any(lessThan(previousCoords, vec2(0.0))) || any(greaterThan(previousCoords, vec2(1.0)))) {
+        // came from off screen, nothing to go on
+        FragColor = vec4(current, 1.0);
+        return;
+    }
+
+    vec4 history = texture(historyReflection, previousCoords);
+    vec3 clipped = ClipToBox(history.rgb, mean - varianceClip * sigma, mean + varianceClip * sigma);
+    float age = min(history.a + 1.0, float(maxHistory));
+
+    FragColor = vec4(mix(clipped, current, 1.0 / age), age);
+}
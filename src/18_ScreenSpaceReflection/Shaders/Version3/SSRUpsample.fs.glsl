@@ -0,0 +1,51 @@
+#version 460 core
+
+// full resolution reflections from the accumulated low resolution ones: the four nearest low resolution texels,
+// weighted bilinearly and by how close the depth and normal they were traced from are to this pixel's
+uniform sampler2D reflection;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+uniform vec2 LinMAD;
+// relative depth difference that costs a sample ~63% of its weight, and how fast a bent normal falls off
+uniform float depthTolerance = 0.05;
+uniform float normalPower = 8.0;
+
+in vec2 Coords;
+out vec4 FragColor;
+
+float LinearDepth(float depth) {
+    depth = depth * 2.0 - 1.0; // clip space
+    return 1.0 / (LinMAD.x * depth + LinMAD.y);
+}
+
+void main() {
+    vec2 lowSize = vec2(textureSize(reflection, 0));
+    vec2 position = Coords * lowSize - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = fract(position);
+
+    float depth = LinearDepth(texture(gDepth, Coords).x);
+    // stored normalized, zero where nothing was drawn
+    vec3 normal = texture(gNormal, Coords).xyz;
+
+    vec4 sum = vec4(0.0);
+    float weightSum = 0.0;
+    for (int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(base + offset, ivec2(0), ivec2(lowSize) - 1);
+        // the gBuffer texel the trace read
+        vec2 lowCoords = (vec2(texel) + 0.5) / lowSize;
+
+        float bilinear = (offset.x == 1 ? f.x : 1.0 - f.x) * (offset.y == 1 ? f.y : 1.0 - f.y);
+        float depthWeight = exp(-abs(LinearDepth(texture(gDepth, lowCoords).x) - depth) / (depthTolerance * depth));
+        float normalWeight = pow(max(dot(normal, texture(gNormal, lowCoords).xyz), 0.0), normalPower);
+
+        // never quite zero, a pixel no sample matches falls back to bilinear
+        float weight = bilinear * (depthWeight * normalWeight + 0.0001);
+        sum += texelFetch(reflection, texel, 0) * weight;
+        weightSum += weight;
+    }
+
+    FragColor = vec4(sum.rgb / max(weightSum, 0.00001), 1.0);
+}
@@ -14,23 +14,25 @@ in VS_OUT{
     vec3 wFragPos;
 } fs_in;
 
-uniform sampler2D albedoMap;
-uniform sampler2D roughnessMap;
-uniform sampler2D normalMap;
-uniform sampler2D metallicMap;
+// one layer per material, picked by the instance
+uniform sampler2DArray albedoMap;
+uniform sampler2DArray roughnessMap;
+uniform sampler2DArray normalMap;
+uniform sampler2DArray metallicMap;
 uniform samplerCube skybox;
 
 uniform vec3 viewPos;
 
 in vec4 PrevPosition;
 in vec4 Position;
+flat in int MaterialLayer;
 
 const float MAX_REFLECTION_LOD = 4.0;
 
 void main() {
     vec3 camDir = normalize((fs_in.TBN * viewPos) - (fs_in.TBN * fs_in.wFragPos));
 
-    vec2 texCoords = fs_in.TexCoords;
+    vec3 texCoords = vec3(fs_in.TexCoords, MaterialLayer);
 
     vec4 Diffuse = texture(albedoMap, texCoords);
     vec3 r_tex = texture(roughnessMap, texCoords).xyz;
@@ -39,7 +41,10 @@ void main() {
     gAlbedoSpec.rgb = Diffuse.rgb;
     gAlbedoSpec.a = clamp(r_tex.z, 0.0, 1.0);
 
-    gExpensiveNormal.rgb = normalize(fs_in.TBN * normalize(texture(normalMap, texCoords).rgb * 2.0 - 1.0));
+    // BC5 stores x and y only
+    vec2 normalXY = texture(normalMap, texCoords).rg * 2.0 - 1.0;
+    vec3 tangentNormal = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
+    gExpensiveNormal.rgb = normalize(fs_in.TBN * tangentNormal);
     gExpensiveNormal.a = clamp(Roughness * Roughness, 0.0, 1.0);
 
     vec4 CubeMapcolor = vec4(0.0);
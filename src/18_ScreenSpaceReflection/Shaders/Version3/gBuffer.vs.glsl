@@ -15,14 +15,24 @@ out VS_OUT{
     vec3 wFragPos;
 } vs_out;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
-uniform mat4 PrevModel;
 uniform mat4 PrevView;
 
+// model matrix and material layer of every ball and the backdrop, indexed by instance
+struct InstanceData {
+    mat4 model;
+    vec4 material;
+};
+layout (std430, binding = 0) readonly buffer Instances {
+    InstanceData instances[];
+};
+
+mat4 model;
+
 out vec4 PrevPosition;
 out vec4 Position;
+flat out int MaterialLayer;
 
 mat3 CreateTBNMatrix() {
     mat3 normalMatrix = transpose(inverse(mat3(model)));
@@ -45,6 +55,10 @@ mat3 CreateTBNMatrix2() {
 }
 
 void main() {
+    InstanceData instance = instances[gl_BaseInstance + gl_InstanceID];
+    model = instance.model;
+    MaterialLayer = int(instance.material.x);
+
     vec4 worldPos = model * vec4(aPos, 1.0);
 
     mat4 ViewMatrix = view;
@@ -56,7 +70,8 @@ void main() {
     vs_out.wFragPos = worldPos.xyz;
     Position = projection * viewPos;
     gl_Position = Projection * viewPos;
-    PrevPosition = projection * PrevView * PrevModel * vec4(aPos, 1.0);
+    // the grid never moves, so the previous model matrix is the current one
+    PrevPosition = projection * PrevView * model * vec4(aPos, 1.0);
     vs_out.TexCoords = aCoord;
 
     vs_out.TBN = CreateTBNMatrix();
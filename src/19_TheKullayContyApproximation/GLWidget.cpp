@@ -1,5 +1,6 @@
 #include "GLWidget.h"
 #include <QKeyEvent>
+#include <cstring>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -8,23 +9,19 @@
 
 GLWidget::GLWidget(QWidget *parent)
         : QOpenGLWidget(parent),
-          hdrTexture(nullptr),
           envCubemap(nullptr),
           irradianceMap(nullptr),
           prefilterMap(nullptr),
           brdfLUTTexture(nullptr),
-          captureFBO(nullptr),
-          cubeGeometry(nullptr),
           skybox_geometry(nullptr),
           sphereGeometry(nullptr),
-          QuadGeometry(nullptr),
           shadingBallGeo(nullptr),
           camera(nullptr) {
 
     // Create two shader program
     // the first one use for offscreen rendering
     // the second for default framebuffer rendering
-    int shaderStack = 7;
+    int shaderStack = 3;
     if (renderCustomGeo) {
         shaderStack += 1;
     }
@@ -63,11 +60,18 @@ void GLWidget::initializeGL() {
     glSetting();
     initGeometry();
 
-    captureFBO = createFBOPointer(0);
-    renderEnvCubeMap(512);
-    renderIrradianceMap(128);
-    renderPrefilterMap(128);
-    renderBRDFMap(512);
+    // environment, irradiance, prefiltered map and BRDF LUT, straight from the cache after the first run;
+    // the furnace test compares against exact energy, it keeps the half float maps
+    IBLSettings settings;
+    settings.compressed = !furnaceTest;
+    IBLMaps maps = IBLPrecompute().load(furnaceTest ? "src/texture/HDR/Uniform.jpg" : "src/texture/HDR/newport_loft.hdr", settings);
+    // empty when the HDR cannot be read
+    if (maps.envCubemap == nullptr)
+        close();
+    envCubemap = maps.envCubemap;
+    irradianceMap = maps.irradianceMap;
+    prefilterMap = maps.prefilterMap;
+    brdfLUTTexture = maps.brdfLUTTexture;
 }
 
 void GLWidget::paintGL() {
@@ -78,32 +82,32 @@ void GLWidget::paintGL() {
     glEnable(GL_DEPTH_TEST);
 
     if (renderCustomGeo) {
-        renderShadingBall(SHADER(3), 1.5, computePointLight);
-        renderShadingBall(SHADER(7), -1.5, computePointLight);
+        renderShadingBall(SHADER(0), ShadingBallMultipleScatteringRow, computePointLight);
+        renderShadingBall(SHADER(3), ShadingBallSlidersRow, computePointLight);
     }
     else {
-        renderSphere(SHADER(3), 5.0f, true, computePointLight); // Multiple Scattering
-        renderSphere(SHADER(4), 2.5f, true, computePointLight); // Single Scattering
+        renderSphere(SHADER(0), MetalMultipleScatteringRow, true, computePointLight); // Multiple Scattering
+        renderSphere(SHADER(1), MetalSingleScatteringRow, true, computePointLight); // Single Scattering
 
-        renderSphere(SHADER(3), -2.5f, false, computePointLight); // Multiple Scattering
-        renderSphere(SHADER(4), -5.0f, false, computePointLight); // Single Scattering
+        renderSphere(SHADER(0), DielectricMultipleScatteringRow, false, computePointLight); // Multiple Scattering
+        renderSphere(SHADER(1), DielectricSingleScatteringRow, false, computePointLight); // Single Scattering
     }
 
     // ----- Render background ----- //
-    SHADER(6)->bind();
+    SHADER(2)->bind();
     glActiveTexture(GL_TEXTURE0);
-    SHADER(6)->setUniformValue("map", 0);
+    SHADER(2)->setUniformValue("map", 0);
     irradianceMap->bind();
     glDepthFunc(GL_LEQUAL);
     skybox_geometry->drawGeometry(
-            SHADER(6),
+            SHADER(2),
             camera->getCameraView(),
             camera->getCameraProjection());
     irradianceMap->release();
     glDepthFunc(GL_LESS);
 }
 
-void GLWidget::renderSphere(QOpenGLShaderProgram *shader, float YOffset, bool is_metal, bool isComputePointLight) {
+void GLWidget::renderSphere(QOpenGLShaderProgram *shader, GridRow row, bool is_metal, bool isComputePointLight) {
 
     shader->bind();
 
@@ -128,28 +132,34 @@ void GLWidget::renderSphere(QOpenGLShaderProgram *shader, float YOffset, bool is
     shader->setUniformValue("brdfLUT", 2);
     brdfLUTTexture->bind();
 
-    int nrColumns = 10;
-    float spacing = 3.0;
-    for (int col = 0; col < nrColumns; col++) {
-        shader->setUniformValue("metallic", is_metal ? 1.0f : 0.0f);
-
-        shader->setUniformValue("roughness", qBound(0.0f,(float)col / (float)(nrColumns - 1),1.0f));
-        model.setToIdentity();
-        model.translate(((float)col - ((float)nrColumns / 2.0f)) * spacing + 1.2f,
-                        YOffset,
-                        0.0f);
-
-        sphereGeometry->drawGeometry(
-                shader,
-                model,
-                camera->getCameraView(),
-                camera->getCameraProjection());
-    }
+    // model matrices and roughness of the row live in the instance buffer
+    shader->setUniformValue("metallic", is_metal ? 1.0f : 0.0f);
+
+    sphereGeometry->drawGeometryInstanced(
+            shader,
+            camera->getCameraView(),
+            camera->getCameraProjection(),
+            GRID_COLUMNS,
+            row * GRID_COLUMNS);
 
     shader->release();
 }
 
-void GLWidget::renderShadingBall(QOpenGLShaderProgram *shader, float YOffset, bool isComputePointLight) {
+float GLWidget::gridRowOffset(GridRow row) {
+    // no default, a row added to GridRow without a height is a compiler warning
+    switch (row) {
+        case MetalMultipleScatteringRow: return 5.0f;
+        case MetalSingleScatteringRow: return 2.5f;
+        case DielectricMultipleScatteringRow: return -2.5f;
+        case DielectricSingleScatteringRow: return -5.0f;
+        case ShadingBallMultipleScatteringRow: return 1.5f;
+        case ShadingBallSlidersRow: return -1.5f;
+        case GridRowCount: break;
+    }
+    return 0.0f;
+}
+
+void GLWidget::renderShadingBall(QOpenGLShaderProgram *shader, GridRow row, bool isComputePointLight) {
     shader->bind();
 
     shader->setUniformValue("camPos", camera->getCameraPosition());
@@ -199,22 +209,12 @@ void GLWidget::renderShadingBall(QOpenGLShaderProgram *shader, float YOffset, bo
     shader->setUniformValue("uEavgLut", 8);
     EavgLUT->bind();
 
-    int nrColumns = 10;
-    float spacing = 3.0;
-    for (int col = 0; col < nrColumns; col++) {
-        shader->setUniformValue("roughnessMount", qBound(0.0f,(float)col / (float)(nrColumns - 1),1.0f));
-
-        model.setToIdentity();
-        model.translate(((float)col - ((float)nrColumns / 2.0f)) * spacing + 1.2f,
-                        YOffset,
-                        0.0f);
-
-        shadingBallGeo->drawGeometry(
-                shader,
-                model,
-                camera->getCameraView(),
-                camera->getCameraProjection());
-    }
+    shadingBallGeo->drawGeometryInstanced(
+            shader,
+            camera->getCameraView(),
+            camera->getCameraProjection(),
+            GRID_COLUMNS,
+            row * GRID_COLUMNS);
 }
 
 void GLWidget::resizeGL(int width, int height) {
@@ -222,130 +222,97 @@ void GLWidget::resizeGL(int width, int height) {
     qreal aspect = qreal(width) / qreal(height ? height : 1);
     camera->setCameraPerspective(aspect);
 
-    if (captureFBO != nullptr) {
-        delete captureFBO;
-        captureFBO = nullptr;
-    }
-    captureFBO = createFBOPointer(0);
-
     return QOpenGLWidget::resizeGL(width, height);
 }
 
 void GLWidget::initShaders() {
-    // for cube box
-    if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/cubemap.vs.glsl"))
-        close();
-    if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/equirectangular_to_map.fs.glsl"))
-        close();
-    if (!SHADER(0)->link())
-        close();
-    if (!SHADER(0)->bind())
-        close();
-
-    // irradiance
-    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/cubemap.vs.glsl"))
-        close();
-    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/irradiance_convolution.fs.glsl"))
-        close();
-    if (!SHADER(1)->link())
-        close();
-    if (!SHADER(1)->bind())
-        close();
-
-    // prefilter
-    if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/cubemap.vs.glsl"))
-        close();
-    if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/prefilter.fs.glsl"))
-        close();
-    if (!SHADER(2)->link())
-        close();
-    if (!SHADER(2)->bind())
-        close();
-
-    if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/pbr.vs.glsl"))
+    if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/pbr.vs.glsl"))
         close();
     if (renderCustomGeo) {
-        if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/multipleScatterPBR_Aguera.fs.glsl"))
+        if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/multipleScatterPBR_Aguera.fs.glsl"))
             close();
     }
     else {
-        if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/multipleScatterPBR.fs.glsl"))
+        if (!SHADER(0)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/multipleScatterPBR.fs.glsl"))
             close();
     }
-    if (!SHADER(3)->link())
-        close();
-    if (!SHADER(3)->bind())
-        close();
-
-    if (!SHADER(4)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/pbr.vs.glsl"))
-        close();
-    if (!SHADER(4)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/singleScatterPBR.fs.glsl"))
-        close();
-    if (!SHADER(4)->link())
+    if (!SHADER(0)->link())
         close();
-    if (!SHADER(4)->bind())
+    if (!SHADER(0)->bind())
         close();
 
-    if (!SHADER(5)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/brdf.vs.glsl"))
+    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/pbr.vs.glsl"))
         close();
-    if (!SHADER(5)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/brdf.fs.glsl"))
+    if (!SHADER(1)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/singleScatterPBR.fs.glsl"))
         close();
-    if (!SHADER(5)->link())
+    if (!SHADER(1)->link())
         close();
-    if (!SHADER(5)->bind())
+    if (!SHADER(1)->bind())
         close();
 
-    if (!SHADER(6)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/background.vs.glsl"))
+    if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/background.vs.glsl"))
         close();
-    if (!SHADER(6)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/background.fs.glsl"))
+    if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/background.fs.glsl"))
         close();
-    if (!SHADER(6)->link())
+    if (!SHADER(2)->link())
         close();
-    if (!SHADER(6)->bind())
+    if (!SHADER(2)->bind())
         close();
 
     if (renderCustomGeo) {
-        if (!SHADER(7)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/pbr.vs.glsl"))
+        if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/19_TheKullayContyApproximation/Shaders/pbr.vs.glsl"))
             close();
-        if (!SHADER(7)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/multipleScatterPBR_KullaContySliders.glsl"))
+        if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/19_TheKullayContyApproximation/Shaders/multipleScatterPBR_KullaContySliders.glsl"))
             close();
-        if (!SHADER(7)->link())
+        if (!SHADER(3)->link())
             close();
-        if (!SHADER(7)->bind())
+        if (!SHADER(3)->bind())
             close();
     }
 }
 
 void GLWidget::initGeometry() {
-    cubeGeometry = new CubeGeometry;
-    cubeGeometry->initGeometry();
-    cubeGeometry->setupAttributePointer(SHADER(0));
-
     sphereGeometry = new SphereGeometry;
     sphereGeometry->initGeometry();
-    sphereGeometry->setupAttributePointer(SHADER(3));
-
-    QuadGeometry = new RectangleGeometry;
-    QuadGeometry->initGeometry();
-    QuadGeometry->setupAttributePointer(SHADER(5));
+    sphereGeometry->setupAttributePointer(SHADER(0));
 
     skybox_geometry = new SkyboxGeometry;
     skybox_geometry->initGeometry();
-    skybox_geometry->setupAttributePointer(SHADER(6));
+    skybox_geometry->setupAttributePointer(SHADER(2));
 
     shadingBallGeo = new CustomGeometry(shadingBallGeoPath);
     shadingBallGeo->initGeometry();
-    shadingBallGeo->setupAttributePointer(SHADER(3));
+    shadingBallGeo->setupAttributePointer(SHADER(0));
     if (renderCustomGeo)
-        shadingBallGeo->setupAttributePointer(SHADER(7));
+        shadingBallGeo->setupAttributePointer(SHADER(3));
+
+    createInstanceBuffer();
+}
+
+void GLWidget::createInstanceBuffer() {
+    float spacing = 3.0;
+
+    // roughness goes from 0 to 1 along every row, rows only differ in height
+    QVector<InstanceData> instances(GridRowCount * GRID_COLUMNS);
+    for (int row = 0; row < GridRowCount; row++) {
+        for (int col = 0; col < GRID_COLUMNS; col++) {
+            model.setToIdentity();
+            model.translate(((float)col - ((float)GRID_COLUMNS / 2.0f)) * spacing + 1.2f,
+                            gridRowOffset(GridRow(row)),
+                            0.0f);
+
+            InstanceData &instance = instances[row * GRID_COLUMNS + col];
+            memcpy(instance.model, model.constData(), sizeof(instance.model));
+            instance.material = QVector4D(qBound(0.0f, (float)col / (float)(GRID_COLUMNS - 1), 1.0f), 0.0f, 0.0f, 0.0f);
+        }
+    }
+
+    glCreateBuffers(1, &instanceBuffer);
+    glNamedBufferStorage(instanceBuffer, instances.count() * sizeof(InstanceData), instances.constData(), 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_DATA_BINDING, instanceBuffer);
 }
 
 void GLWidget::initTexture() {
-    loadHDRTextrue();
-    generateEnvCubeMap(512);
-    generateIrradianceMap(128);
-    generatePrefilterMap(128);
-    generateBRDFMap(512);
 
     albedo_texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
     auto imageData = QImage(albedoTextureFilePath).convertToFormat(QImage::Format_RGBA8888);
@@ -371,211 +338,10 @@ void GLWidget::initTexture() {
     EavgLUT = new QOpenGLTexture(QImage(EavgLUTPath));
 }
 
-void GLWidget::loadHDRTextrue() {
-    int width, height, channels;
-    stbi_set_flip_vertically_on_load(true);
-    float *image = nullptr;
-    if (furnaceTest)
-        image = stbi_loadf("src/texture/HDR/Uniform.jpg", &width, &height, &channels, 0);
-    else
-        image = stbi_loadf("src/texture/HDR/newport_loft.hdr", &width, &height, &channels, 0);
-
-    hdrTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
-    hdrTexture->create();
-    hdrTexture->setSize(width, height, 1);
-    hdrTexture->setFormat(QOpenGLTexture::RGB32F);
-    hdrTexture->allocateStorage();
-
-    hdrTexture->setData(0,0,QOpenGLTexture::RGB,QOpenGLTexture::Float32, image,Q_NULLPTR);
-    hdrTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
-    hdrTexture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    hdrTexture->setMagnificationFilter(QOpenGLTexture::LinearMipMapLinear);
-
-    stbi_image_free(image);
-}
-
-void GLWidget::generateEnvCubeMap(int precision) {
-    envCubemap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-    envCubemap->create();
-    envCubemap->setSize(precision, precision, 3);
-    envCubemap->setFormat(QOpenGLTexture::RGB32F);
-    envCubemap->setMipLevels(envCubemap->maximumMipLevels());
-    envCubemap->allocateStorage();
-    envCubemap->bind();
-
-    envCubemap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    envCubemap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    envCubemap->setMagnificationFilter(QOpenGLTexture::Linear);
-}
-
-void GLWidget::generateIrradianceMap(int precision) {
-    irradianceMap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-    irradianceMap->create();
-    irradianceMap->setSize(precision, precision, 3);
-    irradianceMap->setFormat(QOpenGLTexture::RGB32F);
-    irradianceMap->allocateStorage();
-    irradianceMap->bind();
-
-    irradianceMap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    irradianceMap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    irradianceMap->setMagnificationFilter(QOpenGLTexture::Linear);
-}
-
-void GLWidget::generatePrefilterMap(int precision) {
-    prefilterMap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
-    prefilterMap->create();
-    prefilterMap->setSize(precision, precision, 3);
-    prefilterMap->setFormat(QOpenGLTexture::RGB32F);
-    prefilterMap->setMipLevels(prefilterMap->maximumMipLevels());
-    prefilterMap->allocateStorage();
-    prefilterMap->bind();
-
-    prefilterMap->setWrapMode(QOpenGLTexture::ClampToEdge);
-    prefilterMap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-    prefilterMap->setMagnificationFilter(QOpenGLTexture::Linear);
-    prefilterMap->generateMipMaps();
-}
-
-void GLWidget::generateBRDFMap(int precision) {
-    brdfLUTTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
-    brdfLUTTexture->create();
-    brdfLUTTexture->setSize(precision, precision, 3);
-    brdfLUTTexture->setFormat(QOpenGLTexture::RGB32F);prefilterMap->allocateStorage();
-    brdfLUTTexture->allocateStorage();
-    brdfLUTTexture->bind();
-
-    brdfLUTTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
-    brdfLUTTexture->setMinificationFilter(QOpenGLTexture::Linear);
-    brdfLUTTexture->setMagnificationFilter(QOpenGLTexture::Linear);
-}
-
-void GLWidget::renderEnvCubeMap(int precision) {
-    // rendering
-    SHADER(0)->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(0)->setUniformValue("equirectangularMap", 0);
-    hdrTexture->bind();
-    SHADER(0)->setUniformValue("projection", captureProjection);
-
-    glViewport(0, 0, precision * devicePixelRatio(), precision * devicePixelRatio());
-    captureFBO->bind();
-    for(int i=0; i<captureViews.count(); ++i) {
-        SHADER(0)->setUniformValue("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap->textureId(), 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        cubeGeometry->drawGeometry(
-                SHADER(0), hdrTexture);
-    }
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-
-    envCubemap->bind();
-    envCubemap->generateMipMaps();
-    envCubemap->release();
-}
-
-void GLWidget::renderIrradianceMap(int precision) {
-    // rendering
-    SHADER(1)->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(1)->setUniformValue("environmentMap", 0);
-    envCubemap->bind();
-    SHADER(1)->setUniformValue("projection", captureProjection);
-
-    glViewport(0, 0, precision * devicePixelRatio(), precision * devicePixelRatio());
-    captureFBO->bind();
-    for(int i=0; i<captureViews.count(); ++i) {
-        SHADER(1)->setUniformValue("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap->textureId(), 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        cubeGeometry->drawGeometry(
-                SHADER(1), envCubemap);
-    }
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-}
-
-void GLWidget::renderPrefilterMap(int precision) {
-    SHADER(2)->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    SHADER(2)->setUniformValue("environmentMap", 0);
-    envCubemap->bind();
-    SHADER(2)->setUniformValue("projection", captureProjection);
-
-    captureFBO->bind();
-    unsigned int maxMipLevels = prefilterMap->maximumMipLevels();
-    for (unsigned int mip = 0; mip < maxMipLevels; ++mip) {
-        unsigned int mipWidth  = 128 * std::pow(0.5, mip);
-        unsigned int mipHeight = 128 * std::pow(0.5, mip);
-
-        glViewport(0, 0, mipWidth * devicePixelRatio(), mipHeight * devicePixelRatio());
-        float roughness = (float)mip / (float)(maxMipLevels - 1);
-        SHADER(2)->setUniformValue("roughness", roughness);
-        for (int i=0; i<captureViews.count(); ++i) {
-            SHADER(2)->setUniformValue("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap->textureId(), mip);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            cubeGeometry->drawGeometry(
-                    SHADER(2), envCubemap);
-        }
-    }
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-}
-
-void GLWidget::renderBRDFMap(int precision) {
-    SHADER(5)->bind();
-
-    glViewport(0, 0, precision * devicePixelRatio(), precision * devicePixelRatio());
-    captureFBO->bind();
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture->textureId(), 0);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    QuadGeometry->drawGeometry(
-            SHADER(5));
-
-    QOpenGLFramebufferObject::bindDefault();
-    glViewport(0, 0, width() * devicePixelRatio(), height() * devicePixelRatio());
-}
-
 void GLWidget::glSetting() {
     // Enable depth buffer
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-
-    // Setting
-    captureProjection.setToIdentity();
-    captureProjection.perspective(90.0f, 1.0f, 0.1f, 10.0f);
-
-    QMatrix4x4 lookAt_1;
-    lookAt_1.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(1.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_2;
-    lookAt_2.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(-1.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_3;
-    lookAt_3.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f));
-    QMatrix4x4 lookAt_4;
-    lookAt_4.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f));
-    QMatrix4x4 lookAt_5;
-    lookAt_5.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    QMatrix4x4 lookAt_6;
-    lookAt_6.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f), QVector3D(0.0f, -1.0f, 0.0f));
-    captureViews << lookAt_1 << lookAt_2 << lookAt_3 << lookAt_4 << lookAt_5 << lookAt_6;
-}
-
-QOpenGLFramebufferObject* GLWidget::createFBOPointer(int sampleCount) {
-    QOpenGLFramebufferObjectFormat format;
-    format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-    format.setInternalTextureFormat(QOpenGLTexture::RGB32F);
-    format.setSamples(sampleCount);
-    format.setMipmap(true);
-
-    QSize frameBufferSize(width() * devicePixelRatio(), height() * devicePixelRatio());
-    return new QOpenGLFramebufferObject(frameBufferSize, format);
 }
 
 void GLWidget::cleanup() {
@@ -585,30 +351,25 @@ void GLWidget::cleanup() {
     qDeleteAll(programs);
     programs.clear();
     delete camera;
-    delete hdrTexture;
     delete envCubemap;
     delete irradianceMap;
     delete prefilterMap;
     delete brdfLUTTexture;
-    delete captureFBO;
-    delete cubeGeometry;
     delete skybox_geometry;
     delete sphereGeometry;
-    delete QuadGeometry;
     delete shadingBallGeo;
+    if (instanceBuffer)
+        glDeleteBuffers(1, &instanceBuffer);
 
     camera = nullptr;
-    hdrTexture = nullptr;
     envCubemap = nullptr;
     irradianceMap = nullptr;
     prefilterMap = nullptr;
     brdfLUTTexture = nullptr;
-    captureFBO = nullptr;
-    cubeGeometry = nullptr;
     skybox_geometry = nullptr;
     sphereGeometry = nullptr;
-    QuadGeometry = nullptr;
     shadingBallGeo = nullptr;
+    instanceBuffer = 0;
 
     doneCurrent();
 }
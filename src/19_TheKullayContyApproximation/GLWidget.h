@@ -13,17 +13,19 @@
 #include <QDebug>
 
 #include "Helper/Camera.h"
-#include "Helper/CubeGeometry.h"
 #include "Helper/SkyboxGeometry.h"
 #include "Helper/SphereGeometry.h"
-#include "Helper/RectangleGeometry.h"
 #include "Helper/CustomGeometry.h"
+#include "Helper/IBLPrecompute.h"
+
+// balls per row of the roughness grid
+#define GRID_COLUMNS 10
+// instance buffer of pbr.vs.glsl, one block of GRID_COLUMNS balls per row
+#define INSTANCE_DATA_BINDING 0
 
 class Camera;
-class CubeGeometry;
 class SkyboxGeometry;
 class SphereGeometry;
-class RectangleGeometry;
 class CustomGeometry;
 
 class GLWidget : public QOpenGLWidget, protected QOpenGLFunctions_4_5_Core {
@@ -39,6 +41,19 @@ public:
     bool zoomInProcessing = false;
 
 protected:
+    // every row any render pass draws, the instance buffer holds them one after another in this order
+    enum GridRow {
+        MetalMultipleScatteringRow,
+        MetalSingleScatteringRow,
+        DielectricMultipleScatteringRow,
+        DielectricSingleScatteringRow,
+        ShadingBallMultipleScatteringRow,
+        ShadingBallSlidersRow,
+        GridRowCount
+    };
+    // height of a row
+    static float gridRowOffset(GridRow row);
+
     void initializeGL() override;
     void resizeGL(int width, int height) override;
     void paintGL() override;
@@ -48,20 +63,11 @@ protected:
     void initTexture();
 
     void glSetting();
-    void loadHDRTextrue();
-    void generateEnvCubeMap(int precision);
-    void generateIrradianceMap(int precision);
-    void generatePrefilterMap(int precision);
-    void generateBRDFMap(int precision);
-    void renderEnvCubeMap(int precision);
-    void renderIrradianceMap(int precision);
-    void renderPrefilterMap(int precision);
-    void renderBRDFMap(int precision);
-
-    void renderSphere(QOpenGLShaderProgram *shader, float YOffset, bool metal, bool isComputePointLight);
-    void renderShadingBall(QOpenGLShaderProgram *shader, float YOffset, bool isComputePointLight);
 
-    QOpenGLFramebufferObject* createFBOPointer(int sampleCount=0);
+    // the instances of a row start at row * GRID_COLUMNS
+    void renderSphere(QOpenGLShaderProgram *shader, GridRow row, bool metal, bool isComputePointLight);
+    void renderShadingBall(QOpenGLShaderProgram *shader, GridRow row, bool isComputePointLight);
+    void createInstanceBuffer();
 
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
@@ -70,26 +76,18 @@ protected:
 
 private:
     QList<QOpenGLShaderProgram *> programs;
-    QOpenGLTexture *hdrTexture;
     QOpenGLTexture *envCubemap;
     QOpenGLTexture *irradianceMap;
     QOpenGLTexture *prefilterMap;
     QOpenGLTexture *brdfLUTTexture;
 
-    CubeGeometry *cubeGeometry;
     SkyboxGeometry *skybox_geometry;
     SphereGeometry *sphereGeometry;
-    RectangleGeometry *QuadGeometry;
 
     Camera *camera;
     QMatrix4x4 model;
     QPoint mousePos;
 
-    QOpenGLFramebufferObject *captureFBO;
-
-    QMatrix4x4 captureProjection;
-    QVector<QMatrix4x4> captureViews;
-
     bool furnaceTest = false;
     bool computePointLight = true;
     bool environmentCompensation = true;
@@ -98,6 +96,8 @@ private:
     QString shadingBallGeoPath = "src/18_ScreenSpaceReflection/Models/ShaderBall.obj";
     CustomGeometry *shadingBallGeo;
 
+    GLuint instanceBuffer = 0;
+
     // albedo texture
     QOpenGLTexture* albedo_texture;
     QString albedoTextureFilePath = "src/texture/PBR/gold/albedo.png";
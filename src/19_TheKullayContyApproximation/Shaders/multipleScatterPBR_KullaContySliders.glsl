@@ -25,7 +25,7 @@ uniform sampler2D normalMap;
 uniform sampler2D uEavgLut;
 
 uniform vec3 camPos;
-uniform float roughnessMount;
+flat in float InstanceRoughness;
 uniform bool computePointLight;
 uniform bool environmentCompensation;
 
@@ -118,7 +118,7 @@ void main()
 {
     vec3 albedo = texture(albedoMap, coord).rgb;
     float metallic = texture(metallicMap, coord).r;
-    float roughness = roughnessMount;
+    float roughness = InstanceRoughness;
     float ao = texture(aoMap, coord).r;
 
     vec3 N = getNormalFromMap();
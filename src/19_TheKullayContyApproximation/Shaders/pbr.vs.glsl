@@ -4,15 +4,28 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aCoord;
 layout (location = 2) in vec3 aNormal;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// model matrix and roughness (material.x) of every ball in the grid, indexed by instance
+struct InstanceData {
+    mat4 model;
+    vec4 material;
+};
+layout (std430, binding = 0) readonly buffer Instances {
+    InstanceData instances[];
+};
+
 out vec2 coord;
 out vec3 WorldPos;
 out vec3 Normal;
+flat out float InstanceRoughness;
 
 void main() {
+    InstanceData instance = instances[gl_BaseInstance + gl_InstanceID];
+    mat4 model = instance.model;
+    InstanceRoughness = instance.material.x;
+
     coord = aCoord;
     WorldPos = vec3(model * vec4(aPos, 1.0));
 
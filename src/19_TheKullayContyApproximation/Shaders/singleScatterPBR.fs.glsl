@@ -21,7 +21,7 @@ uniform vec3 camPos;
 // material parameters
 uniform vec3 albedo;
 uniform float metallic;
-uniform float roughness;
+flat in float InstanceRoughness;
 uniform float ao;
 
 uniform bool isMetal;
@@ -64,6 +64,7 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
 }
 
 void main() {
+    float roughness = InstanceRoughness;
     vec3 N = normalize(Normal);
     vec3 V = normalize(camPos - WorldPos);
     vec3 R = reflect(-V, N);
@@ -0,0 +1,224 @@
+#include <QGuiApplication>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDebug>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "Helper/CustomGeometry.h"
+#include "Helper/AnimationJobSystem.h"
+
+// every heap allocation of the process goes through here, so a section can report how many it made
+static std::atomic<quint64> allocationCount{0};
+
+#if defined(__GLIBC__)
+// malloc itself is replaced: QArrayData (QVector, QList, QString, QByteArray) allocates with malloc and
+// realloc directly, operator new ends up here too. glibc's own entry points do the actual work
+static const char *allocationCounter = "malloc, calloc, realloc, aligned (glibc interposition, includes operator new)";
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *p);
+
+void *malloc(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **p, size_t alignment, size_t size) {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    *p = __libc_memalign(alignment, size);
+    return *p ? 0 : ENOMEM;
+}
+
+void free(void *p) {
+    __libc_free(p);
+}
+}
+#else
+// no portable way to replace malloc, container growth through QArrayData is not counted here
+static const char *allocationCounter = "operator new only (misses QArrayData malloc/realloc)";
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
+
+struct Measure {
+    qint64 nanoseconds = 0;
+    quint64 allocations = 0;
+};
+
+template <typename Function>
+static Measure measure(int frames, Function function) {
+    // one untimed frame so lazily sized buffers do not count
+    function(0);
+
+    Measure result;
+    quint64 allocationsBefore = allocationCount.load();
+    QElapsedTimer timer;
+    timer.start();
+    for (int frame = 0; frame < frames; frame++)
+        function(frame);
+    result.nanoseconds = timer.nsecsElapsed();
+    result.allocations = allocationCount.load() - allocationsBefore;
+    return result;
+}
+
+static void report(const char *name, const Measure &result, int frames, qint64 units, const char *unitName) {
+    std::printf("  %-28s %10.1f us/frame %10.2f ns/%-12s %8.2f allocs/frame\n",
+                name,
+                result.nanoseconds / 1000.0 / frames,
+                units > 0 ? double(result.nanoseconds) / double(units) : 0.0,
+                unitName,
+                double(result.allocations) / frames);
+}
+
+// false when the file could not be loaded
+static bool benchmarkFile(const QString &path, int frames, int instances) {
+    CustomGeometry geometry(path);
+    geometry.initGeometry();
+    if (geometry.VerticesCount() == 0) {
+        std::fprintf(stderr, "ERROR::BENCHMARK:: %s: failed to load, no geometry\n", qPrintable(path));
+        return false;
+    }
+    if (!geometry.m_animationNum) {
+        std::printf("%s: no animation, skipped\n", qPrintable(path));
+        return true;
+    }
+    geometry.initAnimation();
+
+    Animation &clip = geometry.animation;
+    const float dt = 1.0f / 60.0f;
+    const int channelCount = clip.getChannelCount();
+    const int nodeCount = clip.getSkeleton().count();
+    const int targetCount = geometry.m_MorphData.targetCount();
+
+    Animator animator(&clip, &geometry, geometry.getBoneCount());
+    const int boneCount = animator.getBoneCount();
+
+    std::printf("%s\n  bones %d, channels %d, skeleton nodes %d, morph targets %d, frames %d, instances %d\n",
+                qPrintable(QFileInfo(path).fileName()), boneCount, channelCount, nodeCount, targetCount, frames, instances);
+
+    // full evaluation of one character: sampling, hierarchy, palette and blend shape weights
+    Measure single = measure(frames, [&](int) { animator.updateAnimation(dt); });
+    report("Animator::updateAnimation", single, frames, qint64(frames) * boneCount, "bone");
+
+    // the same with the base layer always crossfading, so every frame samples and blends two poses
+    Animator fading(&clip, &geometry, geometry.getBoneCount());
+    fading.play(&clip, 1.0e6f);
+    Measure crossfade = measure(frames, [&](int) { fading.updateAnimation(dt); });
+    report("Animator crossfade", crossfade, frames, qint64(frames) * boneCount, "bone");
+
+    // keyframe sampling alone, on private copies since Bone::update keeps its own cursor
+    QVector<Bone> bones;
+    for (int i = 0; i < channelCount; i++)
+        bones.push_back(clip.getBone(i));
+    float time = 0.0f;
+    Measure sampling = measure(frames, [&](int) {
+        time = fmod(time + clip.getTicksPerSecond() * dt, clip.getDuration());
+        for (auto &bone : bones)
+            bone.update(time);
+    });
+    report("Bone::update", sampling, frames, qint64(frames) * channelCount, "channel");
+
+    if (targetCount > 0) {
+        Animator morph(&clip, &geometry, geometry.getBoneCount());
+        Measure weights = measure(frames, [&](int frame) {
+            morph.setCurrentFrame(fmod(frame * clip.getTicksPerSecond() * dt, clip.getDuration()));
+            morph.calculateBlendShapeWeights();
+        });
+        report("calculateBlendShapeWeights", weights, frames, qint64(frames) * targetCount, "morph-weight");
+    }
+
+    // the whole crowd through the job system, as the example plays it
+    AnimationJobSystem jobs;
+    for (int i = 0; i < instances; i++)
+        jobs.addInstance(&geometry, 0.37f * i);
+    Measure crowd = measure(frames, [&](int) { jobs.update(dt); });
+    report("AnimationJobSystem::update", crowd, frames, qint64(frames) * instances * boneCount, "bone");
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    QGuiApplication app(argc, argv);
+
+    // usage: InHouse_SkeletalAnimationBenchmark [frames] [instances] [fbx files ...]
+    // the defaults are the animated models that ship with the example
+    QStringList arguments = app.arguments();
+    int frames = arguments.count() > 1 ? arguments[1].toInt() : 1000;
+    int instances = arguments.count() > 2 ? arguments[2].toInt() : 64;
+    QStringList files = arguments.mid(3);
+    if (files.isEmpty()) {
+        files << "src/20_SkeletalAnimation/resource/testBlendShape.fbx"
+              << "src/20_SkeletalAnimation/resource/testBlendShapePart.fbx"
+              << "src/20_SkeletalAnimation/resource/testBlendShapeTrans.fbx";
+    }
+
+    // geometry creates its buffers on construction, an offscreen context is enough
+    QSurfaceFormat format;
+    format.setVersion(4, 5);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    QOffscreenSurface surface;
+    surface.setFormat(format);
+    surface.create();
+    QOpenGLContext context;
+    context.setFormat(format);
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        qWarning() << "Failed to create OpenGL context";
+        return -1;
+    }
+
+    std::printf("allocs/frame counts: %s\n", allocationCounter);
+
+    int failures = 0;
+    for (const auto &file : files) {
+        if (!QFileInfo::exists(file)) {
+            std::fprintf(stderr, "ERROR::BENCHMARK:: %s: not found\n", qPrintable(file));
+            failures++;
+            continue;
+        }
+        if (!benchmarkFile(file, qMax(1, frames), qMax(1, instances)))
+            failures++;
+    }
+
+    context.doneCurrent();
+    return failures > 0 ? 1 : 0;
+}
@@ -10,13 +10,16 @@
 GLWidget::GLWidget(QWidget *parent)
         : QOpenGLWidget(parent),
           customGeometry(nullptr),
+          animationBuffer(nullptr),
           camera(nullptr),
           diffuseTexture(nullptr){
 
-    // Create two shader program
+    // Create four shader program
     // the first one use for offscreen rendering
     // the second for default framebuffer rendering
-    for (int i=0; i<2; i++) {
+    // the third blends the sparse blend shapes
+    // the fourth plays the baked animation
+    for (int i=0; i<4; i++) {
         programs.push_back(new QOpenGLShaderProgram(this));
     }
 
@@ -54,8 +57,11 @@ void GLWidget::initializeGL() {
     glSetting();
     initGeometry();
 
-    createBlendShapeTex(true);
+    createMorphBuffers();
     createUDIMTex();
+#if USE_BAKED_ANIMATION
+    createBakedAnimation();
+#endif
 
     if(customGeometry->m_animationNum){
         timer = new QTimer(this);
@@ -71,58 +77,114 @@ void GLWidget::paintGL() {
     glClearColor(0.15f, 0.15f, 0.15f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    SHADER(0)->bind();
+    textureStreamer->collect();
 
-    SHADER(0)->setUniformValue("NumAnimation", customGeometry->m_animationNum);
     float currentTime = elapsedTimer.elapsed() / 1000.0;
     deltaTime = currentTime - lastTime;
     lastTime = currentTime;
-    customGeometry->animator.updateAnimation(deltaTime);
-    QVector<QMatrix4x4> transforms = customGeometry->animator.getPoseTransforms();
-    SHADER(0)->setUniformValueArray("finalBonesMatrices", transforms.data(), transforms.size());
-    //qDebug() << transforms;
-    //qDebug() << customGeometry->animator.bsWeights.count();
-    SHADER(0)->setUniformValueArray("BlendShapeWeight", customGeometry->animator.bsWeights.data(), customGeometry->animator.bsWeights.count());
-    //qDebug() << "BlendShapeWeights: " << customGeometry->animator.bsWeights.count() << customGeometry->animator.bsWeights;
-    SHADER(0)->setUniformValue("NumBlendShapeWeight", customGeometry->animator.bsWeights.count());
-    SHADER(0)->setUniformValue("ScaleFactorX", scaleFactorX);
-    SHADER(0)->setUniformValue("ScaleFactorY", scaleFactorY);
-    SHADER(0)->setUniformValue("ScaleFactorZ", scaleFactorZ);
-    SHADER(0)->setUniformValueArray("BlendShapeSlice", customGeometry->blendShapeSlice.data(), customGeometry->blendShapeSlice.count());
-
-    SHADER(0)->setUniformValueArray("UdimQuadrant", udimQuadrant.data(), udimQuadrant.count());
-    SHADER(0)->setUniformValue("NumUdimQuadrant", udimQuadrant.count());
 
-    diffuseUDIMTex->bind(0);
-    SHADER(0)->setUniformValue("diffuseUDIM", 0);
+#if USE_BAKED_ANIMATION
+    // the bake did not fit in a texture
+    if (bakedPaletteTexture == nullptr)
+        return;
 
-    for (int i=0; i<blendShapeTexs.count(); i++) {
-        QString bsMap = QString("blendShapeMap[") + QString::number(i) + QString("]");
-        blendShapeTexs[i]->bind(i);
-        SHADER(0)->setUniformValue(bsMap.toStdString().c_str(), i);
-    }
+    // nothing to evaluate or upload, every vertex reads its bones for the current time from the texture
+    QOpenGLShaderProgram *program = SHADER(3);
+    program->bind();
+    program->setUniformValue("CurrentTime", currentTime);
+    program->setUniformValue("BakedBoneCount", bakedAnimation.boneCount());
+    program->setUniformValue("BakedFrameCount", bakedAnimation.frameCount());
+    program->setUniformValue("BakedFrameRate", bakedAnimation.frameRate());
+    bakedPaletteTexture->bind(1);
+    program->setUniformValue("BakedPalette", 1);
+    int numbersOfInstance = crowdPositions.count();
+    int baseInstance = 0;
+#else
+    QOpenGLShaderProgram *program = SHADER(0);
+    program->bind();
+
+    program->setUniformValue("NumAnimation", customGeometry->m_animationNum);
+    animationJobs.update(deltaTime);
+    uploadAnimationBuffer();
+    blendMorphTargets();
+
+    // palettes and blended shapes are all in buffers, the whole crowd is one draw
+    program->bind();
+    program->setUniformValue("BonesPerInstance", animationJobs.boneCount(0));
+    program->setUniformValue("VertexCount", int(customGeometry->verticesCount));
+    int numbersOfInstance = animationJobs.instanceCount();
+    // the crowd is the only user of the shared buffers, it starts at their first instance
+    int baseInstance = 0;
+#endif
+
+    program->setUniformValueArray("UdimQuadrant", udimQuadrant.data(), udimQuadrant.count());
+    program->setUniformValue("NumUdimQuadrant", udimQuadrant.count());
 
-    model.setToIdentity();
-    model.translate(QVector3D(0.0, -1.0, 0.0));
-    model.scale(0.1);
+    diffuseUDIMTex->bind(0);
+    program->setUniformValue("diffuseUDIM", 0);
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-    customGeometry->drawGeometry(
-            SHADER(0),
-            model,
+    customGeometry->drawGeometryInstanced(
+            program,
             camera->getCameraView(),
-            camera->getCameraProjection());
+            camera->getCameraProjection(),
+            numbersOfInstance,
+            baseInstance);
+
+#if !USE_BAKED_ANIMATION
+    animationBuffer->endFrame();
+#endif
 }
 
-void GLWidget::createUDIMTex(){
-    QVector<QImage> diffuseUIDMTexs;
-    diffuseUIDMTexs.push_back(QImage(QString("src/20_SkeletalAnimation/resource/images/Pure32bit_1001.png")).convertToFormat(QImage::Format_RGBA8888));
-    diffuseUIDMTexs.push_back(QImage(QString("src/20_SkeletalAnimation/resource/images/Pure32bit_1002.png")).convertToFormat(QImage::Format_RGBA8888));
-    diffuseUIDMTexs.push_back(QImage(QString("src/20_SkeletalAnimation/resource/images/Pure32bit_1003.png")).convertToFormat(QImage::Format_RGBA8888));
-    diffuseUIDMTexs.push_back(QImage(QString("src/20_SkeletalAnimation/resource/images/Pure32bit_1011.png")).convertToFormat(QImage::Format_RGBA8888));
-    diffuseUIDMTexs.push_back(QImage(QString("src/20_SkeletalAnimation/resource/images/Pure32bit_1012.png")).convertToFormat(QImage::Format_RGBA8888));
-    diffuseUIDMTexs.push_back(QImage(QString("src/20_SkeletalAnimation/resource/images/Pure32bit_1023.png")).convertToFormat(QImage::Format_RGBA8888));
+void GLWidget::uploadAnimationBuffer() {
+    char *frame = animationBuffer->beginFrame();
+
+    // palette as 3x4 rows, the last row of a bone matrix is always (0, 0, 0, 1)
+    const QVector<QMatrix4x4> &palettes = animationJobs.palettes();
+    float *palette = reinterpret_cast<float*>(frame);
+    for (int i = 0; i < palettes.count(); i++) {
+        const float *m = palettes[i].constData(); // column major
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 4; column++)
+                *palette++ = m[column * 4 + row];
+        }
+    }
+
+    float *models = reinterpret_cast<float*>(frame + paletteSectionSize);
+    for (int i = 0; i < animationJobs.instanceCount(); i++) {
+        model.setToIdentity();
+        model.translate(QVector3D(0.0, -1.0, 0.0) + crowdPositions[i]);
+        model.scale(0.1);
+        memcpy(models + i * 16, model.constData(), 16 * sizeof(float));
+    }
 
+    // the animators already produce one dense weight per target
+    const int targetCount = customGeometry->m_MorphData.targetCount();
+    float *weights = reinterpret_cast<float*>(frame + paletteSectionSize + modelSectionSize);
+    for (int i = 0; i < animationJobs.instanceCount(); i++)
+        memcpy(weights + i * targetCount, animationJobs.morphWeights(i).constData(), targetCount * sizeof(float));
+
+    animationBuffer->bindRange(BONE_PALETTE_BINDING, 0, paletteSectionSize);
+    animationBuffer->bindRange(INSTANCE_MODEL_BINDING, paletteSectionSize, modelSectionSize);
+    animationBuffer->bindRange(MORPH_WEIGHT_BINDING, paletteSectionSize + modelSectionSize, weightSectionSize);
+}
+
+void GLWidget::blendMorphTargets() {
+    const int numbersOfMorphVertex = customGeometry->m_MorphData.vertices.count();
+    if (numbersOfMorphVertex == 0)
+        return;
+
+    // one thread per moved vertex and instance, untouched vertices keep their zero offset
+    SHADER(2)->bind();
+    SHADER(2)->setUniformValue("NumMorphVertex", numbersOfMorphVertex);
+    SHADER(2)->setUniformValue("VertexCount", int(customGeometry->verticesCount));
+    SHADER(2)->setUniformValue("TargetCount", customGeometry->m_MorphData.targetCount());
+
+    glDispatchCompute((numbersOfMorphVertex + 63) / 64, animationJobs.instanceCount(), 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void GLWidget::createUDIMTex(){
     udimQuadrant.push_back(1001);
     udimQuadrant.push_back(1002);
     udimQuadrant.push_back(1003);
@@ -130,102 +192,82 @@ void GLWidget::createUDIMTex(){
     udimQuadrant.push_back(1012);
     udimQuadrant.push_back(1023);
 
-    diffuseUDIMTex = new QOpenGLTexture(QOpenGLTexture::Target::Target2DArray);
-    diffuseUDIMTex->create();
-    diffuseUDIMTex->setFormat(QOpenGLTexture::SRGB8);
-    diffuseUDIMTex->setSize(512, 512, 3);
-    diffuseUDIMTex->setLayers(6);
-    diffuseUDIMTex->allocateStorage();
+    // one layer per tile, in the order of udimQuadrant
+    QList<QString> tilePaths;
+    for (int tile : udimQuadrant)
+        tilePaths << QString("src/20_SkeletalAnimation/resource/images/Pure32bit_%1.png").arg(tile);
+    textureStreamer->loadArray(&diffuseUDIMTex, tilePaths, QOpenGLTexture::SRGB_DXT1);
+}
 
-    for(int i=0;i<6;i++){
-        diffuseUDIMTex->setData(0, i,QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, diffuseUIDMTexs[i].constBits());
+void GLWidget::createBakedAnimation() {
+    // reuse the bake of the last run when it was made from this model, clip and rate
+    if (!bakedAnimation.readFromDisk(BAKED_ANIMATION_CACHE) ||
+        !bakedAnimation.isBakeOf(&customGeometry->animation, customGeometry, BAKED_ANIMATION_FPS)) {
+        bakedAnimation.bake(&customGeometry->animation, customGeometry, BAKED_ANIMATION_FPS);
+        bakedAnimation.saveToDisk(BAKED_ANIMATION_CACHE);
     }
-}
 
-void GLWidget::createBlendShapeTex(bool write2disk) {
-    int bsDataLength = customGeometry->m_BSDATA.length();
-    qDebug() << "********** BlendShape Tex **********";
-    qDebug() << "BlendShapeDataLength: " << bsDataLength;
-
-    assert(bsDataLength == customGeometry->m_BSID);
-
-    for(int z=0;z<customGeometry->m_BSDATA.length();z++){
-        QVector<BlendShapePosition> currentBsData = customGeometry->m_BSDATA[z];
-        int currLenBsVertex = currentBsData.length();
-        int currBsNum = currentBsData[0].m_numAnimPos;
-        int texDepth = 4;
-        int precision = CustomGeometry::computeLevelByVCount(currLenBsVertex, 2);
-
-        QOpenGLTexture* blendShapeTex = new QOpenGLTexture(QOpenGLTexture::Target::Target2DArray);
-        blendShapeTex->create();
-        blendShapeTex->setFormat(QOpenGLTexture::RGBA32F);
-        blendShapeTex->setSize(precision, precision, 3);
-        blendShapeTex->setLayers(currBsNum);
-        blendShapeTex->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::Float32);
-
-        scaleFactorX = std::pow(2, int(std::round(customGeometry->scaleFactor.x()/2.0f) + 1));
-        scaleFactorY = std::pow(2, int(std::round(customGeometry->scaleFactor.y()/2.0f) + 1));
-        scaleFactorZ = std::pow(2, int(std::round(customGeometry->scaleFactor.z()/2.0f) + 1));
-
-        qDebug() << "precision: " << precision;
-        qDebug() << "scaleFactor: " << scaleFactorX << scaleFactorY << scaleFactorZ;
-        qDebug() << "currLenBsVertex: " << currLenBsVertex << " currBsNum: " << currBsNum;
-        for(int i=0; i<currBsNum;i++){
-            int halfIndex = precision*precision/2;
-            QVector<unsigned char> bsDataUc;
-            QVector<QVector4D> bsData;
-
-            bsDataUc.resize(precision*precision*texDepth);
-            bsDataUc.fill(0);
-            bsData.resize(precision*precision);
-            QVector4D empty(0.0, 0.0, 0.0, 1.0);
-            bsData.fill(empty);
-
-            for(int j=0; j<precision*precision; j++){
-                if(j == halfIndex)
-                    break;
-
-                QVector4D verData;
-                QVector4D norData;
-                verData = QVector4D(0.0, 0.0, 0.0, 1.0);
-                norData = QVector4D(0.0, 0.0, 0.0, 1.0);
-                if(j<currLenBsVertex){
-                    QVector3D deltaPos = (QVector3D(currentBsData[j].m_AnimDeltaPos[i].x() / float(scaleFactorX),
-                                                    currentBsData[j].m_AnimDeltaPos[i].y() / float(scaleFactorY),
-                                                    currentBsData[j].m_AnimDeltaPos[i].z() / float(scaleFactorZ))
-                                                            + QVector3D(1.0, 1.0, 1.0)) / 2.0;
-                    QVector3D deltaNor = (currentBsData[j].m_AnimDeltaNor[i] + QVector3D(1.0, 1.0, 1.0)) / 2.0;
-                    verData = QVector4D(deltaPos, 1.0f);
-                    norData = QVector4D(deltaNor, 1.0f);
-                }
-
-                bsData[j] = verData;
-                bsData[halfIndex+j] = norData;
-                // Debug
-                if(write2disk) {
-                    bsDataUc[j * 4 + 0] = verData.x() * 255;
-                    bsDataUc[j * 4 + 1] = verData.y() * 255;
-                    bsDataUc[j * 4 + 2] = verData.z() * 255;
-                    bsDataUc[j * 4 + 3] = 255;
-                    bsDataUc[(halfIndex + j) * 4 + 0] = norData.x() * 255;
-                    bsDataUc[(halfIndex + j) * 4 + 1] = norData.y() * 255;
-                    bsDataUc[(halfIndex + j) * 4 + 2] = norData.z() * 255;
-                    bsDataUc[(halfIndex + j) * 4 + 3] = 255;
-                }
-            }
-            // Write to disk
-            if(write2disk){
-                QImage image(bsDataUc.data(), precision, precision, QImage::Format_RGBA8888);
-                image.save(QString("src/20_SkeletalAnimation/resource/tmp/blendShapeTex")
-                    +QString::number(z)
-                    +QString("_")
-                    +QString::number(i)
-                    +QString(".png"));
-            }
-            blendShapeTex->setData(0, i, QOpenGLTexture::RGBA,QOpenGLTexture::Float32, bsData.constData());
-        }
-        blendShapeTexs.push_back(blendShapeTex);
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if (bakedAnimation.width() > maxTextureSize || bakedAnimation.height() > maxTextureSize) {
+        qDebug() << "ERROR::BAKEDANIMATION:: " << bakedAnimation.width() << "x" << bakedAnimation.height()
+                 << " texels exceed GL_MAX_TEXTURE_SIZE " << maxTextureSize;
+        return;
+    }
+
+    bakedPaletteTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    bakedPaletteTexture->create();
+    bakedPaletteTexture->setFormat(QOpenGLTexture::RGBA32F);
+    bakedPaletteTexture->setSize(bakedAnimation.width(), bakedAnimation.height());
+    bakedPaletteTexture->setMipLevels(1);
+    bakedPaletteTexture->allocateStorage();
+    bakedPaletteTexture->setData(QOpenGLTexture::RGBA, QOpenGLTexture::Float32, bakedAnimation.texels().constData());
+    // linear only ever mixes two frames, the shader samples the columns at their centers
+    bakedPaletteTexture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+    bakedPaletteTexture->setWrapMode(QOpenGLTexture::DirectionS, QOpenGLTexture::ClampToEdge);
+    bakedPaletteTexture->setWrapMode(QOpenGLTexture::DirectionT, QOpenGLTexture::Repeat);
+
+    // model matrix and time offset never change, upload them once
+    QVector<float> instanceData;
+    for (int i = 0; i < crowdPositions.count(); i++) {
+        model.setToIdentity();
+        model.translate(QVector3D(0.0, -1.0, 0.0) + crowdPositions[i]);
+        model.scale(0.1);
+        for (int j = 0; j < 16; j++)
+            instanceData.push_back(model.constData()[j]);
+        instanceData << 0.37f * i << 0.0f << 0.0f << 0.0f;
     }
+
+    glCreateBuffers(1, &bakedInstanceBuffer);
+    glNamedBufferStorage(bakedInstanceBuffer, qMax(1, instanceData.count()) * sizeof(float),
+                         instanceData.isEmpty() ? nullptr : instanceData.constData(), 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BAKED_INSTANCE_BINDING, bakedInstanceBuffer);
+}
+
+void GLWidget::createMorphBuffers() {
+    const SparseMorphData &morphData = customGeometry->m_MorphData;
+    qDebug() << "********** BlendShape Buffers **********";
+    qDebug() << "targets: " << morphData.targetCount() << " moved vertices: " << morphData.vertices.count()
+             << " sparse bytes: " << morphData.entries.count() * sizeof(MorphEntry);
+
+    glCreateBuffers(4, morphBuffers);
+
+    // empty storage is not allowed, keep at least one element so the bindings stay valid
+    glNamedBufferStorage(morphBuffers[0], qMax(1, morphData.vertices.count()) * sizeof(quint32),
+                         morphData.vertices.isEmpty() ? nullptr : morphData.vertices.constData(), 0);
+    glNamedBufferStorage(morphBuffers[1], morphData.vertexStart.count() * sizeof(quint32), morphData.vertexStart.constData(), 0);
+    glNamedBufferStorage(morphBuffers[2], qMax(1, morphData.entries.count()) * sizeof(MorphEntry),
+                         morphData.entries.isEmpty() ? nullptr : morphData.entries.constData(), 0);
+
+    // position and normal offset of every vertex of every instance, cleared once since only moved vertices get written
+    GLsizeiptr resultSize = GLsizeiptr(qMax(1u, customGeometry->verticesCount)) * qMax(1, animationJobs.instanceCount()) * 2 * sizeof(QVector4D);
+    glNamedBufferStorage(morphBuffers[3], resultSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glClearNamedBufferData(morphBuffers[3], GL_RGBA32F, GL_RGBA, GL_FLOAT, nullptr);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MORPH_VERTEX_BINDING, morphBuffers[0]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MORPH_VERTEX_START_BINDING, morphBuffers[1]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MORPH_ENTRY_BINDING, morphBuffers[2]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MORPH_RESULT_BINDING, morphBuffers[3]);
     qDebug() << "*********************";
 }
 
@@ -267,6 +309,16 @@ void GLWidget::initShaders() {
         close();
     if (!SHADER(1)->bind())
         close();
+    if (!SHADER(2)->addShaderFromSourceFile(QOpenGLShader::Compute, "src/20_SkeletalAnimation/shaders/morphBlend.cs.glsl"))
+        close();
+    if (!SHADER(2)->link())
+        close();
+    if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Vertex, "src/20_SkeletalAnimation/shaders/bakedAnimation.vs.glsl"))
+        close();
+    if (!SHADER(3)->addShaderFromSourceFile(QOpenGLShader::Fragment, "src/20_SkeletalAnimation/shaders/skeletalAnimation.fs.glsl"))
+        close();
+    if (!SHADER(3)->link())
+        close();
 }
 
 void GLWidget::initGeometry() {
@@ -277,10 +329,36 @@ void GLWidget::initGeometry() {
     customGeometry->setupTransformationAttribute();
     customGeometry->initAllocate();
     customGeometry->setupAttributePointer(SHADER(0));
+
+    // every character shares the geometry and the clip, only time and pose are per instance
+    for (int row = 0; row < CROWD_ROWS; row++) {
+        for (int column = 0; column < CROWD_COLUMNS; column++) {
+            float x = (column - (CROWD_COLUMNS - 1) * 0.5f) * 1.5f;
+            float z = -row * 1.5f;
+#if !USE_BAKED_ANIMATION
+            animationJobs.addInstance(customGeometry, 0.37f * crowdPositions.count());
+#endif
+            crowdPositions.push_back(QVector3D(x, 0.0f, z));
+        }
+    }
+
+#if !USE_BAKED_ANIMATION
+    // the baked path reads a texture instead, it has no per frame uploads
+    int numbersOfInstance = animationJobs.instanceCount();
+    animationBuffer = new PersistentBuffer;
+    paletteSectionSize = animationBuffer->align(qMax(1, animationJobs.palettes().count()) * 3 * sizeof(QVector4D));
+    modelSectionSize = animationBuffer->align(numbersOfInstance * 16 * sizeof(float));
+    weightSectionSize = animationBuffer->align(qMax(1, numbersOfInstance * customGeometry->m_MorphData.targetCount()) * sizeof(float));
+    animationBuffer->allocate(paletteSectionSize + modelSectionSize + weightSectionSize);
+#endif
 }
 
 void GLWidget::initTexture() {
-    diffuseTexture = new QOpenGLTexture(QImage(QString("src/20_SkeletalAnimation/resource/images/Pure24bit_1001.png")));
+    // decoded and uploaded in the background, a new frame is asked for whenever one is ready
+    textureStreamer = new TextureStreamer(this);
+    connect(textureStreamer, &TextureStreamer::textureReady, this, QOverload<>::of(&GLWidget::update));
+
+    textureStreamer->load(&diffuseTexture, "src/20_SkeletalAnimation/resource/images/Pure24bit_1001.png", QOpenGLTexture::RGBA8_UNorm);
     //blendShapeTex = new QOpenGLTexture(QOpenGLTexture::Target::Target2DArray);
 }
 
@@ -294,13 +372,27 @@ void GLWidget::cleanup() {
 
     qDeleteAll(programs);
     programs.clear();
+    // before the diffuse textures, it still owns the ones that are not swapped in
+    delete textureStreamer;
+    textureStreamer = nullptr;
     delete camera;
     delete customGeometry;
+    delete animationBuffer;
     delete diffuseTexture;
+    delete diffuseUDIMTex;
+    delete bakedPaletteTexture;
+    if (morphBuffers[0])
+        glDeleteBuffers(4, morphBuffers);
+    if (bakedInstanceBuffer)
+        glDeleteBuffers(1, &bakedInstanceBuffer);
 
     camera = nullptr;
     customGeometry = nullptr;
+    animationBuffer = nullptr;
     diffuseTexture = nullptr;
+    diffuseUDIMTex = nullptr;
+    bakedPaletteTexture = nullptr;
+    bakedInstanceBuffer = 0;
 
     doneCurrent();
 }
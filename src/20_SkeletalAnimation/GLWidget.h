@@ -16,6 +16,29 @@
 
 #include "Helper/Camera.h"
 #include "Helper/CustomGeometry.h"
+#include "Helper/AnimationJobSystem.h"
+#include "Helper/PersistentBuffer.h"
+#include "Helper/BakedAnimation.h"
+#include "Helper/TextureStreamer.h"
+
+// characters drawn as a CROWD_ROWS x CROWD_COLUMNS grid, all evaluated by one AnimationJobSystem
+#define CROWD_ROWS 1
+#define CROWD_COLUMNS 1
+
+// 1 plays the crowd from a baked palette texture instead of evaluating and skinning every animator on the cpu
+#define USE_BAKED_ANIMATION 0
+#define BAKED_ANIMATION_FPS 30.0f
+#define BAKED_ANIMATION_CACHE "src/20_SkeletalAnimation/resource/bakedAnimation.vat"
+
+// shader storage bindings of skeletalAnimation.vs.glsl and morphBlend.cs.glsl
+#define BONE_PALETTE_BINDING 1
+#define INSTANCE_MODEL_BINDING 2
+#define MORPH_WEIGHT_BINDING 3
+#define MORPH_VERTEX_BINDING 4
+#define MORPH_VERTEX_START_BINDING 5
+#define MORPH_ENTRY_BINDING 6
+#define MORPH_RESULT_BINDING 7
+#define BAKED_INSTANCE_BINDING 8
 
 class Camera;
 class CustomGeometry;
@@ -40,13 +63,13 @@ protected:
     void initGeometry();
     void initTexture();
     void updateFrame();
+    void uploadAnimationBuffer();
+    void blendMorphTargets();
 
     void glSetting();
 
-    unsigned int scaleFactorX;
-    unsigned int scaleFactorY;
-    unsigned int scaleFactorZ;
-    void createBlendShapeTex(bool);
+    void createMorphBuffers();
+    void createBakedAnimation();
     void createUDIMTex();
 
     void mousePressEvent(QMouseEvent *event) override;
@@ -57,10 +80,28 @@ protected:
 private:
     QList<QOpenGLShaderProgram*> programs;
     CustomGeometry *customGeometry;
+    AnimationJobSystem animationJobs;
+    QVector<QVector3D> crowdPositions;
+
+    // palettes, model matrices and blend shape weights of every instance, rewritten each frame
+    PersistentBuffer *animationBuffer;
+    int paletteSectionSize = 0;
+    int modelSectionSize = 0;
+    int weightSectionSize = 0;
+
+    // sparse blend shape deltas (vertices, vertex start, entries) and the blended offset of every vertex per instance
+    GLuint morphBuffers[4] = {0};
+
+    // baked clip and the static per instance data (model matrix, time offset) of the baked crowd
+    BakedAnimation bakedAnimation;
+    QOpenGLTexture *bakedPaletteTexture = nullptr;
+    GLuint bakedInstanceBuffer = 0;
+
+    // the diffuse textures stream in, placeholders until then
+    TextureStreamer *textureStreamer = nullptr;
     QOpenGLTexture *diffuseTexture;
-    QOpenGLTexture *diffuseUDIMTex;
+    QOpenGLTexture *diffuseUDIMTex = nullptr;
     QVector<int> udimQuadrant;
-    QVector<QOpenGLTexture*> blendShapeTexs;
 
     Camera *camera;
     QMatrix4x4 model;
@@ -0,0 +1,78 @@
+#version 460 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aCoord;
+layout (location = 2) in vec3 aNormal;
+layout (location = 6) in vec4 boneIds;
+layout (location = 7) in vec4 weights;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+const int MAX_BONE_INFLUENCE = 4;
+
+// baked palettes, 3 texels (rows of the affine 3x4) per bone and one row per frame, linear filtered and repeated along y
+uniform sampler2D BakedPalette;
+uniform int BakedBoneCount;
+uniform int BakedFrameCount;
+uniform float BakedFrameRate;
+uniform float CurrentTime;
+
+struct BakedInstanceData {
+    mat4 model;
+    vec4 timeOffset;
+};
+layout (std430, binding = 8) readonly buffer BakedInstance {
+    BakedInstanceData bakedInstance[];
+};
+
+out vec2 coord;
+out vec3 WorldPos;
+out vec3 Normal;
+out vec3 DebugColor;
+
+mat4 boneMatrix(int boneId, float v){
+    // sampling between two rows blends the neighbouring frames, the columns always hit texel centers
+    float u = (boneId * 3 + 0.5) / float(BakedBoneCount * 3);
+    float du = 1.0 / float(BakedBoneCount * 3);
+    vec4 row0 = texture(BakedPalette, vec2(u, v));
+    vec4 row1 = texture(BakedPalette, vec2(u + du, v));
+    vec4 row2 = texture(BakedPalette, vec2(u + 2.0 * du, v));
+    return transpose(mat4(row0, row1, row2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+void main() {
+    coord = aCoord;
+    BakedInstanceData instance = bakedInstance[gl_InstanceID];
+
+    float frame = mod((CurrentTime + instance.timeOffset.x) * BakedFrameRate, float(BakedFrameCount));
+    float v = (frame + 0.5) / float(BakedFrameCount);
+
+    ivec4 BoneIds = ivec4(int(boneIds.x), int(boneIds.y), int(boneIds.z), int(boneIds.w));
+
+    vec4 totalPosition = vec4(0.0f);
+    vec3 localNormal = vec3(0.0f);
+    // if current vertex that was't effected by any bone, we need restore the position of original
+    bool noteffected = true;
+    for(int i = 0 ; i < MAX_BONE_INFLUENCE ; i++)
+    {
+        if(BoneIds[i] == -1 || BoneIds[i] >= BakedBoneCount) {
+            continue;
+        }
+        noteffected = false;
+        mat4 bone = boneMatrix(BoneIds[i], v);
+        totalPosition += bone * vec4(aPos, 1.0f) * weights[i];
+        localNormal += mat3(bone) * aNormal * weights[i];
+    }
+    if(noteffected){
+        totalPosition = vec4(aPos, 1.0);
+        localNormal = aNormal;
+    }
+
+    mat3 normalMatrix = transpose(inverse(mat3(instance.model)));
+    Normal = normalize(normalMatrix * localNormal);
+    DebugColor = vec3(0.0);
+
+    WorldPos = vec3(instance.model * totalPosition);
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+}
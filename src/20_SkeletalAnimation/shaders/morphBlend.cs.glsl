@@ -0,0 +1,56 @@
+#version 460 core
+
+layout (local_size_x = 64) in;
+
+// TargetCount weights per instance
+layout (std430, binding = 3) readonly buffer MorphWeights {
+    float morphWeight[];
+};
+// vertices moved by at least one target
+layout (std430, binding = 4) readonly buffer MorphVertices {
+    uint morphVertex[];
+};
+// entries of morphVertex[k] are [morphVertexStart[k], morphVertexStart[k + 1])
+layout (std430, binding = 5) readonly buffer MorphVertexStart {
+    uint morphVertexStart[];
+};
+// x: target, yzw: half float deltas (pos.xy), (pos.z, nor.x), (nor.y, nor.z)
+layout (std430, binding = 6) readonly buffer MorphEntries {
+    uvec4 morphEntry[];
+};
+layout (std430, binding = 7) writeonly buffer MorphResult {
+    vec4 morphResult[];
+};
+
+uniform int NumMorphVertex;
+uniform int VertexCount;
+uniform int TargetCount;
+
+void main() {
+    int k = int(gl_GlobalInvocationID.x);
+    int instance = int(gl_GlobalInvocationID.y);
+    if (k >= NumMorphVertex)
+        return;
+
+    vec3 deltaPos = vec3(0.0);
+    vec3 deltaNor = vec3(0.0);
+    int weightBase = instance * TargetCount;
+
+    // each vertex gathers its own targets, no two threads write the same vertex
+    for (uint e = morphVertexStart[k]; e < morphVertexStart[k + 1]; e++) {
+        uvec4 entry = morphEntry[e];
+        float weight = morphWeight[weightBase + int(entry.x)];
+        if (weight == 0.0)
+            continue;
+
+        vec2 a = unpackHalf2x16(entry.y);
+        vec2 b = unpackHalf2x16(entry.z);
+        vec2 c = unpackHalf2x16(entry.w);
+        deltaPos += vec3(a, b.x) * weight;
+        deltaNor += vec3(b.y, c) * weight;
+    }
+
+    int dst = (instance * VertexCount + int(morphVertex[k])) * 2;
+    morphResult[dst] = vec4(deltaPos, 0.0);
+    morphResult[dst + 1] = vec4(deltaNor, 0.0);
+}
@@ -9,25 +9,26 @@ layout (location = 5) in vec4 aBlendShapeData;
 layout (location = 6) in vec4 boneIds;
 layout (location = 7) in vec4 weights;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
-const int MAX_BONES = 120;
-const int MAX_BLENDSHAPE = 200;
-const int MAX_BLENDPART = 20;
 const int MAX_BONE_INFLUENCE = 4;
-uniform mat4 finalBonesMatrices[MAX_BONES];
 
-uniform int ScaleFactorX;
-uniform int ScaleFactorY;
-uniform int ScaleFactorZ;
-uniform int NumBlendShapeWeight;
+// every instance's palette one after another, each bone stored as the 3 rows of an affine 3x4
+layout (std430, binding = 1) readonly buffer BonePalette {
+    vec4 bonePalette[];
+};
+layout (std430, binding = 2) readonly buffer InstanceModel {
+    mat4 instanceModel[];
+};
+// blend shapes already summed by morphBlend.cs.glsl, position and normal offset per vertex and instance
+layout (std430, binding = 7) readonly buffer MorphResult {
+    vec4 morphResult[];
+};
+uniform int BonesPerInstance;
+uniform int VertexCount;
+
 uniform int NumAnimation;
-uniform vec2 BlendShapeWeight[MAX_BLENDSHAPE];
-uniform vec4 BlendShapeSlice[MAX_BLENDSHAPE];
-uniform vec2 BlendShapePrecision[MAX_BLENDSHAPE];
-uniform sampler2DArray blendShapeMap[MAX_BLENDPART];
 
 uniform sampler2D HeightMap1;
 
@@ -38,78 +39,33 @@ out vec3 WorldPos;
 out vec3 Normal;
 out vec3 DebugColor;
 
-ivec2 getBlendShapeIDs(int vs_id){
-    int final_vs_id = -1;
-    int final_map_id = -1;
-    int bsNum = int(aBlendShapeData.x);
-    for(int i=0;i<bsNum;i++){
-        int head = int(BlendShapeSlice[i].x);
-        int end = int(BlendShapeSlice[i].y);
-        int bs_map_id = int(BlendShapeSlice[i].z);
-        int bs_length = end - head;
-
-        if(vs_id >= head && vs_id < end){
-            final_vs_id = vs_id - head;
-            final_map_id = bs_map_id;
-            break;
-        }
-    }
-    return ivec2(final_vs_id, final_map_id);
+// index into the shared buffers, a draw may start at any instance of them
+int instanceIndex() {
+    return gl_BaseInstance + gl_InstanceID;
+}
+
+mat4 boneMatrix(int boneId){
+    int base = (instanceIndex() * BonesPerInstance + boneId) * 3;
+    return transpose(mat4(bonePalette[base], bonePalette[base + 1], bonePalette[base + 2], vec4(0.0, 0.0, 0.0, 1.0)));
 }
 
 void main() {
     coord = aCoord;
+    mat4 model = instanceModel[instanceIndex()];
 
     ivec4 BoneIds = ivec4(int(boneIds.x), int(boneIds.y), int(boneIds.z), int(boneIds.w));
-    int blendShapeNum = int(aBlendShapeData.x);
-    vec3 BsMapPos = vec3(0.0);
-    vec3 BsMapNor = vec3(0.0);
     float bias = 0.25;
     float height = 0.0;
     float hscale = 0.0;
-    float bsscale = 0.0;
-    vec4 bsdebugcolor = vec4(0.0, 0.0, 0.0, 0.0);
 
     // Height map
     height = hscale * ((texture2D(HeightMap1, aCoord).r) - bias);
     vec3 hnormal = vec3(aNormal.x*height, aNormal.y*height, aNormal.z*height);
 
     // BlendShape
-    int Precision = int(aBlendShapeData.z);
-    ivec2 blendShapeIDs = getBlendShapeIDs(gl_VertexID);
-    int bsVsID = blendShapeIDs.x;
-    int bsMapID = blendShapeIDs.y;
-    if( bsVsID != -1
-        && blendShapeNum != 0
-        //&& bsMapID == 1 // for debug single blendshape
-    ){
-        int halfIndex = Precision*Precision/2;
-        int u = int(bsVsID % Precision);
-        int v = int(bsVsID / Precision);
-        ivec2 bsCoord = ivec2(u, v);
-        vec2 bsCoordf = vec2(u/float(Precision), v/float(Precision));
-        int u1 = int((bsVsID + halfIndex) % Precision);
-        int v1 = int((bsVsID + halfIndex) / Precision);
-        ivec2 bsCoord1 = ivec2(u1, v1);
-
-        // Compute BlendShape pos and Normal
-        for(int i=0; i < NumBlendShapeWeight; i++){
-            vec2 bsWeightData = BlendShapeWeight[i];
-            int bsMapID_iner = int(bsWeightData.x);
-
-            if(bsMapID_iner == bsMapID){ // found startup here and break after deal once;
-                for(int j=0;j<blendShapeNum;j++){
-                    float bsWeight = BlendShapeWeight[i+j].y;
-
-                    vec3 texBs = texelFetch(blendShapeMap[bsMapID], ivec3(bsCoord, j), 0).rgb * 2 - vec3(1.0);
-                    BsMapPos += vec3(texBs.r * ScaleFactorX, texBs.g * ScaleFactorY, texBs.b * ScaleFactorZ) * bsWeight;
-                    BsMapNor += (texelFetch(blendShapeMap[bsMapID], ivec3(bsCoord1, j), 0).rgb * 2 - vec3(1.0)) * bsWeight;
-                }
-
-                break;
-            }
-        }
-    }
+    int morphIndex = (instanceIndex() * VertexCount + gl_VertexID) * 2;
+    vec3 BsMapPos = morphResult[morphIndex].xyz;
+    vec3 BsMapNor = morphResult[morphIndex + 1].xyz;
 
     vec4 totalPosition = vec4(0.0f);
     vec3 localNormal = vec3(0.0f);
@@ -132,15 +88,16 @@ void main() {
             if(BoneIds[i] == -1) {
                 continue;
             }
-            if(BoneIds[i] >= MAX_BONES)
+            if(BoneIds[i] >= BonesPerInstance)
             {
                 totalPosition = vec4(newPos, 1.0);
                 break;
             }
             noteffected = false;
-            vec4 localPosition = finalBonesMatrices[BoneIds[i]] * vec4(newPos, 1.0f);
+            mat4 bone = boneMatrix(BoneIds[i]);
+            vec4 localPosition = bone * vec4(newPos, 1.0f);
             totalPosition += localPosition * weights[i];
-            localNormal += mat3(finalBonesMatrices[BoneIds[i]]) * newNor * weights[i];
+            localNormal += mat3(bone) * newNor * weights[i];
         }
         if(noteffected){
             totalPosition = vec4(newPos, 1.0);
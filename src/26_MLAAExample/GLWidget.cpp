@@ -125,26 +125,41 @@ void MainWidget::initializeGL() {
     // Textures
     this->initTexture();
 
-    // Buffer Texture
-    this->generateBufferTexture();
-
     // Geometry
     this->initGeometry();
 
+    this->glSetting();
+}
+
+void MainWidget::resizeGL(int width, int height) {
+    // render targets follow the window, they are allocated here and only here
+    this->deleteBuffers();
+
+    // Buffer Texture
+    this->generateBufferTexture();
+
     // Buffers
     this->initBuffers();
 
-    this->glSetting();
+    return QOpenGLWidget::resizeGL(width, height);
 }
 
 void MainWidget::paintGL() {
     if (this->myLevel > 0) {
-        // Pass - 1 Edge Detection
+        QVector2D resolution(1.0f / edgeRT->width(), 1.0f / edgeRT->height());
+
+        // Pass - 1 Edge Detection, the pixels it keeps are marked in the stencil
         this->edgeRT->bind();
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClearStencil(0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+        glEnable(GL_STENCIL_TEST);
+        glStencilFunc(GL_ALWAYS, 1, 0xFF);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 
         SHADER(1)->bind();
-        SHADER(1)->setUniformValue("resolution", QVector2D(1.0f / width(), 1.0f / height()));
+        SHADER(1)->setUniformValue("resolution", resolution);
 
         glActiveTexture(GL_TEXTURE0);
         SHADER(1)->setUniformValue("map", 0);
@@ -152,19 +167,23 @@ void MainWidget::paintGL() {
 
         gridGeometry->drawGeometry(SHADER(1));
 
+        // the passes below only touch the marked pixels
+        glStencilFunc(GL_EQUAL, 1, 0xFF);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+
         // Pass - 2 Blend Weight
         this->blendWeightRT->bind();
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
 
         SHADER(2)->bind();
-        SHADER(2)->setUniformValue("resolution", QVector2D(1.0f / width(), 1.0f / height()));
+        SHADER(2)->setUniformValue("resolution", resolution);
 
         SHADER(2)->setUniformValue("MAXSEARCHSTEPS", indexMapArea[myLevel]);
 
         glActiveTexture(GL_TEXTURE0);
         SHADER(2)->setUniformValue("edgesTex", 0);
-        auto *myEdgeTexture = new QOpenGLTexture(this->edgeRT->toImage().mirrored());
-        myEdgeTexture->bind();
+        glBindTexture(GL_TEXTURE_2D, this->edgeRT->texture());
 
         glActiveTexture(GL_TEXTURE1);
         SHADER(2)->setUniformValue("areaTex", 1);
@@ -172,19 +191,26 @@ void MainWidget::paintGL() {
 
         gridGeometry->drawGeometry(SHADER(2));
 
-        // After render, get texture from attachment
-        this->getBufferTexture();
-
-        // Pass - 3
+        // Pass - 3 Neighborhood Blending, the source as it is outside the stencil
         this->neighborhoodBlendingRT->bind();
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glDisable(GL_STENCIL_TEST);
+
+        SHADER(0)->bind();
+
+        glActiveTexture(GL_TEXTURE0);
+        SHADER(0)->setUniformValue("map", 0);
+        this->srcTexture->bind();
+
+        gridGeometry->drawGeometry(SHADER(0));
+
+        glEnable(GL_STENCIL_TEST);
 
         SHADER(3)->bind();
-        SHADER(3)->setUniformValue("resolution", QVector2D(1.0f / width(), 1.0f / height()));
+        SHADER(3)->setUniformValue("resolution", resolution);
 
         glActiveTexture(GL_TEXTURE0);
         SHADER(3)->setUniformValue("blendTex", 0);
-        glBindTexture(GL_TEXTURE_2D, bufferTextures[0]);
+        this->blendWeightBufferTexture->bind();
 
         glActiveTexture(GL_TEXTURE1);
         SHADER(3)->setUniformValue("colorTex", 1);
@@ -192,9 +218,11 @@ void MainWidget::paintGL() {
 
         glActiveTexture(GL_TEXTURE2);
         SHADER(3)->setUniformValue("alphaTex", 2);
-        glBindTexture(GL_TEXTURE_2D, bufferTextures[1]);
+        this->blendWeightAlphaBufferTexture->bind();
 
         gridGeometry->drawGeometry(SHADER(3));
+
+        glDisable(GL_STENCIL_TEST);
     }
 
     // ----- Go back to default buffer ----- //
@@ -207,8 +235,7 @@ void MainWidget::paintGL() {
     SHADER(0)->setUniformValue("map", 0);
 
     if (this->myLevel > 0) {
-        auto *myNeighborhoodBlendingTexture = new QOpenGLTexture(this->neighborhoodBlendingRT->toImage().mirrored());
-        myNeighborhoodBlendingTexture->bind();
+        glBindTexture(GL_TEXTURE_2D, this->neighborhoodBlendingRT->texture());
     } else {
         this->srcTexture->bind();
     }
@@ -269,18 +296,31 @@ void MainWidget::initTexture() {
     this->areaTexture = new QOpenGLTexture(QImage(QString("src/26_MLAAExample/Textures/AreaMaps/AreaMap9.tiff")).mirrored());
 }
 
+QSize MainWidget::frameBufferSize() const {
+    return {int(width() * devicePixelRatio()), int(height() * devicePixelRatio())};
+}
+
 void MainWidget::initBuffers() {
     QOpenGLFramebufferObjectFormat format;
-    QSize frameBufferSize(width() * devicePixelRatio(), height() * devicePixelRatio());
 
-    // edge detection
-    this->edgeRT = new QOpenGLFramebufferObject(frameBufferSize, format);
+    // one stencil for all three targets: the edges found in pass 1 mask passes 2 and 3
+    glGenRenderbuffers(1, &this->depthStencilBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->depthStencilBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, frameBufferSize().width(), frameBufferSize().height());
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // edge detection, read with bilinear filtering by the searches of pass 2
+    this->edgeRT = new QOpenGLFramebufferObject(frameBufferSize(), format);
+    glBindTexture(GL_TEXTURE_2D, this->edgeRT->texture());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
     // neighborhood blending
-    this->neighborhoodBlendingRT = new QOpenGLFramebufferObject(frameBufferSize, format);
+    this->neighborhoodBlendingRT = new QOpenGLFramebufferObject(frameBufferSize(), format);
 
     // blend weight
-    this->blendWeightRT = new QOpenGLFramebufferObject(frameBufferSize, format);
+    this->blendWeightRT = new QOpenGLFramebufferObject(frameBufferSize(), format);
     this->blendWeightRT->bind();
 
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->blendWeightBufferTexture->textureId(), 0);
@@ -289,6 +329,14 @@ void MainWidget::initBuffers() {
 
     unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
     glDrawBuffers(2, attachments);
+
+    for (auto renderTarget : {this->edgeRT, this->blendWeightRT, this->neighborhoodBlendingRT}) {
+        renderTarget->bind();
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->depthStencilBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            qDebug() << "ERROR::FRAMEBUFFER:: MLAA render target is not complete";
+    }
+    QOpenGLFramebufferObject::bindDefault();
 }
 
 void MainWidget::generateBufferTexture() {
@@ -297,48 +345,42 @@ void MainWidget::generateBufferTexture() {
 
     blendWeightBufferTexture->create();
     blendWeightBufferTexture->setFormat(QOpenGLTexture::RGB16F);
-    blendWeightBufferTexture->setSize(this->width(), this->height(), 1);
+    blendWeightBufferTexture->setSize(frameBufferSize().width(), frameBufferSize().height(), 1);
 
     // 分配内存
     blendWeightBufferTexture->allocateStorage(QOpenGLTexture::RGB, QOpenGLTexture::Float16);
+    blendWeightBufferTexture->setMinificationFilter(QOpenGLTexture::Nearest);
+    blendWeightBufferTexture->setMagnificationFilter(QOpenGLTexture::Nearest);
+    blendWeightBufferTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
 
     // ----- blend weight alpha texture ----- //
     blendWeightAlphaBufferTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
 
     blendWeightAlphaBufferTexture->create();
     blendWeightAlphaBufferTexture->setFormat(QOpenGLTexture::RGB16F);
-    blendWeightAlphaBufferTexture->setSize(this->width(), this->height(), 1);
+    blendWeightAlphaBufferTexture->setSize(frameBufferSize().width(), frameBufferSize().height(), 1);
 
     // 分配内存
     blendWeightAlphaBufferTexture->allocateStorage(QOpenGLTexture::RGB, QOpenGLTexture::Float16);
+    blendWeightAlphaBufferTexture->setMinificationFilter(QOpenGLTexture::Nearest);
+    blendWeightAlphaBufferTexture->setMagnificationFilter(QOpenGLTexture::Nearest);
+    blendWeightAlphaBufferTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
 }
 
-void MainWidget::getBufferTexture() {
-    bufferTextures.clear();
-    bufferTextures.resize(2);
-
-    QScopedPointer<QOpenGLFramebufferObject> tmpFBO;
-
-    for (int i = 0 ; i < 2; i++) {
-        tmpFBO.reset(new QOpenGLFramebufferObject(blendWeightRT->size()));
-        QOpenGLFramebufferObject::blitFramebuffer(
-                tmpFBO.data(),
-                QRect(0, 0, width(), height()),
-                blendWeightRT,
-                QRect(0, 0, width(), height()),
-                GL_COLOR_BUFFER_BIT,
-                GL_NEAREST,
-                i,
-                0);
-        // save to disk
-        if (i == 0) {
-            tmpFBO->toImage().save("src/26_MLAAExample/RenderOut/blendWeight.png");
-        } else if (i == 1) {
-            tmpFBO->toImage().save("src/26_MLAAExample/RenderOut/blendWeightAlpha.png");
-        }
-
-        bufferTextures[i] = tmpFBO->takeTexture(0);
-    }
+void MainWidget::deleteBuffers() {
+    delete edgeRT;
+    delete blendWeightRT;
+    delete neighborhoodBlendingRT;
+    delete blendWeightBufferTexture;
+    delete blendWeightAlphaBufferTexture;
+    glDeleteRenderbuffers(1, &depthStencilBuffer);
+
+    edgeRT = nullptr;
+    blendWeightRT = nullptr;
+    neighborhoodBlendingRT = nullptr;
+    blendWeightBufferTexture = nullptr;
+    blendWeightAlphaBufferTexture = nullptr;
+    depthStencilBuffer = 0;
 }
 
 void MainWidget::glSetting() {
@@ -354,23 +396,15 @@ void MainWidget::cleanup() {
     qDeleteAll(programs);
     programs.clear();
 
-    bufferTextures.clear();
+    this->deleteBuffers();
 
     delete gridGeometry;
     delete srcTexture;
     delete areaTexture;
-    delete edgeRT;
-    delete blendWeightRT;
-    delete neighborhoodBlendingRT;
 
     gridGeometry = nullptr;
     srcTexture = nullptr;
     areaTexture = nullptr;
-    edgeRT = nullptr;
-    blendWeightRT = nullptr;
-    neighborhoodBlendingRT = nullptr;
-    blendWeightBufferTexture = nullptr;
-    blendWeightAlphaBufferTexture = nullptr;
 
     doneCurrent();
 }
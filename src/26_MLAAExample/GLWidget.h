@@ -29,6 +29,7 @@ public:
 
 protected:
     void initializeGL() override;
+    void resizeGL(int width, int height) override;
     void paintGL() override;
 
     void initShaders();
@@ -36,7 +37,8 @@ protected:
     void initTexture();
     void initBuffers();
     void generateBufferTexture();
-    void getBufferTexture();
+    void deleteBuffers();
+    QSize frameBufferSize() const;
 
     void glSetting();
 
@@ -63,9 +65,10 @@ private:
     QOpenGLFramebufferObject *edgeRT;
     QOpenGLFramebufferObject *blendWeightRT;
     QOpenGLFramebufferObject *neighborhoodBlendingRT;
+    // shared by the three render targets, masks passes 2 and 3 to the edges
+    GLuint depthStencilBuffer = 0;
 
     // Output Color Attachment
-    QVector<GLuint> bufferTextures;
     QOpenGLTexture *blendWeightBufferTexture;
     QOpenGLTexture *blendWeightAlphaBufferTexture;
 
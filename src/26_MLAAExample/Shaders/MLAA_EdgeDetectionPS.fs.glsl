@@ -24,6 +24,15 @@ vec4 MLAAColorEdgeDetectionPS(vec2 texcoord, vec4 offset[2], sampler2D colorTex)
     t = abs( C - Ctop );
     delta.y = max( max( t.r, t.g ), t.b );
 
+    // 右边和下边的边只让这个像素进入模板, 混合时它也要向那些边采样
+    vec3 Cright = texture( colorTex, offset[1].xy ).rgb;
+    t = abs( C - Cright );
+    delta.z = max( max( t.r, t.g ), t.b );
+
+    vec3 Cbottom = texture( colorTex, offset[1].zw ).rgb;
+    t = abs( C - Cbottom );
+    delta.w = max( max( t.r, t.g ), t.b );
+
     // We do the usual threshold:
     vec4 edges = step( vec4(MLAA_THRESHOLD), delta.xyzw );
     // Then discard if there is no edge:
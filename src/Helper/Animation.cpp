@@ -1,6 +1,8 @@
 #include "Animation.h"
 #include "CustomGeometry.h"
 
+#include <QMatrix3x3>
+
 Animation::Animation(QString &animationPath, CustomGeometry* model) {
     // read file via ASSIMP
     Assimp::Importer importer;
@@ -17,6 +19,7 @@ Animation::Animation(QString &animationPath, CustomGeometry* model) {
 
     if(scene->mNumAnimations){
         auto animation = scene->mAnimations[0];
+        m_Name = QString(animation->mName.data);
         m_Duration = animation->mDuration;
 
         m_TicksPerSecond = animation->mTicksPerSecond;
@@ -25,6 +28,8 @@ Animation::Animation(QString &animationPath, CustomGeometry* model) {
 
         qDebug() << "Duration:" << m_Duration << "," << "Fps:" << m_TicksPerSecond;
     }
+
+    compileSkeleton();
 }
 
 void Animation::readHierarchyData(AssimpNodeData &dest, const aiNode *src) {
@@ -73,32 +78,38 @@ void Animation::setupBones(const aiAnimation *animation, CustomGeometry* model)
 
 void Animation::setupBlendShape(const aiAnimation *animation, CustomGeometry *model) {
     qDebug() << "NumMorphMeshChannels: " << animation->mNumMorphMeshChannels;
-    m_keyMorph.resize(animation->mNumMorphMeshChannels);
     qDebug() << "BlendShape Mesh Names: " << model->bsMeshOrderNames;
-    if(animation->mNumMorphMeshChannels){
 
-        for(int j=0;j<animation->mNumMorphMeshChannels;j++){
+    // one track per blend shape mesh, in the same order as the geometry's sparse targets
+    const QVector<int> &targetBase = model->m_MorphData.targetBase;
+    m_MorphTracks.resize(targetBase.count() - 1);
+    for (int i = 0; i < m_MorphTracks.count(); i++) {
+        m_MorphTracks[i].targetBase = targetBase[i];
+        m_MorphTracks[i].targetCount = targetBase[i + 1] - targetBase[i];
+    }
+
+    for(int j=0;j<animation->mNumMorphMeshChannels;j++){
         auto& channel = animation->mMorphMeshChannels[j];
-            QString channelQName(channel->mName.data);
-            std::string channelStrName = channelQName.toStdString();
-            channelStrName = channelStrName.substr(0, channelStrName.find_last_of("*"));
-            QString fixedChannelQName(channelStrName.data());
-            qDebug() << "handling channel name: " << channel->mName.data << channel->mNumKeys << fixedChannelQName;
-            if(channel->mNumKeys) {
-                QVector<KeyMorph> keyMorph;
-                for (int i = 0; i < channel->mNumKeys; ++i) {
-                    KeyMorph morph{};
-                    auto &key = channel->mKeys[i];
-                    morph.m_NumValuesAndWeights = key.mNumValuesAndWeights;  // same with bs length
-                    morph.m_Time = key.mTime;
-                    morph.m_Weights = new double[key.mNumValuesAndWeights];
-                    morph.m_Values = new unsigned int[key.mNumValuesAndWeights];
-                    std::copy(key.mWeights, key.mWeights + key.mNumValuesAndWeights, morph.m_Weights);
-                    std::copy(key.mValues, key.mValues + key.mNumValuesAndWeights, morph.m_Values);
-                    keyMorph.push_back(morph);
-                }
-                int bsIndex = model->bsMeshOrderNames.indexOf(fixedChannelQName);
-                m_keyMorph[bsIndex] = keyMorph;
+        QString channelQName(channel->mName.data);
+        std::string channelStrName = channelQName.toStdString();
+        channelStrName = channelStrName.substr(0, channelStrName.find_last_of("*"));
+        QString fixedChannelQName(channelStrName.data());
+        qDebug() << "handling channel name: " << channel->mName.data << channel->mNumKeys << fixedChannelQName;
+
+        int bsIndex = model->bsMeshOrderNames.indexOf(fixedChannelQName);
+        if (!channel->mNumKeys || bsIndex < 0 || bsIndex >= m_MorphTracks.count())
+            continue;
+
+        // dense weights per key, so sampling is a plain lerp of two rows
+        MorphTrack &track = m_MorphTracks[bsIndex];
+        track.keys.times.resize(channel->mNumKeys);
+        track.keys.values.fill(0.0f, channel->mNumKeys * track.targetCount);
+        for (int i = 0; i < channel->mNumKeys; ++i) {
+            auto &key = channel->mKeys[i];
+            track.keys.times[i] = key.mTime;
+            for (int k = 0; k < key.mNumValuesAndWeights; k++) {
+                if (key.mValues[k] < track.targetCount)
+                    track.keys.values[i * track.targetCount + key.mValues[k]] = key.mWeights[k];
             }
         }
     }
@@ -116,3 +127,60 @@ Bone *Animation::FindBone(const QString &name) {
     else
         return &(*iter);
 }
+
+void Animation::decomposeTransform(const QMatrix4x4 &transform, QVector3D &translation, QQuaternion &rotation, QVector3D &scale) {
+    translation = transform.column(3).toVector3D();
+
+    QVector3D axis[3] = {transform.column(0).toVector3D(), transform.column(1).toVector3D(), transform.column(2).toVector3D()};
+    scale = QVector3D(axis[0].length(), axis[1].length(), axis[2].length());
+    // a mirrored node keeps the flip in its scale, the rotation has to stay proper
+    if (QVector3D::dotProduct(QVector3D::crossProduct(axis[0], axis[1]), axis[2]) < 0.0f)
+        scale.setX(-scale.x());
+
+    QMatrix3x3 rotationMatrix;
+    for (int column = 0; column < 3; column++) {
+        float s = scale[column] != 0.0f ? 1.0f / scale[column] : 0.0f;
+        for (int row = 0; row < 3; row++)
+            rotationMatrix(row, column) = axis[column][row] * s;
+    }
+    rotation = QQuaternion::fromRotationMatrix(rotationMatrix).normalized();
+}
+
+void Animation::compileSkeleton() {
+    // resolve every name once, so evaluating a pose is a single pass over m_Skeleton
+    m_ChannelIndex.clear();
+    for (int i = 0; i < m_Bones.count(); i++)
+        m_ChannelIndex.insert(m_Bones[i].getBoneName(), i);
+
+    m_Skeleton.clear();
+
+    // depth first with an explicit stack, a node is always appended before its children
+    QVector<QPair<const AssimpNodeData*, int>> stack;
+    stack.push_back(qMakePair(&m_RootNode, -1));
+    while (!stack.isEmpty()) {
+        const AssimpNodeData *node = stack.last().first;
+        int parent = stack.last().second;
+        stack.pop_back();
+
+        SkeletonNode skeletonNode;
+        skeletonNode.parent = parent;
+        skeletonNode.channel = m_ChannelIndex.value(node->name, -1);
+        skeletonNode.boneId = -1;
+        skeletonNode.transformation = node->transformation;
+        skeletonNode.name = node->name;
+        decomposeTransform(node->transformation, skeletonNode.bindTranslation, skeletonNode.bindRotation, skeletonNode.bindScale);
+
+        auto boneInfo = m_BoneInfoMap.constFind(node->name);
+        if (boneInfo != m_BoneInfoMap.constEnd()) {
+            skeletonNode.boneId = boneInfo->id;
+            skeletonNode.offset = boneInfo->offset;
+        }
+
+        int index = m_Skeleton.count();
+        m_Skeleton.push_back(skeletonNode);
+
+        // reversed so children keep the hierarchy order
+        for (int i = node->childrenCount - 1; i >= 0; i--)
+            stack.push_back(qMakePair(&node->children[i], index));
+    }
+}
@@ -6,6 +6,7 @@
 
 #include <QString>
 #include <QMatrix4x4>
+#include <QHash>
 
 class CustomGeometry;
 
@@ -18,11 +19,27 @@ struct AssimpNodeData
 };
 
 
-struct KeyMorph {
-    double m_Time;
-    unsigned int *m_Values;
-    double *m_Weights;
-    unsigned int m_NumValuesAndWeights;
+// one node of the flattened hierarchy, parents always come before their children
+struct SkeletonNode
+{
+    int parent;                 // -1 for the root
+    int channel;                // index of the animated Bone, -1 if the node keeps its bind transform
+    int boneId;                 // slot in the pose transforms, -1 if nothing is skinned to it
+    QMatrix4x4 transformation;
+    QMatrix4x4 offset;
+    // transformation split up, used by nodes without a channel when poses are blended
+    QVector3D bindTranslation;
+    QQuaternion bindRotation;
+    QVector3D bindScale;
+    QString name;
+};
+
+
+// blend shape weights of one mesh, values holds targetCount weights per key (zero for targets the key leaves out)
+struct MorphTrack {
+    KeyTrack<float> keys;
+    int targetBase = 0;
+    int targetCount = 0;
 };
 
 
@@ -34,23 +51,34 @@ public:
     void setupBones(const aiAnimation* animation, CustomGeometry* model);
     void setupBlendShape(const aiAnimation* animation, CustomGeometry* model);
     Bone* FindBone(const QString& name);
+    void compileSkeleton();
 
     QMatrix4x4 convertAIMatrixToQtFormat(const aiMatrix4x4& from);
+    static void decomposeTransform(const QMatrix4x4& transform, QVector3D& translation, QQuaternion& rotation, QVector3D& scale);
 
     inline float getTicksPerSecond() { return m_TicksPerSecond; }
     inline float getDuration() { return m_Duration; }
+    inline const QString& getName() const { return m_Name; }
     inline const AssimpNodeData& getRootNode() { return m_RootNode; }
     inline const QMap<QString, BoneInfo>& getBoneIDMap() { return m_BoneInfoMap; }
-    inline const QVector<QVector<KeyMorph>> getKeyMorph() { return m_keyMorph; }
+    inline const QVector<MorphTrack>& getMorphTracks() const { return m_MorphTracks; }
+    inline const QVector<SkeletonNode>& getSkeleton() const { return m_Skeleton; }
+    inline const Bone& getBone(int channel) const { return m_Bones[channel]; }
+    inline int getChannelCount() const { return m_Bones.count(); }
+    // channel that animates the named node, -1 if this clip leaves it alone
+    inline int findChannel(const QString& name) const { return m_ChannelIndex.value(name, -1); }
 
 private:
+    QString m_Name;
     double m_Duration;
     double m_TicksPerSecond;
 
-    QVector<QVector<KeyMorph>> m_keyMorph;
+    QVector<MorphTrack> m_MorphTracks;
     AssimpNodeData m_RootNode;
     QVector<Bone> m_Bones;
     QMap<QString, BoneInfo> m_BoneInfoMap;
+    QVector<SkeletonNode> m_Skeleton;
+    QHash<QString, int> m_ChannelIndex;
 
 };
 
@@ -0,0 +1,32 @@
+#include "AnimationJobSystem.h"
+#include "CustomGeometry.h"
+
+int AnimationJobSystem::addInstance(CustomGeometry *geometry, float timeOffset) {
+    Instance instance;
+    instance.animator = Animator(&geometry->animation, geometry, geometry->getBoneCount());
+    instance.animator.setCurrentFrame(timeOffset * geometry->animation.getTicksPerSecond());
+    instance.paletteOffset = m_Palettes.count();
+    instance.boneCount = instance.animator.getBoneCount();
+
+    m_Palettes.resize(m_Palettes.count() + instance.boneCount);
+    m_Instances.push_back(instance);
+
+    return m_Instances.count() - 1;
+}
+
+void AnimationJobSystem::clear() {
+    m_Instances.clear();
+    m_Palettes.clear();
+}
+
+void AnimationJobSystem::update(float dt) {
+    // take the pointers before going wide so no thread triggers a detach
+    Instance *instances = m_Instances.data();
+    QMatrix4x4 *palettes = m_Palettes.data();
+    const int numbersOfInstance = m_Instances.count();
+
+#pragma omp parallel for schedule(dynamic, 1) if (numbersOfInstance > 1)
+    for (int i = 0; i < numbersOfInstance; i++) {
+        instances[i].animator.updateAnimation(dt, palettes + instances[i].paletteOffset);
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef QTREFERENCE_ANIMATIONJOBSYSTEM_H
+#define QTREFERENCE_ANIMATIONJOBSYSTEM_H
+
+#include "Animator.h"
+
+#include <QMatrix4x4>
+#include <QVector>
+
+class CustomGeometry;
+
+/*
+ * Plays many characters at once. Every instance owns an Animator (time and key cursors) while the
+ * clip data stays shared in the geometry's Animation, so update() can evaluate pose, hierarchy,
+ * skinning palette and blend shape weights of all instances in parallel. Palettes are written
+ * straight into one contiguous array, instance after instance, ready to be uploaded in one go.
+ */
+class AnimationJobSystem {
+public:
+    AnimationJobSystem() = default;
+
+    // timeOffset in seconds, staggers instances that play the same clip
+    int addInstance(CustomGeometry *geometry, float timeOffset = 0.0f);
+    void clear();
+
+    void update(float dt);
+
+    int instanceCount() const { return m_Instances.count(); }
+    int boneCount(int instance) const { return m_Instances[instance].boneCount; }
+    int paletteOffset(int instance) const { return m_Instances[instance].paletteOffset; }
+
+    const QVector<QMatrix4x4>& palettes() const { return m_Palettes; }
+    const QMatrix4x4* palette(int instance) const { return m_Palettes.constData() + m_Instances[instance].paletteOffset; }
+    const QVector<float>& morphWeights(int instance) const { return m_Instances[instance].animator.getMorphWeights(); }
+
+private:
+    struct Instance {
+        Animator animator;
+        int paletteOffset;
+        int boneCount;
+    };
+
+    QVector<Instance> m_Instances;
+    QVector<QMatrix4x4> m_Palettes;
+};
+
+
+#endif
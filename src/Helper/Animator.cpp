@@ -3,66 +3,257 @@
 
 Animator::Animator(Animation* current, CustomGeometry* geometry, int& boneCount) {
     m_CurrentAnimation = current;
-    m_CurrentFrame = 0.0;
     m_Transforms.resize(boneCount);
+    m_MorphWeights.fill(0.0f, geometry->m_MorphData.targetCount());
     m_Geometry = geometry;
+
+    int nodeCount = current ? current->getSkeleton().count() : 0;
+    m_GlobalTransforms.resize(nodeCount);
+    m_Pose.resize(nodeCount);
+    m_LayerPose.resize(nodeCount);
+    m_FadePose.resize(nodeCount);
+
+    m_Layers.resize(1);
+    if (current)
+        startClip(m_Layers[0].current, current, false);
 }
 
 void Animator::updateAnimation(float dt) {
+    updateAnimation(dt, m_Transforms.data());
+}
+
+void Animator::updateAnimation(float dt, QMatrix4x4 *palette) {
     m_DeltaTime = dt;
 
     if (m_CurrentAnimation) {
-        m_CurrentFrame += m_CurrentAnimation->getTicksPerSecond() * dt;
-        m_CurrentFrame = fmod(m_CurrentFrame, m_CurrentAnimation->getDuration());
-        calculateBoneTransform(&m_CurrentAnimation->getRootNode(), QMatrix4x4());
-        calculateBlendShapePosition(m_CurrentAnimation->getKeyMorph());
+        for (auto &layer : m_Layers) {
+            advanceClip(layer.current, dt);
+            if (layer.previous.clip) {
+                advanceClip(layer.previous, dt);
+                layer.fadeTime += dt;
+                if (layer.fadeTime >= layer.fadeDuration)
+                    layer.previous.clip = nullptr;
+            }
+        }
+        calculateBoneTransform(palette);
+        calculateBlendShapeWeights();
+    }
+}
+
+void Animator::play(Animation *clip, float fadeDuration, int layer) {
+    Q_ASSERT(m_CurrentAnimation && layer >= 0 && layer < m_Layers.count());
+    AnimationLayer &target = m_Layers[layer];
+
+    // the outgoing clip keeps its time and cursors, only the state objects swap
+    if (fadeDuration > 0.0f && target.current.clip) {
+        qSwap(target.previous, target.current);
+        target.fadeTime = 0.0f;
+        target.fadeDuration = fadeDuration;
     }
+    else {
+        target.previous.clip = nullptr;
+    }
+    startClip(target.current, clip, target.additive);
 }
 
-void Animator::calculateBoneTransform(const AssimpNodeData *node, QMatrix4x4 parentTransform) {
-    QString nodeName = node->name;
-    QMatrix4x4 nodeTransform = node->transformation;
+int Animator::addLayer(bool additive, float weight) {
+    AnimationLayer layer;
+    layer.additive = additive;
+    layer.weight = weight;
+    m_Layers.push_back(layer);
+    return m_Layers.count() - 1;
+}
 
-    Bone* bone = m_CurrentAnimation->FindBone(nodeName);
+void Animator::setLayerMask(int layer, const QString &rootNode, float weight) {
+    const QVector<SkeletonNode> &skeleton = m_CurrentAnimation->getSkeleton();
+    QVector<float> &mask = m_Layers[layer].mask;
+    QVector<bool> inside(skeleton.count(), false);
+    mask.fill(0.0f, skeleton.count());
 
-    if (bone) {
-        bone->update(m_CurrentFrame);
-        nodeTransform = bone->getLocalTransform();
+    // parents come first, so a node is inside the subtree as soon as its parent is
+    for (int i = 0; i < skeleton.count(); i++) {
+        const SkeletonNode &node = skeleton[i];
+        inside[i] = node.name == rootNode || (node.parent >= 0 && inside[node.parent]);
+        if (inside[i])
+            mask[i] = weight;
     }
+}
 
-    QMatrix4x4 globalTransformation = parentTransform * nodeTransform;
+void Animator::startClip(ClipState &state, Animation *clip, bool additive) {
+    const QVector<SkeletonNode> &skeleton = m_CurrentAnimation->getSkeleton();
+    state.clip = clip;
+    state.time = 0.0f;
+    if (!clip) {
+        state.nodeChannel.fill(-1, skeleton.count());
+        return;
+    }
 
-    auto boneInfoMap = m_CurrentAnimation->getBoneIDMap();
+    state.cursors.fill(BoneCursor(), clip->getChannelCount());
+    state.morphCursors.fill(0, clip->getMorphTracks().count());
 
-    if (boneInfoMap.find(nodeName) != boneInfoMap.end()) {  // found
-        int index = boneInfoMap[nodeName].id;
-        QMatrix4x4 offset = boneInfoMap[nodeName].offset;
-        m_Transforms[index] = globalTransformation * offset;
+    // resolve names once per play, sampling only follows indices
+    state.nodeChannel.resize(skeleton.count());
+    for (int i = 0; i < skeleton.count(); i++)
+        state.nodeChannel[i] = clip == m_CurrentAnimation ? skeleton[i].channel : clip->findChannel(skeleton[i].name);
+
+    if (additive) {
+        state.reference.resize(skeleton.count());
+        samplePose(state, state.reference);
     }
-    for (int i = 0; i < node->childrenCount; i++)
-        calculateBoneTransform(&node->children[i], globalTransformation);
 }
 
-void Animator::calculateBlendShapePosition(QVector<QVector<KeyMorph>> km ) {
-    if(km.empty())
+void Animator::advanceClip(ClipState &state, float dt) {
+    if (!state.clip)
         return;
-    if(bsWeights.count() > maxBlendShape){
-        qDebug() << "Over maximum limit of blendShape";
+
+    state.time += state.clip->getTicksPerSecond() * dt;
+    if (state.clip->getDuration() > 0.0f)
+        state.time = fmod(state.time, state.clip->getDuration());
+}
+
+void Animator::samplePose(ClipState &state, Pose &pose) {
+    const QVector<SkeletonNode> &skeleton = m_CurrentAnimation->getSkeleton();
+    for (int i = 0; i < skeleton.count(); i++) {
+        int channel = state.nodeChannel[i];
+        if (channel >= 0) {
+            state.clip->getBone(channel).sample(state.time, state.cursors[channel],
+                                                pose.translations[i], pose.rotations[i], pose.scales[i]);
+        }
+        else {
+            pose.translations[i] = skeleton[i].bindTranslation;
+            pose.rotations[i] = skeleton[i].bindRotation;
+            pose.scales[i] = skeleton[i].bindScale;
+        }
+    }
+}
+
+void Animator::evaluateLayer(AnimationLayer &layer) {
+    float fade = layer.isFading() ? layer.fadeTime / layer.fadeDuration : 1.0f;
+
+    if (layer.additive) {
+        // each clip adds its own motion, weighted by how far the fade has come
+        samplePose(layer.current, m_LayerPose);
+        addPose(m_Pose, m_LayerPose, layer.current.reference, layer.weight * fade, layer.mask);
+        if (fade < 1.0f) {
+            samplePose(layer.previous, m_LayerPose);
+            addPose(m_Pose, m_LayerPose, layer.previous.reference, layer.weight * (1.0f - fade), layer.mask);
+        }
         return;
     }
-    bsWeights.clear();
 
-    // TODO optimise interpolation
-    int bsIndex0 = int(m_CurrentFrame);
-    for(int i=0; i<km.length(); i++){
-        QVector<KeyMorph> keysMorph = km[i];
-        unsigned int bsWeightLength = keysMorph[bsIndex0].m_NumValuesAndWeights;  // same with bs length
+    samplePose(layer.current, m_LayerPose);
+    if (fade < 1.0f) {
+        samplePose(layer.previous, m_FadePose);
+        blendPose(m_FadePose, m_LayerPose, fade, QVector<float>());
+        qSwap(m_FadePose, m_LayerPose);
+    }
+    blendPose(m_Pose, m_LayerPose, layer.weight, layer.mask);
+}
+
+void Animator::calculateBoneTransform(QMatrix4x4 *palette) {
+    const QVector<SkeletonNode>& skeleton = m_CurrentAnimation->getSkeleton();
+
+    // base layer straight into the result, the common single clip case never blends
+    AnimationLayer &base = m_Layers[0];
+    samplePose(base.current, m_Pose);
+    if (base.isFading()) {
+        samplePose(base.previous, m_FadePose);
+        blendPose(m_FadePose, m_Pose, base.fadeTime / base.fadeDuration, QVector<float>());
+        qSwap(m_FadePose, m_Pose);
+    }
+
+    for (int i = 1; i < m_Layers.count(); i++) {
+        if (m_Layers[i].current.clip && m_Layers[i].weight > 0.0f)
+            evaluateLayer(m_Layers[i]);
+    }
+
+    // parents come first, so their global transform is always ready
+    for (int i = 0; i < skeleton.count(); i++) {
+        const SkeletonNode &node = skeleton[i];
+
+        QMatrix4x4 nodeTransform = Bone::composeTransform(m_Pose.translations[i], m_Pose.rotations[i], m_Pose.scales[i]);
+        m_GlobalTransforms[i] = node.parent < 0 ? nodeTransform : m_GlobalTransforms[node.parent] * nodeTransform;
 
-        for(int j=0; j<bsWeightLength; j++){
-            QVector2D weightData;
-            weightData.setX( i );
-            weightData.setY( keysMorph[bsIndex0].m_Weights[j] );
-            bsWeights.append( weightData ); // combine them all into one array and will deal that in vs shader
+        if (node.boneId >= 0) {
+            Q_ASSERT(node.boneId < m_Transforms.count());
+            palette[node.boneId] = m_GlobalTransforms[i] * node.offset;
         }
     }
 }
+
+void Animator::blendPose(Pose &dst, const Pose &src, float weight, const QVector<float> &mask) {
+    const int count = dst.count();
+    const float *nodeWeight = mask.isEmpty() ? nullptr : mask.constData();
+    QVector3D *t = dst.translations.data();
+    QQuaternion *r = dst.rotations.data();
+    QVector3D *s = dst.scales.data();
+    const QVector3D *srcT = src.translations.constData();
+    const QQuaternion *srcR = src.rotations.constData();
+    const QVector3D *srcS = src.scales.constData();
+
+    // one component array at a time, plain lerps the compiler can vectorize
+#pragma omp simd
+    for (int i = 0; i < count; i++) {
+        float w = nodeWeight ? weight * nodeWeight[i] : weight;
+        t[i] += (srcT[i] - t[i]) * w;
+        s[i] += (srcS[i] - s[i]) * w;
+    }
+
+    // nlerp along the shorter arc, close enough to slerp for the small angles between poses
+    for (int i = 0; i < count; i++) {
+        float w = nodeWeight ? weight * nodeWeight[i] : weight;
+        if (w <= 0.0f)
+            continue;
+        float sign = QQuaternion::dotProduct(r[i], srcR[i]) < 0.0f ? -1.0f : 1.0f;
+        r[i] = (r[i] * (1.0f - w) + srcR[i] * (sign * w)).normalized();
+    }
+}
+
+void Animator::addPose(Pose &dst, const Pose &src, const Pose &reference, float weight, const QVector<float> &mask) {
+    const int count = dst.count();
+    const float *nodeWeight = mask.isEmpty() ? nullptr : mask.constData();
+
+    for (int i = 0; i < count; i++) {
+        float w = nodeWeight ? weight * nodeWeight[i] : weight;
+        if (w <= 0.0f)
+            continue;
+
+        dst.translations[i] += (src.translations[i] - reference.translations[i]) * w;
+
+        QVector3D scaleDelta = src.scales[i] / reference.scales[i];
+        dst.scales[i] *= QVector3D(1.0f, 1.0f, 1.0f) + (scaleDelta - QVector3D(1.0f, 1.0f, 1.0f)) * w;
+
+        // delta rotation scaled toward identity, then applied in the node's local space
+        QQuaternion delta = src.rotations[i] * reference.rotations[i].conjugated();
+        if (delta.scalar() < 0.0f)
+            delta = -delta;
+        delta = (QQuaternion() * (1.0f - w) + delta * w).normalized();
+        dst.rotations[i] = (delta * dst.rotations[i]).normalized();
+    }
+}
+
+void Animator::calculateBlendShapeWeights() {
+    // blend shapes follow the base layer's clip, they only fit the geometry the clip was loaded for
+    ClipState &state = m_Layers[0].current;
+    if (!state.clip)
+        return;
+    const QVector<MorphTrack> &tracks = state.clip->getMorphTracks();
+    float *weights = m_MorphWeights.data();
+
+    for (int i = 0; i < tracks.count(); i++) {
+        const MorphTrack &track = tracks[i];
+        if (track.keys.count() == 0 || track.targetBase + track.targetCount > m_MorphWeights.count())
+            continue;
+
+        // the same key search as the bones, so any dt lands on the same weights
+        int key = track.keys.findKey(state.time, state.morphCursors[i]);
+        int nextKey = qMin(key + 1, track.keys.count() - 1);
+        float factor = nextKey > key ? track.keys.factor(key, state.time) : 0.0f;
+
+        const float *w0 = track.keys.values.constData() + key * track.targetCount;
+        const float *w1 = track.keys.values.constData() + nextKey * track.targetCount;
+        float *dst = weights + track.targetBase;
+        for (int j = 0; j < track.targetCount; j++)
+            dst[j] = w0[j] + (w1[j] - w0[j]) * factor;
+    }
+}
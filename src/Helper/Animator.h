@@ -8,25 +8,100 @@
 
 class Animation;
 
+// local transform of every skeleton node, one array per component so blending runs straight down each array
+struct Pose {
+    QVector<QVector3D> translations;
+    QVector<QQuaternion> rotations;
+    QVector<QVector3D> scales;
+
+    int count() const { return translations.count(); }
+    void resize(int count) {
+        translations.resize(count);
+        rotations.resize(count);
+        scales.resize(count);
+    }
+};
+
+// one clip being played, the cursors and node mapping are per player so clips stay shared
+struct ClipState {
+    Animation *clip = nullptr;
+    float time = 0.0f;
+    QVector<BoneCursor> cursors;
+    QVector<int> morphCursors;
+    // channel of clip driving each skeleton node, -1 keeps the bind transform
+    QVector<int> nodeChannel;
+    // first frame of the clip, additive layers only apply the difference to it
+    Pose reference;
+};
+
+/*
+ * Layer 0 is the base pose, every further layer is blended over it in order, either replacing it
+ * by weight (override) or adding its motion relative to its first frame (additive). Each layer
+ * crossfades on its own when a new clip is played, and a mask limits it to a part of the skeleton.
+ */
+struct AnimationLayer {
+    ClipState current;
+    ClipState previous;
+    float fadeTime = 0.0f;
+    float fadeDuration = 0.0f;
+    float weight = 1.0f;
+    bool additive = false;
+    // weight per skeleton node, empty affects every node
+    QVector<float> mask;
+
+    bool isFading() const { return previous.clip && fadeTime < fadeDuration; }
+};
+
 class Animator {
 public:
     Animator() = default;
     explicit Animator(Animation* current, CustomGeometry* geometry, int& boneCount);
     void updateAnimation(float dt);
-    void calculateBoneTransform(const AssimpNodeData* node, QMatrix4x4 parentTransform);
-    void calculateBlendShapePosition(QVector<QVector<KeyMorph>>);
-    QVector<QMatrix4x4> getPoseTransforms() {
+    // same as above but the skinning palette goes to palette, getBoneCount() matrices
+    void updateAnimation(float dt, QMatrix4x4 *palette);
+    void calculateBoneTransform(QMatrix4x4 *palette);
+    void calculateBlendShapeWeights();
+    void setCurrentFrame(float frame) { m_Layers[0].current.time = frame; }
+    int getBoneCount() const { return m_Transforms.count(); }
+    const QVector<QMatrix4x4>& getPoseTransforms() const {
         return m_Transforms;
     }
 
-public:
-    QVector<QVector2D> bsWeights;
-    int maxBlendShape = 200;
+    // switch the clip of a layer, the old one fades out over fadeDuration seconds
+    void play(Animation *clip, float fadeDuration = 0.0f, int layer = 0);
+    // returns the index of the new layer, it stays silent until a clip is played on it
+    int addLayer(bool additive = false, float weight = 1.0f);
+    void setLayerWeight(int layer, float weight) { m_Layers[layer].weight = weight; }
+    // restrict a layer to the named node and everything below it
+    void setLayerMask(int layer, const QString &rootNode, float weight = 1.0f);
+    void setLayerMask(int layer, const QVector<float> &nodeWeights) { m_Layers[layer].mask = nodeWeights; }
+    int getLayerCount() const { return m_Layers.count(); }
+
+    // one weight per sparse morph target of the geometry, see SparseMorphData::targetBase
+    const QVector<float>& getMorphWeights() const { return m_MorphWeights; }
+
 private:
+    void startClip(ClipState &state, Animation *clip, bool additive);
+    void advanceClip(ClipState &state, float dt);
+    void samplePose(ClipState &state, Pose &pose);
+    void evaluateLayer(AnimationLayer &layer);
+
+    static void blendPose(Pose &dst, const Pose &src, float weight, const QVector<float> &mask);
+    static void addPose(Pose &dst, const Pose &src, const Pose &reference, float weight, const QVector<float> &mask);
+
     QVector<QMatrix4x4> m_Transforms;
+    // global transform of every skeleton node, reused between frames
+    QVector<QMatrix4x4> m_GlobalTransforms;
+    QVector<AnimationLayer> m_Layers;
+    // pose pool, sized to the skeleton once and rewritten every frame: the result and two scratch poses
+    Pose m_Pose;
+    Pose m_LayerPose;
+    Pose m_FadePose;
+    // allocated once, rewritten in place every frame
+    QVector<float> m_MorphWeights;
     CustomGeometry* m_Geometry;
+    // the skeleton every clip is retargeted to by node name
     Animation* m_CurrentAnimation = nullptr;
-    float m_CurrentFrame;
     float m_DeltaTime;
 };
 
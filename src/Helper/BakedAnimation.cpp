@@ -0,0 +1,128 @@
+#include "BakedAnimation.h"
+#include "Animator.h"
+#include "CustomGeometry.h"
+
+#include <QDebug>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtMath>
+
+static qint64 lastModified(const QString &path) {
+    return QFileInfo(path).lastModified().toMSecsSinceEpoch();
+}
+
+// the clip length in seconds
+static double clipDuration(Animation *animation) {
+    float ticksPerSecond = animation->getTicksPerSecond() > 0.0f ? animation->getTicksPerSecond() : 25.0f;
+    return animation->getDuration() / ticksPerSecond;
+}
+
+void BakedAnimation::bake(Animation *animation, CustomGeometry *geometry, float framesPerSecond) {
+    // a private animator, the geometry's own one keeps its time
+    Animator animator(animation, geometry, geometry->getBoneCount());
+    QVector<QMatrix4x4> palette(animator.getBoneCount());
+
+    float ticksPerSecond = animation->getTicksPerSecond() > 0.0f ? animation->getTicksPerSecond() : 25.0f;
+    float duration = float(clipDuration(animation));
+
+    m_SourcePath = geometry->modelFilePath;
+    m_SourceModified = lastModified(geometry->modelFilePath);
+    m_ClipName = animation->getName();
+    m_ClipDuration = clipDuration(animation);
+    m_SampleRate = framesPerSecond;
+
+    m_BoneCount = palette.count();
+    m_FrameCount = qMax(1, qCeil(duration * framesPerSecond));
+    m_FrameRate = duration > 0.0f ? m_FrameCount / duration : framesPerSecond;
+    m_Texels.resize(width() * height());
+
+    for (int frame = 0; frame < m_FrameCount; frame++) {
+        animator.setCurrentFrame(frame / m_FrameRate * ticksPerSecond);
+        animator.updateAnimation(0.0f, palette.data());
+
+        QVector4D *row = m_Texels.data() + frame * width();
+        for (int bone = 0; bone < m_BoneCount; bone++) {
+            for (int i = 0; i < 3; i++)
+                row[bone * 3 + i] = palette[bone].row(i);
+        }
+    }
+
+    qDebug() << "baked animation: " << m_BoneCount << " bones, " << m_FrameCount << " frames at " << m_FrameRate << " fps";
+}
+
+bool BakedAnimation::saveToDisk(const QString &outFile) const {
+    QFile file(outFile);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(reinterpret_cast<const char*>(m_Texels.constData()), m_Texels.count() * sizeof(QVector4D));
+    file.close();
+
+    QJsonObject layout;
+    layout["format"] = "RGBA32F";
+    layout["width"] = width();
+    layout["height"] = height();
+    layout["boneCount"] = m_BoneCount;
+    layout["frameCount"] = m_FrameCount;
+    layout["frameRate"] = m_FrameRate;
+    layout["sourcePath"] = m_SourcePath;
+    layout["sourceModified"] = QString::number(m_SourceModified);
+    layout["clipName"] = m_ClipName;
+    layout["clipDuration"] = m_ClipDuration;
+    layout["sampleRate"] = m_SampleRate;
+
+    QFile sidecar(outFile + ".json");
+    if (!sidecar.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    sidecar.write(QJsonDocument(layout).toJson());
+    sidecar.close();
+
+    return true;
+}
+
+bool BakedAnimation::readFromDisk(const QString &inFile) {
+    QFile sidecar(inFile + ".json");
+    if (!sidecar.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    QJsonObject layout = QJsonDocument::fromJson(sidecar.readAll()).object();
+    sidecar.close();
+
+    if (layout["format"].toString() != "RGBA32F")
+        return false;
+
+    QFile file(inFile);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    int boneCount = layout["boneCount"].toInt();
+    int frameCount = layout["frameCount"].toInt();
+    qint64 size = qint64(boneCount) * 3 * frameCount * sizeof(QVector4D);
+    if (boneCount <= 0 || frameCount <= 0 || file.size() != size)
+        return false;
+
+    m_BoneCount = boneCount;
+    m_FrameCount = frameCount;
+    m_FrameRate = float(layout["frameRate"].toDouble());
+    m_SourcePath = layout["sourcePath"].toString();
+    m_SourceModified = layout["sourceModified"].toString().toLongLong();
+    m_ClipName = layout["clipName"].toString();
+    m_ClipDuration = layout["clipDuration"].toDouble();
+    m_SampleRate = float(layout["sampleRate"].toDouble());
+    m_Texels.resize(width() * height());
+    file.read(reinterpret_cast<char*>(m_Texels.data()), size);
+    file.close();
+
+    return true;
+}
+
+bool BakedAnimation::isBakeOf(Animation *animation, CustomGeometry *geometry, float framesPerSecond) const {
+    return !isEmpty() &&
+           m_SourcePath == geometry->modelFilePath &&
+           m_SourceModified == lastModified(geometry->modelFilePath) &&
+           m_ClipName == animation->getName() &&
+           qFuzzyCompare(m_ClipDuration, clipDuration(animation)) &&
+           qFuzzyCompare(m_SampleRate, framesPerSecond) &&
+           m_BoneCount == geometry->getBoneCount();
+}
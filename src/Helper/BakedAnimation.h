@@ -0,0 +1,55 @@
+#ifndef QTREFERENCE_BAKEDANIMATION_H
+#define QTREFERENCE_BAKEDANIMATION_H
+
+#include <QString>
+#include <QVector>
+#include <QVector4D>
+
+class Animation;
+class CustomGeometry;
+
+/*
+ * Vertex animation texture of one clip: the skinning palette sampled at a fixed rate, every bone
+ * stored as the 3 rows of its affine 3x4 (three RGBA32F texels) and one texture row per frame.
+ * Playing it back needs no Animator and no upload per frame, the vertex shader fetches the bones
+ * of the current frame and lets linear filtering blend between rows. Blend shapes are not baked.
+ */
+class BakedAnimation {
+public:
+    BakedAnimation() = default;
+
+    // samples the whole clip, framesPerSecond is rounded so the last frame wraps onto the first
+    void bake(Animation *animation, CustomGeometry *geometry, float framesPerSecond = 30.0f);
+
+    // texels go to outFile, the layout and what was baked to outFile + ".json"
+    bool saveToDisk(const QString &outFile) const;
+    bool readFromDisk(const QString &inFile);
+    // baked from the same, unchanged model file, the same clip and skeleton at the same rate
+    bool isBakeOf(Animation *animation, CustomGeometry *geometry, float framesPerSecond) const;
+
+    bool isEmpty() const { return m_Texels.isEmpty(); }
+    int width() const { return m_BoneCount * 3; }
+    int height() const { return m_FrameCount; }
+    int boneCount() const { return m_BoneCount; }
+    int frameCount() const { return m_FrameCount; }
+    float frameRate() const { return m_FrameRate; }
+    const QVector<QVector4D>& texels() const { return m_Texels; }
+
+private:
+    int m_BoneCount = 0;
+    int m_FrameCount = 0;
+    float m_FrameRate = 0.0f;
+
+    // where the bake came from
+    QString m_SourcePath;
+    qint64 m_SourceModified = 0;
+    QString m_ClipName;
+    double m_ClipDuration = 0.0;
+    float m_SampleRate = 0.0f;
+
+    // width() * height() texels, row by row
+    QVector<QVector4D> m_Texels;
+};
+
+
+#endif
@@ -0,0 +1,364 @@
+#include "BlockCompression.h"
+
+#include <QtEndian>
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+// ----- block fitting ----- //
+
+// mean and dominant direction of the texels of a block, found by power iteration on the covariance
+static void principalAxis(const float texels[16][3], float mean[3], float axis[3]) {
+    for (int c = 0; c < 3; c++) {
+        mean[c] = 0.0f;
+        for (int i = 0; i < 16; i++)
+            mean[c] += texels[i][c];
+        mean[c] /= 16.0f;
+    }
+
+    // xx xy xz yy yz zz
+    float cov[6] = {0.0f};
+    for (int i = 0; i < 16; i++) {
+        float d[3] = {texels[i][0] - mean[0], texels[i][1] - mean[1], texels[i][2] - mean[2]};
+        cov[0] += d[0] * d[0];
+        cov[1] += d[0] * d[1];
+        cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1];
+        cov[4] += d[1] * d[2];
+        cov[5] += d[2] * d[2];
+    }
+
+    axis[0] = axis[1] = axis[2] = 1.0f;
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float scale = qMax(std::fabs(x), qMax(std::fabs(y), std::fabs(z)));
+        if (scale <= 0.0f) {
+            // flat block, any direction will do
+            axis[0] = axis[1] = axis[2] = 0.57735f;
+            return;
+        }
+        axis[0] = x / scale;
+        axis[1] = y / scale;
+        axis[2] = z / scale;
+    }
+
+    float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    for (int c = 0; c < 3; c++)
+        axis[c] /= length;
+}
+
+// the extremes of the block projected on its principal axis
+static void axisEndpoints(const float texels[16][3], float low[3], float high[3]) {
+    float mean[3], axis[3];
+    principalAxis(texels, mean, axis);
+
+    float tMin = FLT_MAX, tMax = -FLT_MAX;
+    for (int i = 0; i < 16; i++) {
+        float t = (texels[i][0] - mean[0]) * axis[0] + (texels[i][1] - mean[1]) * axis[1] + (texels[i][2] - mean[2]) * axis[2];
+        tMin = qMin(tMin, t);
+        tMax = qMax(tMax, t);
+    }
+    for (int c = 0; c < 3; c++) {
+        low[c] = mean[c] + axis[c] * tMin;
+        high[c] = mean[c] + axis[c] * tMax;
+    }
+}
+
+template<int N, typename T>
+static int nearestEntry(const T palette[][3], const float texel[3]) {
+    int best = 0;
+    float bestError = FLT_MAX;
+    for (int entry = 0; entry < N; entry++) {
+        float error = 0.0f;
+        for (int c = 0; c < 3; c++) {
+            float d = float(palette[entry][c]) - texel[c];
+            error += d * d;
+        }
+        if (error < bestError) {
+            bestError = error;
+            best = entry;
+        }
+    }
+    return best;
+}
+
+// RGBA8 texels of block (bx, by)
+static void gatherBlock(const uchar *rgba, int width, int height, int bx, int by, uchar block[16][4]) {
+    for (int y = 0; y < 4; y++) {
+        int sy = qMin(by * 4 + y, height - 1);
+        for (int x = 0; x < 4; x++) {
+            int sx = qMin(bx * 4 + x, width - 1);
+            std::memcpy(block[y * 4 + x], rgba + (qsizetype(sy) * width + sx) * 4, 4);
+        }
+    }
+}
+
+// ----- BC1 ----- //
+
+static quint16 packRGB565(const float rgb[3]) {
+    int r = qBound(0, int(rgb[0] * 31.0f / 255.0f + 0.5f), 31);
+    int g = qBound(0, int(rgb[1] * 63.0f / 255.0f + 0.5f), 63);
+    int b = qBound(0, int(rgb[2] * 31.0f / 255.0f + 0.5f), 31);
+    return quint16((r << 11) | (g << 5) | b);
+}
+
+static void unpackRGB565(quint16 color, int rgb[3]) {
+    int r = (color >> 11) & 31;
+    int g = (color >> 5) & 63;
+    int b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void encodeBC1Block(const float texels[16][3], uchar *out) {
+    float low[3], high[3];
+    axisEndpoints(texels, low, high);
+
+    // color0 > color1 selects the four color mode; equal endpoints fall into the three color
+    // mode, where index 0 still is color0
+    quint16 color0 = packRGB565(high);
+    quint16 color1 = packRGB565(low);
+    if (color0 < color1)
+        qSwap(color0, color1);
+
+    quint32 indices = 0;
+    if (color0 != color1) {
+        int palette[4][3];
+        unpackRGB565(color0, palette[0]);
+        unpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; i++)
+            indices |= quint32(nearestEntry<4>(palette, texels[i])) << (2 * i);
+    }
+
+    qToLittleEndian(color0, out);
+    qToLittleEndian(color1, out + 2);
+    qToLittleEndian(indices, out + 4);
+}
+
+QByteArray BlockCompression::compressBC1(const uchar *rgba, int width, int height) {
+    int blocksX = blocksWide(width);
+    int blocksY = blocksWide(height);
+    QByteArray blocks(qsizetype(blocksX) * blocksY * 8, Qt::Uninitialized);
+    auto *out = reinterpret_cast<uchar*>(blocks.data());
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            uchar block[16][4];
+            gatherBlock(rgba, width, height, bx, by, block);
+            float texels[16][3];
+            for (int i = 0; i < 16; i++)
+                for (int c = 0; c < 3; c++)
+                    texels[i][c] = block[i][c];
+            encodeBC1Block(texels, out + (qsizetype(by) * blocksX + bx) * 8);
+        }
+    }
+    return blocks;
+}
+
+// ----- BC4 / BC5 ----- //
+
+static void encodeBC4Block(const uchar values[16], uchar *out) {
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; i++) {
+        low = qMin(low, int(values[i]));
+        high = qMax(high, int(values[i]));
+    }
+
+    // red0 > red1 selects the eight value mode, equal endpoints decode index 0 as red0 either way
+    quint64 indices = 0;
+    if (high != low) {
+        int palette[8] = {high, low};
+        for (int i = 2; i < 8; i++)
+            palette[i] = ((8 - i) * high + (i - 1) * low) / 7;
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            for (int entry = 1; entry < 8; entry++) {
+                if (std::abs(palette[entry] - values[i]) < std::abs(palette[best] - values[i]))
+                    best = entry;
+            }
+            indices |= quint64(best) << (3 * i);
+        }
+    }
+
+    out[0] = uchar(high);
+    out[1] = uchar(low);
+    for (int byte = 0; byte < 6; byte++)
+        out[2 + byte] = uchar(indices >> (8 * byte));
+}
+
+// one BC4 block per channel, from firstChannel on
+static QByteArray compressRGTC(const uchar *rgba, int width, int height, int firstChannel, int channelCount) {
+    int blocksX = BlockCompression::blocksWide(width);
+    int blocksY = BlockCompression::blocksWide(height);
+    int blockSize = 8 * channelCount;
+    QByteArray blocks(qsizetype(blocksX) * blocksY * blockSize, Qt::Uninitialized);
+    auto *out = reinterpret_cast<uchar*>(blocks.data());
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            uchar block[16][4];
+            gatherBlock(rgba, width, height, bx, by, block);
+            for (int channel = 0; channel < channelCount; channel++) {
+                uchar values[16];
+                for (int i = 0; i < 16; i++)
+                    values[i] = block[i][firstChannel + channel];
+                encodeBC4Block(values, out + (qsizetype(by) * blocksX + bx) * blockSize + channel * 8);
+            }
+        }
+    }
+    return blocks;
+}
+
+QByteArray BlockCompression::compressBC4(const uchar *rgba, int width, int height, int channel) {
+    return compressRGTC(rgba, width, height, channel, 1);
+}
+
+QByteArray BlockCompression::compressBC5(const uchar *rgba, int width, int height) {
+    return compressRGTC(rgba, width, height, 0, 2);
+}
+
+// ----- BC6H ----- //
+
+// the largest finite half float
+#define BC6H_MAX_HALF 0x7BFF
+
+static const int bc6hWeights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// unsigned 10 bit endpoint to the 16 bit range the palette is interpolated in
+static int bc6hUnquantize(int q) {
+    if (q == 0)
+        return 0;
+    if (q == 1023)
+        return 0xFFFF;
+    return ((q << 16) + 0x8000) >> 10;
+}
+
+// interpolated value to half float bits
+static int bc6hFinish(int x) {
+    return (x * 31) >> 6;
+}
+
+static int bc6hDecode(int q) {
+    return bc6hFinish(bc6hUnquantize(q));
+}
+
+// the endpoint whose half float is the closest at or below (roundUp: at or above) v
+static int bc6hQuantize(float v, bool roundUp) {
+    int q = qBound(0, int(v / 31.0f), 1023);
+    if (roundUp) {
+        while (q < 1023 && bc6hDecode(q) < v)
+            q++;
+        while (q > 0 && bc6hDecode(q - 1) >= v)
+            q--;
+    } else {
+        while (q < 1023 && bc6hDecode(q + 1) <= v)
+            q++;
+        while (q > 0 && bc6hDecode(q) > v)
+            q--;
+    }
+    return q;
+}
+
+struct BitWriter {
+    quint64 bits[2] = {0, 0};
+    int position = 0;
+
+    // least significant bit first
+    void write(quint64 value, int count) {
+        for (int i = 0; i < count; i++, position++) {
+            if ((value >> i) & 1)
+                bits[position >> 6] |= quint64(1) << (position & 63);
+        }
+    }
+};
+
+// texels as half float bits, fitted and interpolated in that domain like the decoder does
+static void encodeBC6HBlock(const float texels[16][3], uchar *out) {
+    float low[3], high[3];
+    axisEndpoints(texels, low, high);
+
+    // endpoints rounded outwards so the palette spans the block
+    int q0[3], q1[3];
+    for (int c = 0; c < 3; c++) {
+        float a = qBound(0.0f, low[c], float(BC6H_MAX_HALF));
+        float b = qBound(0.0f, high[c], float(BC6H_MAX_HALF));
+        q0[c] = bc6hQuantize(a, a > b);
+        q1[c] = bc6hQuantize(b, a <= b);
+    }
+
+    int palette[16][3];
+    for (int entry = 0; entry < 16; entry++) {
+        int w = bc6hWeights[entry];
+        for (int c = 0; c < 3; c++)
+            palette[entry][c] = bc6hFinish((bc6hUnquantize(q0[c]) * (64 - w) + bc6hUnquantize(q1[c]) * w + 32) >> 6);
+    }
+
+    int indices[16];
+    for (int i = 0; i < 16; i++)
+        indices[i] = nearestEntry<16>(palette, texels[i]);
+
+    // the top bit of the first index is implied 0, the weights are symmetric so swapping the
+    // endpoints and mirroring the indices gives the same colors
+    if (indices[0] >= 8) {
+        for (int c = 0; c < 3; c++)
+            qSwap(q0[c], q1[c]);
+        for (int &index : indices)
+            index = 15 - index;
+    }
+
+    // mode 11: one region, 10 bit endpoints, no delta
+    BitWriter writer;
+    writer.write(0x03, 5);
+    for (int c = 0; c < 3; c++)
+        writer.write(q0[c], 10);
+    for (int c = 0; c < 3; c++)
+        writer.write(q1[c], 10);
+    writer.write(indices[0], 3);
+    for (int i = 1; i < 16; i++)
+        writer.write(indices[i], 4);
+
+    qToLittleEndian(writer.bits[0], out);
+    qToLittleEndian(writer.bits[1], out + 8);
+}
+
+QByteArray BlockCompression::compressBC6H(const qfloat16 *rgb, int width, int height, int channels, int rowPitch) {
+    int blocksX = blocksWide(width);
+    int blocksY = blocksWide(height);
+    QByteArray blocks(qsizetype(blocksX) * blocksY * 16, Qt::Uninitialized);
+    auto *out = reinterpret_cast<uchar*>(blocks.data());
+    const auto *rows = reinterpret_cast<const char*>(rgb);
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            float texels[16][3];
+            for (int y = 0; y < 4; y++) {
+                int sy = qMin(by * 4 + y, height - 1);
+                for (int x = 0; x < 4; x++) {
+                    int sx = qMin(bx * 4 + x, width - 1);
+                    const char *texel = rows + qsizetype(sy) * rowPitch + qsizetype(sx) * channels * sizeof(qfloat16);
+                    for (int c = 0; c < 3; c++) {
+                        quint16 bits;
+                        std::memcpy(&bits, texel + c * sizeof(qfloat16), sizeof(bits));
+                        // negatives and NaN to 0, infinity to the largest finite value
+                        if ((bits & 0x8000) || ((bits & 0x7C00) == 0x7C00 && (bits & 0x03FF)))
+                            bits = 0;
+                        texels[y * 4 + x][c] = float(qMin(int(bits), BC6H_MAX_HALF));
+                    }
+                }
+            }
+            encodeBC6HBlock(texels, out + (qsizetype(by) * blocksX + bx) * 16);
+        }
+    }
+    return blocks;
+}
@@ -0,0 +1,30 @@
+#ifndef QTREFERENCE_BLOCKCOMPRESSION_H
+#define QTREFERENCE_BLOCKCOMPRESSION_H
+
+#include <QByteArray>
+#include <QFloat16>
+
+/*
+ * CPU encoders of the block compressed formats the texture caches use: BC1 for colors, BC4 for
+ * single channel maps, BC5 for the xy of normal maps and BC6H (unsigned) for HDR. Every block is
+ * fitted along the principal axis of its texels and each texel takes the nearest palette entry;
+ * BC6H only uses the single region mode with 10 bit endpoints. Blocks past the edge of an image
+ * repeat its last row and column. The result is the blocks row by row, as glCompressedTexImage2D
+ * wants them. Rows of blocks are spread over OpenMP threads.
+ */
+class BlockCompression {
+public:
+    // rgba: RGBA8 texels, rows tightly packed
+    static QByteArray compressBC1(const uchar *rgba, int width, int height);
+    // channel of the RGBA8 texels to keep
+    static QByteArray compressBC4(const uchar *rgba, int width, int height, int channel = 0);
+    // red and green
+    static QByteArray compressBC5(const uchar *rgba, int width, int height);
+    // rgb: half float texels, channels per texel and rowPitch in bytes; negative values clamp to 0
+    static QByteArray compressBC6H(const qfloat16 *rgb, int width, int height, int channels, int rowPitch);
+
+    static int blocksWide(int width) { return (width + 3) / 4; }
+};
+
+
+#endif
@@ -6,25 +6,65 @@
 #include <QString>
 #include <QMatrix4x4>
 #include <QVector3D>
+#include <QQuaternion>
+
+#include <algorithm>
 
 struct BoneInfo {
     int id;
     QMatrix4x4 offset;
 };
 
-struct KeyPosition {
-    QVector3D position;
-    float timeStamp;
-};
+/*
+ * One animated component of a channel, stored as separate time/value arrays so the key search
+ * only walks the timestamps. The caller keeps the cursor of the last key, so forward playback
+ * is O(1) and only jumps (loop, seek, reverse) fall back to a binary search.
+ */
+template <typename T>
+struct KeyTrack {
+    QVector<float> times;
+    QVector<T> values;
+
+    int count() const { return times.count(); }
+
+    // index of the key right before animationTime, clamped to [0, count - 2]
+    int findKey(float animationTime, int &cursor) const {
+        const int last = times.count() - 2;
+        if (last < 0)
+            return 0;
+
+        if (animationTime <= times[0])
+            return cursor = 0;
+        if (animationTime >= times[last + 1])
+            return cursor = last;
+
+        if (cursor > last)
+            cursor = last;
+        if (times[cursor] <= animationTime) {
+            if (animationTime < times[cursor + 1])
+                return cursor;
+            if (cursor < last && animationTime < times[cursor + 2])
+                return ++cursor;
+        }
 
-struct KeyRotation {
-    QQuaternion orientation;
-    float timeStamp;
+        cursor = int(std::upper_bound(times.constBegin(), times.constEnd(), animationTime) - times.constBegin()) - 1;
+        return cursor;
+    }
+
+    // blend factor between key and key + 1, clamped so time outside the track holds the end keys
+    float factor(int key, float animationTime) const {
+        float framesDiff = times[key + 1] - times[key];
+        if (framesDiff <= 0.0f)
+            return 0.0f;
+        return qBound(0.0f, (animationTime - times[key]) / framesDiff, 1.0f);
+    }
 };
 
-struct KeyScale {
-    QVector3D scale;
-    float timeStamp;
+// last key used on each track of a Bone, owned by whoever plays it so a clip can be shared
+struct BoneCursor {
+    int position = 0;
+    int rotation = 0;
+    int scale = 0;
 };
 
 class Bone {
@@ -33,153 +73,112 @@ public:
     explicit Bone(QString& name, int ID, const aiNodeAnim* channel) : m_Name(name), m_ID(ID) {
 
         // ----- Translate ----- //
-        m_NumPositions = channel->mNumPositionKeys;
-        for (int positionIndex = 0; positionIndex < m_NumPositions; ++positionIndex) {
+        m_Positions.times.resize(channel->mNumPositionKeys);
+        m_Positions.values.resize(channel->mNumPositionKeys);
+        for (int positionIndex = 0; positionIndex < m_Positions.count(); ++positionIndex) {
             aiVector3D aiPosition = channel->mPositionKeys[positionIndex].mValue;
-            float timeStamp = channel->mPositionKeys[positionIndex].mTime;
-
-            KeyPosition data;
-            data.position = QVector3D(aiPosition.x, aiPosition.y, aiPosition.z);
-            data.timeStamp = timeStamp;
-            m_Positions.push_back(data);
+            m_Positions.times[positionIndex] = channel->mPositionKeys[positionIndex].mTime;
+            m_Positions.values[positionIndex] = QVector3D(aiPosition.x, aiPosition.y, aiPosition.z);
         }
 
         // ----- Rotation ----- //
-        m_NumRotations = channel->mNumRotationKeys;
-        for (int rotationIndex = 0; rotationIndex < m_NumRotations; ++rotationIndex) {
+        m_Rotations.times.resize(channel->mNumRotationKeys);
+        m_Rotations.values.resize(channel->mNumRotationKeys);
+        for (int rotationIndex = 0; rotationIndex < m_Rotations.count(); ++rotationIndex) {
             aiQuaternion aiOrientation = channel->mRotationKeys[rotationIndex].mValue;
-            float timeStamp = channel->mRotationKeys[rotationIndex].mTime;
-
-            KeyRotation data;
-            data.orientation = QQuaternion(aiOrientation.w, aiOrientation.x, aiOrientation.y, aiOrientation.z);
-            data.timeStamp = timeStamp;
-            m_Rotations.push_back(data);
+            m_Rotations.times[rotationIndex] = channel->mRotationKeys[rotationIndex].mTime;
+            m_Rotations.values[rotationIndex] = QQuaternion(aiOrientation.w, aiOrientation.x, aiOrientation.y, aiOrientation.z);
         }
 
         // ----- Scaling ----- //
-        m_NumScalings = channel->mNumScalingKeys;
-        for (int keyIndex = 0; keyIndex < m_NumScalings; ++keyIndex) {
+        m_Scales.times.resize(channel->mNumScalingKeys);
+        m_Scales.values.resize(channel->mNumScalingKeys);
+        for (int keyIndex = 0; keyIndex < m_Scales.count(); ++keyIndex) {
             aiVector3D scale = channel->mScalingKeys[keyIndex].mValue;
-            float timeStamp = channel->mScalingKeys[keyIndex].mTime;
-
-            KeyScale data;
-            data.scale = QVector3D(scale.x, scale.y, scale.z);
-            data.timeStamp = timeStamp;
-            m_Scales.push_back(data);
+            m_Scales.times[keyIndex] = channel->mScalingKeys[keyIndex].mTime;
+            m_Scales.values[keyIndex] = QVector3D(scale.x, scale.y, scale.z);
         }
     }
 
-    QMatrix4x4 getLocalTransform() { return m_LocalTransform; }
+    const QMatrix4x4& getLocalTransform() const { return m_LocalTransform; }
     QString getBoneName() const { return m_Name; }
 
     void update(float animationTime) {
-        QMatrix4x4 translation = interpolatePosition(animationTime);
-        QMatrix4x4 rotation = interpolateRotation(animationTime);
-        QMatrix4x4 scale = interpolateScaling(animationTime);
-
-        m_LocalTransform = translation * rotation * scale;
+        m_LocalTransform = sample(animationTime, m_Cursor);
     }
 
-    int getPositionIndex(float animationTime) {
-        for (int index = 0; index < m_NumPositions - 1; ++index) {
-            if (animationTime < m_Positions[index + 1].timeStamp)
-                return index;
-        }
-    }
-    int getRotationIndex(float animationTime) {
-        for (int index = 0; index < m_NumRotations - 1; ++index) {
-            if (animationTime < m_Rotations[index + 1].timeStamp)
-                return index;
-        }
-    }
-    int getScaleIndex(float animationTime) {
-        for (int index = 0; index < m_NumScalings - 1; ++index) {
-            if (animationTime < m_Scales[index + 1].timeStamp)
-                return index;
-        }
+    // local transform at animationTime, only touches the caller's cursor so instances can run in parallel
+    QMatrix4x4 sample(float animationTime, BoneCursor &cursor) const {
+        QVector3D translation, scale;
+        QQuaternion rotation;
+        sample(animationTime, cursor, translation, rotation, scale);
+        return composeTransform(translation, rotation, scale);
     }
 
-private:
-    QMatrix4x4 interpolatePosition(float animationTime) {
-        QMatrix4x4 result;
-        result.setToIdentity();
-
-        if (1 == m_NumPositions) {
-            result.translate(m_Positions[0].position);
-            return result;
-        }
-
-        int p0Index = getPositionIndex(animationTime);
-        int p1Index = p0Index + 1;
-        float scaleFactor = getScaleFactor(
-                m_Positions[p0Index].timeStamp,
-                m_Positions[p1Index].timeStamp,
-                animationTime);
-        QVector3D finalPosition = m_Positions[p0Index].position * (1.0f - scaleFactor) + m_Positions[p1Index].position * scaleFactor;
-        result.translate(finalPosition);
-
-        return result;
+    // same, but keeps translation, rotation and scale apart so poses can be blended
+    void sample(float animationTime, BoneCursor &cursor, QVector3D &translation, QQuaternion &rotation, QVector3D &scale) const {
+        translation = interpolatePosition(animationTime, cursor.position);
+        rotation = interpolateRotation(animationTime, cursor.rotation);
+        scale = interpolateScaling(animationTime, cursor.scale);
     }
 
-    QMatrix4x4 interpolateRotation(float animationTime) {
-        QMatrix4x4 result;
-        result.setToIdentity();
-
-        if (1 == m_NumRotations) {
-            result.rotate(m_Rotations[0].orientation.normalized());
-            return result;
-        }
-
-        int p0Index = getRotationIndex(animationTime);
-        int p1Index = p0Index + 1;
-        float scaleFactor = getScaleFactor(
-                m_Rotations[p0Index].timeStamp,
-                m_Rotations[p1Index].timeStamp,
-                animationTime);
-        QQuaternion finalRotation = QQuaternion::slerp(m_Rotations[p0Index].orientation, m_Rotations[p1Index].orientation, scaleFactor);
-        result.rotate(finalRotation.normalized());
-
-        return result;
+    // translation * rotation * scale written straight into the affine part
+    static QMatrix4x4 composeTransform(const QVector3D &translation, const QQuaternion &rotation, const QVector3D &scale) {
+        float x = rotation.x(), y = rotation.y(), z = rotation.z(), w = rotation.scalar();
+        float xx = x * x, yy = y * y, zz = z * z;
+        float xy = x * y, xz = x * z, yz = y * z;
+        float wx = w * x, wy = w * y, wz = w * z;
+
+        return QMatrix4x4(
+                (1.0f - 2.0f * (yy + zz)) * scale.x(), 2.0f * (xy - wz) * scale.y(), 2.0f * (xz + wy) * scale.z(), translation.x(),
+                2.0f * (xy + wz) * scale.x(), (1.0f - 2.0f * (xx + zz)) * scale.y(), 2.0f * (yz - wx) * scale.z(), translation.y(),
+                2.0f * (xz - wy) * scale.x(), 2.0f * (yz + wx) * scale.y(), (1.0f - 2.0f * (xx + yy)) * scale.z(), translation.z(),
+                0.0f, 0.0f, 0.0f, 1.0f);
     }
 
-    QMatrix4x4 interpolateScaling(float animationTime) {
-        QMatrix4x4 result;
-        result.setToIdentity();
+    int getPositionIndex(float animationTime) { return m_Positions.findKey(animationTime, m_Cursor.position); }
+    int getRotationIndex(float animationTime) { return m_Rotations.findKey(animationTime, m_Cursor.rotation); }
+    int getScaleIndex(float animationTime) { return m_Scales.findKey(animationTime, m_Cursor.scale); }
 
-        if (1 == m_NumScalings) {
-            result.scale(m_Scales[0].scale);
-            return result;
-        }
+private:
+    QVector3D interpolatePosition(float animationTime, int &cursor) const {
+        if (m_Positions.count() == 0)
+            return QVector3D();
+        if (1 == m_Positions.count())
+            return m_Positions.values[0];
+
+        int p0Index = m_Positions.findKey(animationTime, cursor);
+        float scaleFactor = m_Positions.factor(p0Index, animationTime);
+        return m_Positions.values[p0Index] * (1.0f - scaleFactor) + m_Positions.values[p0Index + 1] * scaleFactor;
+    }
 
-        int p0Index = getScaleIndex(animationTime);
-        int p1Index = p0Index + 1;
-        float scaleFactor = getScaleFactor(
-                m_Scales[p0Index].timeStamp,
-                m_Scales[p1Index].timeStamp,
-                animationTime);
-        QVector3D finalScale = m_Scales[p0Index].scale *  (1.0f - scaleFactor) + m_Scales[p1Index].scale * scaleFactor;
-        result.scale(finalScale);
+    QQuaternion interpolateRotation(float animationTime, int &cursor) const {
+        if (m_Rotations.count() == 0)
+            return QQuaternion();
+        if (1 == m_Rotations.count())
+            return m_Rotations.values[0].normalized();
 
-        return result;
+        int p0Index = m_Rotations.findKey(animationTime, cursor);
+        float scaleFactor = m_Rotations.factor(p0Index, animationTime);
+        return QQuaternion::slerp(m_Rotations.values[p0Index], m_Rotations.values[p0Index + 1], scaleFactor).normalized();
     }
 
-    float getScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) {
-        float scaleFactor = 0.0f;
-        float midWayLength = animationTime - lastTimeStamp;
-        float framesDiff = nextTimeStamp - lastTimeStamp;
-        scaleFactor = midWayLength / framesDiff;
+    QVector3D interpolateScaling(float animationTime, int &cursor) const {
+        if (m_Scales.count() == 0)
+            return QVector3D(1.0f, 1.0f, 1.0f);
+        if (1 == m_Scales.count())
+            return m_Scales.values[0];
 
-        return scaleFactor;
+        int p0Index = m_Scales.findKey(animationTime, cursor);
+        float scaleFactor = m_Scales.factor(p0Index, animationTime);
+        return m_Scales.values[p0Index] * (1.0f - scaleFactor) + m_Scales.values[p0Index + 1] * scaleFactor;
     }
 
-    QVector<KeyPosition> m_Positions;
-    QVector<KeyRotation> m_Rotations;
-    QVector<KeyScale> m_Scales;
-
-    int m_NumPositions;
-    int m_NumRotations;
-    int m_NumScalings;
+    KeyTrack<QVector3D> m_Positions;
+    KeyTrack<QQuaternion> m_Rotations;
+    KeyTrack<QVector3D> m_Scales;
 
+    BoneCursor m_Cursor;
     QMatrix4x4 m_LocalTransform;
     QString m_Name;
     int m_ID;
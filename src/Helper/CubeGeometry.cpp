@@ -2,42 +2,23 @@
 
 
 void CubeGeometry::setupAttributePointer(QOpenGLShaderProgram *program) {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    // Offset for position
-    quintptr offset = 0;
-    // Tell OpenGL programmable pipeline how to locate vertex position data
-    int vertexLocation = program->attributeLocation("aPos");
-    program->enableAttributeArray(vertexLocation);
-    program->setAttributeBuffer(vertexLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for texture coordinate
-    offset += sizeof(QVector3D);
-
-    int coordLocation = program->attributeLocation("aCoord");
-    program->enableAttributeArray(coordLocation);
-    program->setAttributeBuffer(coordLocation, GL_FLOAT, offset, 2, sizeof(VertexData));
-
-    // Offset for normal
-    offset += sizeof(QVector2D);
-
-    int normalLocation = program->attributeLocation("aNormal");
-    program->enableAttributeArray(normalLocation);
-    program->setAttributeBuffer(normalLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
+    setupVertexLayout(program);
 
     program->release();
 }
 
 void CubeGeometry::initGeometry() {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    vbo.bind();
-    vbo.allocate(getVerticesData().constData(), getVerticesData().count() * sizeof(VertexData));
+    vertexLayout = VertexLayout()
+            .add(VertexAttribute::Position)
+            .add(VertexAttribute::TexCoord, VertexEncoding::HalfFloat)
+            .add(VertexAttribute::Normal, VertexEncoding::PackedNormal);
+    allocateVertexStreams(getVerticesData());
 
-    ebo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    ebo.bind();
-    ebo.allocate(getIndices().constData(), getIndices().count() * sizeof(GLuint));
+    allocateIndices(getIndices());
 }
 
 void CubeGeometry::drawGeometry(QOpenGLShaderProgram *program,
@@ -53,7 +34,7 @@ void CubeGeometry::drawGeometry(QOpenGLShaderProgram *program,
     program->setUniformValue("projection", projection);
     program->setUniformValue("map", 0);
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     texture->bind();
     glDrawElements(GL_TRIANGLE_STRIP, VerticesCount(), GL_UNSIGNED_INT, (void*)0);
@@ -61,7 +42,7 @@ void CubeGeometry::drawGeometry(QOpenGLShaderProgram *program,
 
 void CubeGeometry::drawGeometry(QOpenGLShaderProgram *program, QOpenGLTexture *texture) {
     program->bind();
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     texture->bind();
     glDrawElements(GL_TRIANGLE_STRIP, VerticesCount(), GL_UNSIGNED_INT, (void*)0);
@@ -69,13 +50,14 @@ void CubeGeometry::drawGeometry(QOpenGLShaderProgram *program, QOpenGLTexture *t
 
 void CubeGeometry::drawGeometry(QOpenGLShaderProgram *program) {
     program->bind();
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     glDrawElements(GL_TRIANGLE_STRIP, VerticesCount(), GL_UNSIGNED_INT, (void*)nullptr);
 }
 
-QVector<VertexData> CubeGeometry::getVerticesData() {
-    vertices = {
+const QVector<VertexData>& CubeGeometry::getVerticesData() const {
+    // built once and shared by every instance
+    static const QVector<VertexData> cubeVertices = {
             // Vertex data for face 0
             {QVector3D(-1.0f, -1.0f,  1.0f), QVector2D(0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f)},  // v0
             {QVector3D( 1.0f, -1.0f,  1.0f), QVector2D(1.0f, 0.0f),  QVector3D(0.0f, 0.0f, 1.0f)}, // v1
@@ -113,11 +95,11 @@ QVector<VertexData> CubeGeometry::getVerticesData() {
             {QVector3D( 1.0f,  1.0f, -1.0f), QVector2D(1.0f, 1.0f), QVector3D(0.0f, 1.0f, 0.0f)}  // v23
     };
 
-    return vertices;
+    return cubeVertices;
 }
 
-QVector<GLuint> CubeGeometry::getIndices() {
-    indices = {
+const QVector<GLuint>& CubeGeometry::getIndices() const {
+    static const QVector<GLuint> cubeIndices = {
             0,  1,  2,  3,  3,     // Face 0 - triangle strip ( v0,  v1,  v2,  v3)
             4,  4,  5,  6,  7,  7, // Face 1 - triangle strip ( v4,  v5,  v6,  v7)
             8,  8,  9, 10, 11, 11, // Face 2 - triangle strip ( v8,  v9, v10, v11)
@@ -125,5 +107,5 @@ QVector<GLuint> CubeGeometry::getIndices() {
             16, 16, 17, 18, 19, 19, // Face 4 - triangle strip (v16, v17, v18, v19)
             20, 20, 21, 22, 23      // Face 5 - triangle strip (v20, v21, v22, v23)
     };
-    return indices;
+    return cubeIndices;
 }
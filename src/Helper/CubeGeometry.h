@@ -17,6 +17,9 @@ public:
     CubeGeometry() = default;
     ~CubeGeometry() override = default;
 
+    CubeGeometry(CubeGeometry &&) = default;
+    CubeGeometry& operator=(CubeGeometry &&) = default;
+
     void initGeometry() override;
     void setupAttributePointer(QOpenGLShaderProgram *program) override;
     void drawGeometry(QOpenGLShaderProgram *program,
@@ -31,12 +34,8 @@ public:
     void drawGeometry(QOpenGLShaderProgram *program);
 
 protected:
-    QVector<VertexData> getVerticesData() override;
-    QVector<GLuint> getIndices() override;
-
-private:
-    QVector<VertexData> vertices;
-    QVector<GLuint> indices;
+    const QVector<VertexData>& getVerticesData() const override;
+    const QVector<GLuint>& getIndices() const override;
 };
 
 
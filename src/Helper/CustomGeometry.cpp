@@ -1,120 +1,37 @@
 #include "CustomGeometry.h"
 #include "cmath"
 
+#include <QFloat16>
+#include <cstring>
+
 
 CustomGeometry::CustomGeometry(QString  path) : modelFilePath(std::move(path)) {
 }
 
-void CustomGeometry::setupAttributePointer(QOpenGLShaderProgram *program) {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
-
-    // Offset for position
-    quintptr offset = 0;
-    // Tell OpenGL programmable pipeline how to locate vertex position data
-    int vertexLocation = program->attributeLocation("aPos");
-    program->enableAttributeArray(vertexLocation);
-    program->setAttributeBuffer(vertexLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for texture coordinate
-    offset += sizeof(QVector3D);
-
-    int coordLocation = program->attributeLocation("aCoord");
-    program->enableAttributeArray(coordLocation);
-    program->setAttributeBuffer(coordLocation, GL_FLOAT, offset, 2, sizeof(VertexData));
-
-    // Offset for normal
-    offset += sizeof(QVector2D);
-
-    int normalLocation = program->attributeLocation("aNormal");
-    program->enableAttributeArray(normalLocation);
-    program->setAttributeBuffer(normalLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for tangent
-    offset += sizeof(QVector3D);
-
-    int tangentLocation = program->attributeLocation("aTangent");
-    program->enableAttributeArray(tangentLocation);
-    program->setAttributeBuffer(tangentLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for bitangent
-    offset += sizeof(QVector3D);
-
-    int bitangentLocation = program->attributeLocation("aBitangent");
-    program->enableAttributeArray(bitangentLocation);
-    program->setAttributeBuffer(bitangentLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for blendShape data
-    offset += sizeof(QVector3D);
-    int bsdataLocation = program->attributeLocation("aBlendShapeData");
-    program->enableAttributeArray(bsdataLocation);
-    program->setAttributeBuffer(bsdataLocation, GL_FLOAT, offset, 4, sizeof(VertexData));
-
-    // Offset for boneIds
-    offset += sizeof(QVector4D);
-
-    int boneIdsLocation = program->attributeLocation("boneIds");
-    program->enableAttributeArray(boneIdsLocation);
-    program->setAttributeBuffer(boneIdsLocation, GL_FLOAT, offset, 4, sizeof(VertexData));
+CustomGeometry::~CustomGeometry() {
+    if (objectSHCoefficientSSBO)
+        glDeleteBuffers(1, &objectSHCoefficientSSBO);
+}
 
-    // Offset for weights
-    offset += sizeof(QVector4D);
+void CustomGeometry::setupAttributePointer(QOpenGLShaderProgram *program) {
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    int weightsLocation = program->attributeLocation("weights");
-    program->enableAttributeArray(weightsLocation);
-    program->setAttributeBuffer(weightsLocation, GL_FLOAT, offset, 4, sizeof(VertexData));
+    setupVertexLayout(program);
 
     program->release();
 }
 
 void CustomGeometry::setupAttributePointer(QOpenGLShaderProgram *program, bool RPT, int bandPower2) {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
-
-    quintptr offset = 0;
-    // Tell OpenGL programmable pipeline how to locate vertex position data
-    int vertexLocation = program->attributeLocation("aPos");
-    program->enableAttributeArray(vertexLocation);
-    program->setAttributeBuffer(vertexLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for texture coordinate
-    offset += sizeof(QVector3D);
-
-    int coordLocation = program->attributeLocation("aCoord");
-    program->enableAttributeArray(coordLocation);
-    program->setAttributeBuffer(coordLocation, GL_FLOAT, offset, 2, sizeof(VertexData));
-
-    // Offset for normal
-    offset += sizeof(QVector2D);
-
-    int normalLocation = program->attributeLocation("aNormal");
-    program->enableAttributeArray(normalLocation);
-    program->setAttributeBuffer(normalLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for tangent
-    offset += sizeof(QVector3D);
-
-    int tangentLocation = program->attributeLocation("aTangent");
-    program->enableAttributeArray(tangentLocation);
-    program->setAttributeBuffer(tangentLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for bitangent
-    offset += sizeof(QVector3D);
-
-    int bitangentLocation = program->attributeLocation("aBitangent");
-    program->enableAttributeArray(bitangentLocation);
-    program->setAttributeBuffer(bitangentLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    //
-    offset += sizeof(QVector3D);
-
-    int ObjSHCoeffLocation = program->attributeLocation("ObjectSHCoefficient");
-    for (int attrib = 0; attrib < bandPower2; attrib++) {
-        program->setAttributeBuffer(
-                ObjSHCoeffLocation + attrib,
-                GL_FLOAT,
-                offset + attrib * sizeof(QVector3D),
-                3,
-                sizeof(VertexData));
-        program->enableAttributeArray(ObjSHCoeffLocation + attrib);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
+
+    setupVertexLayout(program);
+
+    // transfer coefficients live in their own ssbo instead of the vertex layout,
+    // light and object may be projected with different bands so only the shared ones are summed
+    if (RPT) {
+        program->bind();
+        program->setUniformValue("SHBandPower2", qMin(bandPower2, objectSHBandPower2));
+        program->setUniformValue("ObjectSHBandPower2", objectSHBandPower2);
     }
 
     program->release();
@@ -133,14 +50,13 @@ void CustomGeometry::initGeometry() {
         return;
     }
 
-    m_indexIncrease = 0;
     m_animationNum = scene->mNumAnimations;
 
     // compute geometry transformation for fbx
     computeGeometryHierarchy(scene->mRootNode, QMatrix4x4());
 
     // process ASSIMP's root node recursively
-    processNode(scene->mRootNode, scene);
+    processScene(scene);
 
     verticesCount = getVerticesData().length();
     indicesCount = getIndices().length();
@@ -172,30 +88,24 @@ void CustomGeometry::initGeometry(QVector<QVector<QVector3D>> &ObjectSHCoefficie
     }
 
     // process ASSIMP's root node recursively
-    processNode(scene->mRootNode, scene);
+    processScene(scene);
     setupObjectSHCoefficient(ObjectSHCoefficient);
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    vbo.bind();
-    vbo.allocate(getVerticesData().constData(), getVerticesData().count() * sizeof(VertexData));
+    vertexLayout = buildVertexLayout();
+    allocateVertexStreams(getVerticesData());
 
-    ebo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    ebo.bind();
-    ebo.allocate(getIndices().constData(), getIndices().count() * sizeof(GLuint));
+    allocateIndices(getIndices());
 }
 
 void CustomGeometry::initAllocate() {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    vbo.bind();
-    vbo.allocate(getVerticesData().constData(), getVerticesData().count() * sizeof(VertexData));
+    vertexLayout = buildVertexLayout();
+    allocateVertexStreams(getVerticesData());
 
-    ebo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    ebo.bind();
-    ebo.allocate(getIndices().constData(), getIndices().count() * sizeof(GLuint));
+    allocateIndices(getIndices());
 }
 
 void CustomGeometry::drawGeometry(QOpenGLShaderProgram *program,
@@ -210,7 +120,7 @@ void CustomGeometry::drawGeometry(QOpenGLShaderProgram *program,
     program->setUniformValue("projection", projection);
     program->setUniformValue("AlbedoMap", 0);
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
     texture->bind();
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)0);
 }
@@ -223,18 +133,31 @@ CustomGeometry::drawGeometry(QOpenGLShaderProgram *program, QMatrix4x4 model, QM
     program->setUniformValue("view", view);
     program->setUniformValue("projection", projection);
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    if (objectSHCoefficientSSBO)
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_SH_COEFFICIENT_BINDING, objectSHCoefficientSSBO);
+
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)0);
 }
 
+void CustomGeometry::drawGeometryInstanced(QOpenGLShaderProgram *program, QMatrix4x4 view, QMatrix4x4 projection, int instanceCount, int baseInstance) {
+    program->bind();
+
+    program->setUniformValue("view", view);
+    program->setUniformValue("projection", projection);
+
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)0, instanceCount, baseInstance);
+}
+
 void CustomGeometry::drawGeometry(QOpenGLShaderProgram *program, QOpenGLTexture *texture) {
 }
 
-QVector<VertexData> CustomGeometry::getVerticesData() {
+const QVector<VertexData>& CustomGeometry::getVerticesData() const {
     return vertices;
 }
 
-QVector<GLuint> CustomGeometry::getIndices() {
+const QVector<GLuint>& CustomGeometry::getIndices() const {
     return indices;
 }
 
@@ -290,12 +213,12 @@ QMatrix4x4 CustomGeometry::convertAIMatrixToQtFormat(const aiMatrix4x4& from) {
     return to;
 }
 
-void CustomGeometry::extractBoneWeightForVertices(QVector<VertexData> &data, aiMesh* mesh, const aiScene* scene) {
+void CustomGeometry::registerBones(const aiMesh *mesh) {
+    // bone ids follow the mesh order, so this part stays serial
     auto& boneInfoMap = m_OffsetMatMap;
     int& boneCount = m_BoneCount;
     for (int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
     {
-        int boneID = -1;
         QString boneName(mesh->mBones[boneIndex]->mName.C_Str());
 
         if (boneInfoMap.find(boneName) == boneInfoMap.end()) { // notfound
@@ -305,35 +228,103 @@ void CustomGeometry::extractBoneWeightForVertices(QVector<VertexData> &data, aiM
             newBoneInfo.offset = convertAIMatrixToQtFormat(mesh->mBones[boneIndex]->mOffsetMatrix);
 
             boneInfoMap[boneName] = newBoneInfo;
-            boneID = boneCount;
             boneCount++;
         }
-        else {
-            boneID = boneInfoMap[boneName].id;
-        }
+    }
+}
+
+void CustomGeometry::extractBoneWeightForVertices(VertexData *data, const aiMesh* mesh) const {
+    // data points at the first vertex of this mesh, bones must already be registered
+    for (int boneIndex = 0; boneIndex < mesh->mNumBones; ++boneIndex)
+    {
+        QString boneName(mesh->mBones[boneIndex]->mName.C_Str());
+        auto boneInfo = m_OffsetMatMap.constFind(boneName);
+        assert(boneInfo != m_OffsetMatMap.constEnd());
+        int boneID = boneInfo->id;
 
-        assert(boneID != -1);
         auto weights = mesh->mBones[boneIndex]->mWeights;
         unsigned int numWeights = mesh->mBones[boneIndex]->mNumWeights;
         for (int weightIndex = 0; weightIndex < numWeights; ++weightIndex)
         {
-            int vertexId = weights[weightIndex].mVertexId+m_indexIncrease;
+            int vertexId = weights[weightIndex].mVertexId;
             float weight = weights[weightIndex].mWeight;
-            // FIXME is that necessary for the line of the follow, or consider we added m_indexIncrease
-            //assert(vertexId <= vertices.size());
+            assert(vertexId < mesh->mNumVertices);
             setVertexBoneData(data[vertexId], boneID, weight);
         }
     }
 }
 
-void CustomGeometry::processNode(aiNode *node, const aiScene *scene) {
+void CustomGeometry::processScene(const aiScene *scene) {
+    QVector<const aiMesh*> meshes;
+    processNode(scene->mRootNode, scene, meshes);
+
+    // first pass: count every mesh and compute its offsets, everything order dependent happens here
+    QVector<MeshSlice> slices(meshes.count());
+    int vertexOffset = vertices.count();
+    int indexOffset = indices.count();
+    for (int m = 0; m < meshes.count(); m++) {
+        const aiMesh *mesh = meshes[m];
+        QString qmeshName = QString(mesh->mName.data);
+
+        qDebug() << "circling mesh info: (name, numBone, bsID)" << qmeshName << mesh->mNumBones << m_BSID;
+
+        MeshSlice &slice = slices[m];
+        slice.mesh = mesh;
+        slice.vertexOffset = vertexOffset;
+        slice.indexOffset = indexOffset;
+        slice.level = computeLevelByVCount(mesh->mNumVertices, 2);
+        slice.blendShapeIndex = -1;
+
+        if (mesh->mNumAnimMeshes) {
+            slice.blendShapeIndex = m_BSID;
+            m_MorphData.targetBase.append(m_MorphData.targetCount() + mesh->mNumAnimMeshes);
+
+            if (mesh->mNumVertices) {
+                unsigned int bsLen = mesh->mAnimMeshes[0]->mNumVertices;
+                blendShapeSlice.append(QVector4D(vertexOffset, vertexOffset + bsLen, m_BSID, 0));
+                bsMeshOrderNames.push_back(qmeshName);
+            }
+            ++m_BSID;
+        }
+
+        registerBones(mesh);
+
+        verticesSlice[qmeshName] = QVector<unsigned int>{static_cast<unsigned int>(vertexOffset),
+                                                         vertexOffset + mesh->mNumVertices,
+                                                         mesh->mNumBones};
+
+        vertexOffset += mesh->mNumVertices;
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+            indexOffset += mesh->mFaces[i].mNumIndices;
+    }
+
+    vertices.resize(vertexOffset);
+    indices.resize(indexOffset);
+    m_indexIncrease = vertexOffset;
+
+    // second pass: every mesh writes its own range, take the pointers before going wide so nothing detaches
+    VertexData *vertexData = vertices.data();
+    GLuint *indexData = indices.data();
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int m = 0; m < slices.count(); m++) {
+        processMesh(slices[m], vertexData, indexData);
+    }
+
+    // blend shape deltas only need the finished base positions
+    for (const auto &slice : slices) {
+        if (slice.blendShapeIndex >= 0)
+            extractBlendShape(slice, vertexData);
+    }
+}
+
+void CustomGeometry::processNode(const aiNode *node, const aiScene *scene, QVector<const aiMesh*> &meshes) {
     // process each mesh located at the current node
     for(unsigned int i = 0; i < node->mNumMeshes; i++)
     {
         // the node object only contains indices to index the actual objects in the scene.
         // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        processMesh(mesh, scene);
+        meshes.append(scene->mMeshes[node->mMeshes[i]]);
     }
 
     for(unsigned int i = 0; i < node->mNumChildren; i++)
@@ -341,25 +332,12 @@ void CustomGeometry::processNode(aiNode *node, const aiScene *scene) {
         if(node->mChildren[i]->mMetaData != nullptr && node->mChildren[i]->mMetaData->mNumProperties){
             // TODO
         }
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, meshes);
 
     }
 }
 
-void CustomGeometry::computeScaleFactor(QVector3D& v){
-    float maxmFacX=0.0f, maxmFacY=0.0f,maxmFacZ=0.0f, minmFacX=0.0f, minmFacY=0.0f, minmFacZ=0.0f;
-    maxmFacX = std::max(maxmFacX, v.x());
-    maxmFacY = std::max(maxmFacY, v.y());
-    maxmFacZ = std::max(maxmFacZ, v.z());
-    minmFacX = std::min(minmFacX, v.x());
-    minmFacY = std::min(minmFacY, v.y());
-    minmFacZ = std::min(minmFacZ, v.z());
-    scaleFactor.setX(std::max(scaleFactor.x(), std::max(maxmFacX, std::abs(minmFacX))));
-    scaleFactor.setY(std::max(scaleFactor.y(), std::max(maxmFacY, std::abs(minmFacY))));
-    scaleFactor.setZ(std::max(scaleFactor.z(), std::max(maxmFacZ, std::abs(minmFacZ))));
-}
-
-void CustomGeometry::processMesh(aiMesh *mesh, const aiScene *scene) {
+void CustomGeometry::processMesh(const MeshSlice &slice, VertexData *vertexData, GLuint *indexData) const {
     /*
      * Notes:
      *      FBX: if the mesh has no animation, no blendShape and no transformation and
@@ -367,132 +345,160 @@ void CustomGeometry::processMesh(aiMesh *mesh, const aiScene *scene) {
      *          from mRootNode -> mTransformation -> mChildren -> mTransformation ...
      *          except Freeze transformation before we exported;
      */
-    float maxBs = -1.0;
-    bool blendShapeUnsliced = true;
-    m_blendShapeData.clear();
-    int vlevel = computeLevelByVCount(mesh->mNumVertices, 2);
-    mesh->mNumBones; // it will be 0 if this mesh that doesn't have any bone influence with.
-                        // so we need multi-matrix transformation
-    QString qmeshName = QString(mesh->mName.data);
-
-    qDebug() << "circling mesh info: (name, numBone, bsID)" << qmeshName << mesh->mNumBones << m_BSID;
+    const aiMesh *mesh = slice.mesh;
+    VertexData *meshVertices = vertexData + slice.vertexOffset;
+
+    const QVector4D bsdata(mesh->mNumAnimMeshes, mesh->mNumVertices, slice.level, 0.0f);
+
     // Walk through each of the mesh's vertices
     for(unsigned int i = 0; i < mesh->mNumVertices; i++)
     {
-        QVector3D pos;
-        QVector2D tex;
-        QVector3D normal;
-        QVector3D tangent;
-        QVector3D bitangent;
-        QVector4D bsdata;
-        VertexData data;
+        VertexData &data = meshVertices[i];
 
         setVertexBoneDataToDefault(data);
 
-        pos.setX(mesh->mVertices[i].x);
-        pos.setY(mesh->mVertices[i].y);
-        pos.setZ(mesh->mVertices[i].z);
+        data.position = QVector3D(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
 
-        if (mesh->mTextureCoords[0]) {
-            tex.setX(mesh->mTextureCoords[0][i].x);
-            tex.setY(mesh->mTextureCoords[0][i].y);
-        }
-        else {
-            tex.setX(0.0f);
-            tex.setY(0.0f);
-        }
-
-        if (mesh->mNormals) {
-            normal.setX(mesh->mNormals[i].x);
-            normal.setY(mesh->mNormals[i].y);
-            normal.setZ(mesh->mNormals[i].z);
-        }
-        if(mesh->mTangents){
-            tangent.setX(mesh->mTangents[i].x);
-            tangent.setY(mesh->mTangents[i].y);
-            tangent.setZ(mesh->mTangents[i].z);
-        }
-        if(mesh->mBitangents){
-            bitangent.setX(mesh->mBitangents[i].x);
-            bitangent.setY(mesh->mBitangents[i].y);
-            bitangent.setZ(mesh->mBitangents[i].z);
-        }
+        if (mesh->mTextureCoords[0])
+            data.texCoord = QVector2D(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+        else
+            data.texCoord = QVector2D(0.0f, 0.0f);
 
-        bsdata.setX(mesh->mNumAnimMeshes);
-        bsdata.setY(mesh->mNumVertices);
-        bsdata.setZ(vlevel);
-        bsdata.setW(0.0f);
-
-        data.position = pos;
-        data.texCoord = tex;
-        data.normal = normal;
-        data.tangent = tangent;
-        data.bitangent = bitangent;
+        data.normal = mesh->mNormals ? QVector3D(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z) : QVector3D();
+        data.tangent = mesh->mTangents ? QVector3D(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z) : QVector3D();
+        data.bitangent = mesh->mBitangents ? QVector3D(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z) : QVector3D();
         data.bsdata = bsdata;
-
-        // blendShape
-        BlendShapePosition bsp;
-        bsp.m_numAnimPos = mesh->mNumAnimMeshes;
-        if(mesh->mNumAnimMeshes){
-            unsigned int bsLen = mesh->mAnimMeshes[0]->mNumVertices;
-            for(unsigned int b=0; b<mesh->mNumAnimMeshes;++b){
-                QVector3D b_pos, b_nor;
-                aiVector3D b_ver = mesh->mAnimMeshes[b]->mVertices[i];
-                aiVector3D b_nml = mesh->mAnimMeshes[b]->mNormals[i];
-                b_pos.setX(b_ver.x); b_pos.setY(b_ver.y); b_pos.setZ(b_ver.z);
-                b_nor.setX(b_nml.x); b_nor.setY(b_nml.y); b_nor.setZ(b_nml.z);
-                maxBs = std::max(maxBs, b_pos.y());
-                QVector3D deltaPos = b_pos - pos;
-                QVector3D deltaNor = b_nor - normal;
-                computeScaleFactor(deltaPos);
-                bsp.m_AnimDeltaPos.push_back(deltaPos);
-                bsp.m_AnimDeltaNor.push_back(deltaNor);
-            }
-            assert(bsp.m_numAnimPos == bsp.m_AnimDeltaPos.length());
-
-            m_blendShapeData.push_back(bsp);
-            if(blendShapeUnsliced){
-                blendShapeSlice.append(QVector4D(m_indexIncrease, m_indexIncrease+bsLen, m_BSID, 0));
-                bsMeshOrderNames.push_back(qmeshName);
-                blendShapeUnsliced = false;
-            }
-        }
-
-        vertices.push_back(data);
-    }
-
-    // push blendshape data
-    if(mesh->mNumAnimMeshes){
-        m_BSDATA.push_back(m_blendShapeData);
-        ++m_BSID;
     }
 
     // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+    GLuint *meshIndices = indexData + slice.indexOffset;
     for(unsigned int i = 0; i < mesh->mNumFaces; i++)
     {
-        aiFace face = mesh->mFaces[i];
+        const aiFace &face = mesh->mFaces[i];
         // retrieve all indices of the face and store them in the indices vector
         for(unsigned int j = 0; j < face.mNumIndices; j++)
-            indices.push_back(face.mIndices[j] + m_indexIncrease);
+            *meshIndices++ = face.mIndices[j] + slice.vertexOffset;
+    }
+
+    extractBoneWeightForVertices(meshVertices, mesh);
+}
+
+static quint32 packHalf2(float x, float y) {
+    // same layout as glsl packHalf2x16, x in the low bits
+    qfloat16 half[2] = {qfloat16(x), qfloat16(y)};
+    quint16 bits[2];
+    memcpy(bits, half, sizeof(bits));
+    return quint32(bits[0]) | (quint32(bits[1]) << 16);
+}
+
+static bool morphDelta(const aiAnimMesh *target, int i, const VertexData &vertex, QVector3D &deltaPos, QVector3D &deltaNor) {
+    // deltas under this are lost in half precision anyway
+    const float epsilon = 1e-5f;
+
+    deltaPos = QVector3D(target->mVertices[i].x, target->mVertices[i].y, target->mVertices[i].z) - vertex.position;
+    deltaNor = target->mNormals ? QVector3D(target->mNormals[i].x, target->mNormals[i].y, target->mNormals[i].z) - vertex.normal : QVector3D();
+
+    return qAbs(deltaPos.x()) > epsilon || qAbs(deltaPos.y()) > epsilon || qAbs(deltaPos.z()) > epsilon ||
+           qAbs(deltaNor.x()) > epsilon || qAbs(deltaNor.y()) > epsilon || qAbs(deltaNor.z()) > epsilon;
+}
+
+void CustomGeometry::extractBlendShape(const MeshSlice &slice, const VertexData *vertexData) {
+    const aiMesh *mesh = slice.mesh;
+    const VertexData *meshVertices = vertexData + slice.vertexOffset;
+    const int numVertices = mesh->mNumVertices;
+    const int numAnimMeshes = mesh->mNumAnimMeshes;
+    const int targetBase = m_MorphData.targetBase[slice.blendShapeIndex];
+
+    // first pass: how many targets really move each vertex
+    QVector<int> entryOffset(numVertices);
+#pragma omp parallel for if (numVertices > 4096)
+    for (int i = 0; i < numVertices; i++) {
+        int moved = 0;
+        for (int b = 0; b < numAnimMeshes; b++) {
+            QVector3D deltaPos, deltaNor;
+            if (morphDelta(mesh->mAnimMeshes[b], i, meshVertices[i], deltaPos, deltaNor))
+                moved++;
+        }
+        entryOffset[i] = moved;
     }
 
-    extractBoneWeightForVertices(vertices, mesh, scene);
-    verticesSlice[qmeshName] = QVector<unsigned int>{static_cast<unsigned int>(m_indexIncrease),
-                                                     m_indexIncrease + mesh->mNumVertices,
-                                                     mesh->mNumBones};
-    m_indexIncrease += mesh->mNumVertices;
+    // compact the moved vertices and turn the counts into offsets
+    int entryCount = m_MorphData.entries.count();
+    for (int i = 0; i < numVertices; i++) {
+        int moved = entryOffset[i];
+        entryOffset[i] = entryCount;
+        if (moved) {
+            entryCount += moved;
+            m_MorphData.vertices.append(slice.vertexOffset + i);
+            m_MorphData.vertexStart.append(entryCount);
+        }
+    }
+
+    // second pass: write the non-zero deltas
+    m_MorphData.entries.resize(entryCount);
+    MorphEntry *entries = m_MorphData.entries.data();
+#pragma omp parallel for if (numVertices > 4096)
+    for (int i = 0; i < numVertices; i++) {
+        MorphEntry *entry = entries + entryOffset[i];
+        for (int b = 0; b < numAnimMeshes; b++) {
+            QVector3D deltaPos, deltaNor;
+            if (!morphDelta(mesh->mAnimMeshes[b], i, meshVertices[i], deltaPos, deltaNor))
+                continue;
+
+            entry->target = targetBase + b;
+            entry->delta[0] = packHalf2(deltaPos.x(), deltaPos.y());
+            entry->delta[1] = packHalf2(deltaPos.z(), deltaNor.x());
+            entry->delta[2] = packHalf2(deltaNor.y(), deltaNor.z());
+            entry++;
+        }
+    }
 }
 
 void CustomGeometry::setupObjectSHCoefficient(QVector<QVector<QVector3D>> &ObjectSHCoefficient) {
     int numbersOfVertices = ObjectSHCoefficient.count();
     int bandPower2 = ObjectSHCoefficient.count() > 0 ? ObjectSHCoefficient[0].count() : 0;
 
+    // flatten to [vertex][coefficient][rgb] so any band count fits, std430 float array has no padding
+    QVector<float> packedCoefficient(numbersOfVertices * bandPower2 * 3);
+
 #pragma omp parallel for
     for (int i = 0; i < numbersOfVertices; i++) {
+        float *dst = packedCoefficient.data() + i * bandPower2 * 3;
         for (int j = 0; j < bandPower2; j++) {
-            vertices[i].ObjectSHCoefficient[j] = ObjectSHCoefficient[i][j];
+            dst[j * 3 + 0] = ObjectSHCoefficient[i][j].x();
+            dst[j * 3 + 1] = ObjectSHCoefficient[i][j].y();
+            dst[j * 3 + 2] = ObjectSHCoefficient[i][j].z();
         }
     }
+
+    if (!objectSHCoefficientSSBO)
+        glGenBuffers(1, &objectSHCoefficientSSBO);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectSHCoefficientSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, packedCoefficient.count() * sizeof(float), packedCoefficient.constData(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    objectSHBandPower2 = bandPower2;
+}
+
+VertexLayout CustomGeometry::buildVertexLayout() const {
+    VertexLayout layout;
+
+    // surface stream, uv stays float for udim tiles
+    layout.add(VertexAttribute::Position)
+          .add(VertexAttribute::TexCoord)
+          .add(VertexAttribute::Normal, VertexEncoding::PackedNormal)
+          .add(VertexAttribute::Tangent, VertexEncoding::PackedNormal)
+          .add(VertexAttribute::Bitangent, VertexEncoding::PackedNormal);
+
+    // skinning and blend shape stream, static models never upload it
+    if (m_BoneCount > 0 || m_BSID > 0 || m_animationNum > 0) {
+        layout.add(VertexAttribute::BlendShapeData, VertexEncoding::Float, 1)
+              .add(VertexAttribute::BoneIds, VertexEncoding::Short, 1)
+              .add(VertexAttribute::Weights, VertexEncoding::HalfFloat, 1);
+    }
+
+    return layout;
 }
 
 int CustomGeometry::computeLevelByVCount(unsigned int vcount, int split_tile) {
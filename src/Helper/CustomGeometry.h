@@ -17,6 +17,7 @@
 #include "assimp/postprocess.h"
 
 #define MAX_BONE_WEIGHTS 4
+#define OBJECT_SH_COEFFICIENT_BINDING 0
 
 class Geometry;
 class Animation;
@@ -26,7 +27,10 @@ class CustomGeometry : public Geometry {
 public:
     CustomGeometry() = default;
     explicit CustomGeometry(QString  path);
-    ~CustomGeometry() override = default;
+    ~CustomGeometry() override;
+
+    // animator keeps pointers to this geometry and its animation, so it stays where it was built
+    Q_DISABLE_COPY_MOVE(CustomGeometry)
 
     void initGeometry() override;
     void initAnimation();
@@ -35,10 +39,10 @@ public:
     QMap<QString, BoneInfo>& getOffsetMatMap() { return m_OffsetMatMap; }
     int& getBoneCount() { return m_BoneCount; }
 
-    void extractBoneWeightForVertices(QVector<VertexData> &data, aiMesh* mesh, const aiScene* scene);
-    void setVertexBoneDataToDefault(VertexData &data);
+    void extractBoneWeightForVertices(VertexData *data, const aiMesh* mesh) const;
+    static void setVertexBoneDataToDefault(VertexData &data);
     QMatrix4x4 convertAIMatrixToQtFormat(const aiMatrix4x4& from);
-    void setVertexBoneData(VertexData& vertex, int boneID, float weight);
+    static void setVertexBoneData(VertexData& vertex, int boneID, float weight);
     void initGeometry(QVector<QVector<QVector3D>> &ObjectSHCoefficient);
     void initAllocate();
     void setupAttributePointer(QOpenGLShaderProgram *program) override;
@@ -58,19 +62,40 @@ public:
                       QMatrix4x4 view,
                       QMatrix4x4 projection);
 
+    // per instance data (model matrix, palette, ...) has to come from buffers bound by the caller,
+    // baseInstance offsets gl_BaseInstance so several draws can share one instance buffer
+    void drawGeometryInstanced(QOpenGLShaderProgram *program,
+                               QMatrix4x4 view,
+                               QMatrix4x4 projection,
+                               int instanceCount,
+                               int baseInstance = 0);
+
     void setupObjectSHCoefficient(QVector<QVector<QVector3D>> &ObjectSHCoefficient);
 
 public:
-    void computeScaleFactor(QVector3D&);
     void computeGeometryHierarchy(const aiNode*, QMatrix4x4);
     QMap<QString, QMatrix4x4> m_geoMatrix;
 
 protected:
-    QVector<VertexData> getVerticesData() override;
-    QVector<GLuint> getIndices() override;
-
-    void processNode(aiNode *node, const aiScene *scene);
-    void processMesh(aiMesh *mesh, const aiScene *scene);
+    const QVector<VertexData>& getVerticesData() const override;
+    const QVector<GLuint>& getIndices() const override;
+
+    // where one aiMesh lands in the flattened vertices/indices, filled by the serial counting pass
+    struct MeshSlice {
+        const aiMesh *mesh;
+        int vertexOffset;
+        int indexOffset;
+        int level;
+        int blendShapeIndex; // m_BSID of the mesh, -1 without blend shape
+    };
+
+    void processScene(const aiScene *scene);
+    void processNode(const aiNode *node, const aiScene *scene, QVector<const aiMesh*> &meshes);
+    void registerBones(const aiMesh *mesh);
+    void processMesh(const MeshSlice &slice, VertexData *vertexData, GLuint *indexData) const;
+    void extractBlendShape(const MeshSlice &slice, const VertexData *vertexData);
+
+    VertexLayout buildVertexLayout() const;
 
 private:
     QVector<VertexData> vertices;
@@ -82,9 +107,14 @@ private:
     QMap<QString, BoneInfo> m_OffsetMatMap;
     int m_BoneCount = 0;
     int m_indexIncrease = 0;
-    QVector<BlendShapePosition> m_blendShapeData;
     QVector<QMatrix4x4> m_Transforms;
 
+    // ----- PRT ----- //
+
+    // per vertex transfer coefficients, packed as rgb floats, read by gl_VertexID in the shader
+    GLuint objectSHCoefficientSSBO = 0;
+    int objectSHBandPower2 = 0;
+
 public:
     Animation animation;
     int m_animationNum = 0;
@@ -95,10 +125,9 @@ public:
     unsigned int indicesCount;
 
     unsigned int m_BSID = 0;
-    QVector<QVector<BlendShapePosition>> m_BSDATA;
+    SparseMorphData m_MorphData;
 
     QString modelFilePath;
-    QVector3D scaleFactor;
     QVector<QVector4D> blendShapeSlice;
     Animator animator;
 };
@@ -2,15 +2,15 @@
 
 
 void FloorGeometry::initGeometry() {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    vbo.bind();
-    vbo.allocate(getVerticesData().constData(), getVerticesData().count() * sizeof(VertexData));
+    vertexLayout = VertexLayout()
+            .add(VertexAttribute::Position)
+            .add(VertexAttribute::TexCoord, VertexEncoding::HalfFloat)
+            .add(VertexAttribute::Normal, VertexEncoding::PackedNormal);
+    allocateVertexStreams(getVerticesData());
 
-    ebo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    ebo.bind();
-    ebo.allocate(getIndices().constData(), getIndices().count() * sizeof(GLuint));
+    allocateIndices(getIndices());
 }
 
 void
@@ -24,7 +24,7 @@ FloorGeometry::drawGeometry(QOpenGLShaderProgram *program, QMatrix4x4 model, QMa
     program->setUniformValue("projection", projection);
     program->setUniformValue("map", 0);
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     texture->bind();
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)nullptr);
@@ -35,40 +35,22 @@ void FloorGeometry::drawGeometry(QOpenGLShaderProgram *program, QOpenGLTexture *
 
 void FloorGeometry::drawGeometry(QOpenGLShaderProgram *program) {
     program->bind();
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)nullptr);
 }
 
 void FloorGeometry::setupAttributePointer(QOpenGLShaderProgram *program) {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    // Offset for position
-    quintptr offset = 0;
-    // Tell OpenGL programmable pipeline how to locate vertex position data
-    int vertexLocation = program->attributeLocation("aPos");
-    program->enableAttributeArray(vertexLocation);
-    program->setAttributeBuffer(vertexLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for texture coordinate
-    offset += sizeof(QVector3D);
-
-    int coordLocation = program->attributeLocation("aCoord");
-    program->enableAttributeArray(coordLocation);
-    program->setAttributeBuffer(coordLocation, GL_FLOAT, offset, 2, sizeof(VertexData));
-
-    // Offset for normal
-    offset += sizeof(QVector2D);
-
-    int normalLocation = program->attributeLocation("aNormal");
-    program->enableAttributeArray(normalLocation);
-    program->setAttributeBuffer(normalLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
+    setupVertexLayout(program);
 
     program->release();
 }
 
-QVector<VertexData> FloorGeometry::getVerticesData() {
-    vertices = {
+const QVector<VertexData>& FloorGeometry::getVerticesData() const {
+    // built once and shared by every instance
+    static const QVector<VertexData> floorVertices = {
             {QVector3D(5.0f, 0.0f,  5.0f),  QVector2D(1.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f)},
             {QVector3D(-5.0f, 0.0f,  5.0f),  QVector2D(0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f)},
             {QVector3D(-5.0f, 0.0f, -5.0f),  QVector2D(0.0f, 1.0f), QVector3D(0.0f, 1.0f, 0.0f)},
@@ -78,12 +60,12 @@ QVector<VertexData> FloorGeometry::getVerticesData() {
             {QVector3D(5.0f, 0.0f, -5.0f),  QVector2D(1.0f, 1.0f), QVector3D(0.0f, 1.0f, 0.0f)}
     };
 
-    return vertices;
+    return floorVertices;
 }
 
-QVector<GLuint> FloorGeometry::getIndices() {
-    indices = {
+const QVector<GLuint>& FloorGeometry::getIndices() const {
+    static const QVector<GLuint> floorIndices = {
             0, 1, 2, 3, 4, 5
     };
-    return indices;
+    return floorIndices;
 }
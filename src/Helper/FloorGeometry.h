@@ -16,6 +16,9 @@ public:
     FloorGeometry() = default;
     ~FloorGeometry() override = default;
 
+    FloorGeometry(FloorGeometry &&) = default;
+    FloorGeometry& operator=(FloorGeometry &&) = default;
+
     void initGeometry() override;
     void setupAttributePointer(QOpenGLShaderProgram *program) override;
     void drawGeometry(QOpenGLShaderProgram *program,
@@ -29,12 +32,8 @@ public:
     void drawGeometry(QOpenGLShaderProgram *program);
 
 protected:
-    QVector<VertexData> getVerticesData() override;
-    QVector<GLuint> getIndices() override;
-
-private:
-    QVector<VertexData> vertices;
-    QVector<GLuint> indices;
+    const QVector<VertexData>& getVerticesData() const override;
+    const QVector<GLuint>& getIndices() const override;
 
 };
 
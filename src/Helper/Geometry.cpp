@@ -1,19 +1,112 @@
 #include "Geometry.h"
 
 Geometry::Geometry()
-        : vbo(QOpenGLBuffer::VertexBuffer),
+        : vao(new QOpenGLVertexArrayObject),
+        vbo(QOpenGLBuffer::VertexBuffer),
         ebo(QOpenGLBuffer::IndexBuffer)
 {
     QOpenGLFunctions_4_5_Core::initializeOpenGLFunctions();
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
     vbo.create();
     ebo.create();
 }
 
+Geometry::Geometry(Geometry &&other) noexcept
+        : vertexLayout(std::move(other.vertexLayout)),
+        vao(std::move(other.vao)),
+        vbo(other.vbo),
+        ebo(other.ebo),
+        m_IndexCount(other.m_IndexCount)
+{
+    QOpenGLFunctions_4_5_Core::initializeOpenGLFunctions();
+
+    for (int i = 0; i < MAX_VERTEX_STREAMS - 1; i++)
+        extraStreams[i] = other.extraStreams[i];
+    other.releaseBuffers();
+}
+
+Geometry& Geometry::operator=(Geometry &&other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    destroyBuffers();
+
+    vertexLayout = std::move(other.vertexLayout);
+    vao = std::move(other.vao);
+    vbo = other.vbo;
+    ebo = other.ebo;
+    for (int i = 0; i < MAX_VERTEX_STREAMS - 1; i++)
+        extraStreams[i] = other.extraStreams[i];
+    m_IndexCount = other.m_IndexCount;
+    other.releaseBuffers();
+
+    return *this;
+}
+
 Geometry::~Geometry()
 {
-    vao.destroy();
+    destroyBuffers();
+}
+
+void Geometry::destroyBuffers() {
+    if (vao)
+        vao->destroy();
     vbo.destroy();
     ebo.destroy();
+    for (auto &buffer : extraStreams)
+        buffer.destroy();
+}
+
+void Geometry::releaseBuffers() {
+    // QOpenGLBuffer copies share the buffer, fresh ones leave it to the other side
+    vbo = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+    ebo = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+    for (auto &buffer : extraStreams)
+        buffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+    m_IndexCount = 0;
+}
+
+void Geometry::allocateVertexStreams(const QVector<VertexData> &data) {
+    if (vertexLayout.isEmpty())
+        vertexLayout = VertexLayout::fullLayout();
+
+    for (int stream = 0; stream < vertexLayout.streamCount(); stream++) {
+        QOpenGLBuffer &buffer = streamBuffer(stream);
+        if (!buffer.isCreated())
+            buffer.create();
+
+        QByteArray bytes = vertexLayout.pack(data.constData(), data.count(), stream);
+
+        buffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+        buffer.bind();
+        buffer.allocate(bytes.constData(), bytes.size());
+    }
+}
+
+void Geometry::allocateIndices(const QVector<GLuint> &data) {
+    ebo.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    ebo.bind();
+    ebo.allocate(data.constData(), data.count() * sizeof(GLuint));
+
+    m_IndexCount = data.count();
+}
+
+void Geometry::setupVertexLayout(QOpenGLShaderProgram *program) {
+    for (const auto &format : vertexLayout.attributes()) {
+        int location = program->attributeLocation(VertexLayout::attributeName(format.attribute));
+        if (location < 0)
+            continue;
+
+        streamBuffer(format.stream).bind();
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(
+                location,
+                VertexLayout::tupleSize(format.attribute, format.encoding),
+                VertexLayout::glType(format.encoding),
+                VertexLayout::isNormalized(format.encoding),
+                vertexLayout.stride(format.stream),
+                reinterpret_cast<const void*>(quintptr(format.offset)));
+    }
 }
\ No newline at end of file
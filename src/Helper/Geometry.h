@@ -7,6 +7,9 @@
 #include <QOpenGLShaderProgram>
 #include <QOpenGLVertexArrayObject>
 
+#include <memory>
+
+#include "Helper/VertexLayout.h"
 
 struct VertexData
 {
@@ -18,14 +21,35 @@ struct VertexData
     QVector4D bsdata;
     QVector4D m_BoneIDs;
     QVector4D m_Weights;
-    QVector3D ObjectSHCoefficient[9];
 };
 
 
-struct BlendShapePosition{
-    unsigned int m_numAnimPos = 0;
-    QVector<QVector3D> m_AnimDeltaPos;
-    QVector<QVector3D> m_AnimDeltaNor;
+// one non-zero blend shape delta, laid out as a std430 uvec4
+struct MorphEntry {
+    quint32 target;     // global target index, see SparseMorphData::targetBase
+    quint32 delta[3];   // half floats, packHalf2x16(pos.xy), (pos.z, nor.x), (nor.y, nor.z)
+};
+
+/*
+ * Blend shape deltas without the zeros, grouped by vertex so blending is a gather and needs no atomics.
+ * Only vertices moved by at least one target are listed, entries of vertices[k] are
+ * entries[vertexStart[k] .. vertexStart[k + 1]).
+ */
+struct SparseMorphData {
+    QVector<quint32> vertices;
+    QVector<quint32> vertexStart{0};
+    QVector<MorphEntry> entries;
+    // first global target of every blend shape mesh (m_BSID order), the last one is the target count
+    QVector<int> targetBase{0};
+
+    int targetCount() const { return targetBase.last(); }
+};
+
+
+// one entry of an instance buffer (std430): column major model matrix and free material parameters
+struct InstanceData {
+    float model[16];
+    QVector4D material;
 };
 
 
@@ -34,6 +58,11 @@ public:
     Geometry();
     virtual ~Geometry();
 
+    // the GL objects have one owner: moves hand them over, copies are not allowed
+    Geometry(Geometry &&other) noexcept;
+    Geometry& operator=(Geometry &&other) noexcept;
+    Q_DISABLE_COPY(Geometry)
+
     virtual void initGeometry() = 0;
     virtual void setupAttributePointer(QOpenGLShaderProgram *program) = 0;
 
@@ -46,16 +75,36 @@ public:
     virtual void drawGeometry(QOpenGLShaderProgram *program,
             QOpenGLTexture *texture) = 0;
 
-    int VerticesCount() { return getIndices().count(); }
+    // number of indices uploaded by allocateIndices, cached so draw calls never touch the arrays
+    int VerticesCount() const { return m_IndexCount; }
 
 protected:
-    virtual QVector<VertexData> getVerticesData() = 0;
-    virtual QVector<GLuint> getIndices() = 0;
+    virtual const QVector<VertexData>& getVerticesData() const = 0;
+    virtual const QVector<GLuint>& getIndices() const = 0;
+
+    // pack and upload every stream of vertexLayout, call it with the vao bound
+    void allocateVertexStreams(const QVector<VertexData> &data);
+    // point the inputs the program actually declares at their stream
+    void setupVertexLayout(QOpenGLShaderProgram *program);
+    // upload the index buffer and cache its count, call it with the vao bound
+    void allocateIndices(const QVector<GLuint> &data);
+    QOpenGLBuffer& streamBuffer(int stream) { return stream == 0 ? vbo : extraStreams[stream - 1]; }
+
+private:
+    void destroyBuffers();
+    // forget the GL objects without deleting them, they belong to the geometry moved to
+    void releaseBuffers();
 
 protected:
-    QOpenGLVertexArrayObject vao;
+    VertexLayout vertexLayout;
+
+    // on the heap so it can change owner, QOpenGLVertexArrayObject itself cannot be moved
+    std::unique_ptr<QOpenGLVertexArrayObject> vao;
     QOpenGLBuffer vbo;
     QOpenGLBuffer ebo;
+    QOpenGLBuffer extraStreams[MAX_VERTEX_STREAMS - 1];
+
+    int m_IndexCount = 0;
 };
 
 
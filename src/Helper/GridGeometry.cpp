@@ -1,54 +1,42 @@
 #include "GridGeometry.h"
 
 void GridGeometry::initGeometry() {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    vbo.bind();
-    vbo.allocate(getVerticesData().constData(), getVerticesData().count() * sizeof(VertexData));
+    vertexLayout = VertexLayout()
+            .add(VertexAttribute::Position)
+            .add(VertexAttribute::TexCoord, VertexEncoding::HalfFloat);
+    allocateVertexStreams(getVerticesData());
 
-    ebo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    ebo.bind();
-    ebo.allocate(getIndices().constData(), getIndices().count() * sizeof(GLuint));
+    allocateIndices(getIndices());
 }
 
 void GridGeometry::setupAttributePointer(QOpenGLShaderProgram *program) {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    // Offset for position
-    quintptr offset = 0;
-    // Tell OpenGL programmable pipeline how to locate vertex position data
-    int vertexLocation = program->attributeLocation("aPos");
-    program->enableAttributeArray(vertexLocation);
-    program->setAttributeBuffer(vertexLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for texture coordinate
-    offset += sizeof(QVector3D);
-
-    int coordLocation = program->attributeLocation("aCoord");
-    program->enableAttributeArray(coordLocation);
-    program->setAttributeBuffer(coordLocation, GL_FLOAT, offset, 2, sizeof(VertexData));
+    setupVertexLayout(program);
 
     program->release();
 }
 
-QVector<VertexData> GridGeometry::getVerticesData() {
-    vertices = {
+const QVector<VertexData>& GridGeometry::getVerticesData() const {
+    // built once and shared by every instance
+    static const QVector<VertexData> gridVertices = {
             { QVector3D(1.0f, 1.0f, 0.0f), QVector2D(1.0f, 1.0f) },
             { QVector3D(-1.0f, -1.0f, 0.0f), QVector2D(0.0f, 0.0f) },
             { QVector3D(1.0f, -1.0f, 0.0f), QVector2D(1.0f, 0.0f) },
             { QVector3D(-1.0f, 1.0f, 0.0f), QVector2D(0.0f, 1.0f) },
     };
 
-    return vertices;
+    return gridVertices;
 }
 
-QVector<GLuint> GridGeometry::getIndices() {
-    indices = {
+const QVector<GLuint>& GridGeometry::getIndices() const {
+    static const QVector<GLuint> gridIndices = {
             0, 1, 2,
             1, 0, 3
     };
-    return indices;
+    return gridIndices;
 }
 
 void
@@ -61,7 +49,7 @@ GridGeometry::drawGeometry(QOpenGLShaderProgram *program, QMatrix4x4 model, QMat
     program->setUniformValue("projection", projection);
     program->setUniformValue("map", 0);
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     texture->bind();
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)0);
@@ -69,7 +57,7 @@ GridGeometry::drawGeometry(QOpenGLShaderProgram *program, QMatrix4x4 model, QMat
 
 void GridGeometry::drawGeometry(QOpenGLShaderProgram *program) {
     program->bind();
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)0);
 }
@@ -79,7 +67,7 @@ void GridGeometry::drawGeometry(QOpenGLShaderProgram *program, QOpenGLFramebuffe
         fbo->toImage().save(QString("RenderOut/drawScene.png"));
 
     program->bind();
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     GLuint texture;
     QScopedPointer<QOpenGLFramebufferObject> tmpFBO;
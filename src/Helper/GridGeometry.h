@@ -16,6 +16,9 @@ public:
     GridGeometry() = default;
     ~GridGeometry() override = default;
 
+    GridGeometry(GridGeometry &&) = default;
+    GridGeometry& operator=(GridGeometry &&) = default;
+
     void initGeometry() override;
     void setupAttributePointer(QOpenGLShaderProgram *program) override;
     void drawGeometry(QOpenGLShaderProgram *program,
@@ -34,12 +37,8 @@ public:
                       QOpenGLTexture *texture) override {}
 
 protected:
-    QVector<VertexData> getVerticesData() override;
-    QVector<GLuint> getIndices() override;
-
-private:
-    QVector<VertexData> vertices;
-    QVector<GLuint> indices;
+    const QVector<VertexData>& getVerticesData() const override;
+    const QVector<GLuint>& getIndices() const override;
 };
 
 
@@ -0,0 +1,37 @@
+#include "IBLCache.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QCryptographicHash>
+
+QString IBLCache::key(const QString &hdrPath) {
+    // content rather than name or date, a replaced file with the same name must not hit
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QFile file(hdrPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "ERROR::IBL_CACHE:: cannot read" << hdrPath;
+        return QString();
+    }
+    hash.addData(&file);
+    return QString::fromLatin1(hash.result().toHex().left(16));
+}
+
+IBLCachePaths IBLCache::paths(const QString &hdrPath, const IBLSettings &settings) {
+    QDir().mkpath(IBL_CACHE_DIRECTORY);
+
+    IBLCachePaths paths;
+    QString hdrKey = key(hdrPath);
+    if (!hdrKey.isEmpty()) {
+        QString base = QString(IBL_CACHE_DIRECTORY "/%1_env%2").arg(hdrKey).arg(settings.envSize);
+        paths.envCubemap = base + ".ktx";
+        paths.irradianceMap = base + QString("_irradiance%1.ktx").arg(settings.irradianceSize);
+        paths.prefilterMap = base + QString("_prefilter%1_s%2.ktx").arg(settings.prefilterSize).arg(settings.prefilterSamples);
+    }
+    paths.brdfLUTTexture = QString(IBL_CACHE_DIRECTORY "/brdf%1_s%2.ktx").arg(settings.brdfSize).arg(settings.brdfSamples);
+    return paths;
+}
+
+QString IBLCache::compressedPath(const QString &path) {
+    return path.chopped(4) + "_bc6h.ktx";
+}
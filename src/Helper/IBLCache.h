@@ -0,0 +1,46 @@
+#ifndef QTREFERENCE_IBLCACHE_H
+#define QTREFERENCE_IBLCACHE_H
+
+#include <QString>
+
+// relative to the working directory like every other resource path
+#define IBL_CACHE_DIRECTORY "src/texture/HDR/cache"
+
+struct IBLSettings {
+    int envSize = 512;
+    int irradianceSize = 128;
+    int prefilterSize = 128;
+    // the samples read pre-filtered mip levels of the environment, far fewer are needed than for brute force
+    int prefilterSamples = 128;
+    int brdfSize = 512;
+    int brdfSamples = 1024;
+    // diffuse only viewers skip the prefiltered map and the BRDF LUT
+    bool specular = true;
+    // environment, irradiance and prefiltered maps as BC6H, a sixth of the half float size
+    bool compressed = true;
+};
+
+struct IBLCachePaths {
+    QString envCubemap;
+    QString irradianceMap;
+    QString prefilterMap;
+    QString brdfLUTTexture;
+};
+
+/*
+ * Naming of the IBL cache shared by the GPU precompute and the CPU reference, so either one can
+ * fill the cache for the other. Every map made from an environment is keyed by the content hash
+ * of the HDR plus the sizes and sample counts it was made with; the BRDF LUT only by its own.
+ */
+class IBLCache {
+public:
+    // empty when the HDR cannot be read
+    static QString key(const QString &hdrPath);
+    // also creates IBL_CACHE_DIRECTORY, the maps of an unreadable HDR get empty paths
+    static IBLCachePaths paths(const QString &hdrPath, const IBLSettings &settings);
+    // the BC6H copy of a cached cube map
+    static QString compressedPath(const QString &path);
+};
+
+
+#endif
@@ -0,0 +1,386 @@
+#include "IBLPrecompute.h"
+#include "KTXFile.h"
+#include "CubeGeometry.h"
+#include "RectangleGeometry.h"
+#include "IBLReference.h"
+#include "BlockCompression.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include "stb_image.h"
+
+IBLPrecompute::IBLPrecompute() {
+    QOpenGLFunctions_4_5_Core::initializeOpenGLFunctions();
+    glCreateFramebuffers(1, &captureFBO);
+
+    captureProjection.perspective(90.0f, 1.0f, 0.1f, 10.0f);
+    const QVector3D targets[6] = {
+            QVector3D(1.0f, 0.0f, 0.0f), QVector3D(-1.0f, 0.0f, 0.0f),
+            QVector3D(0.0f, 1.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f),
+            QVector3D(0.0f, 0.0f, 1.0f), QVector3D(0.0f, 0.0f, -1.0f)};
+    const QVector3D ups[6] = {
+            QVector3D(0.0f, -1.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f),
+            QVector3D(0.0f, 0.0f, 1.0f), QVector3D(0.0f, 0.0f, -1.0f),
+            QVector3D(0.0f, -1.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f)};
+    for (int face = 0; face < 6; face++) {
+        QMatrix4x4 view;
+        view.lookAt(QVector3D(0.0f, 0.0f, 0.0f), targets[face], ups[face]);
+        captureViews << view;
+    }
+}
+
+IBLPrecompute::~IBLPrecompute() {
+    delete equirectangularProgram;
+    delete irradianceProgram;
+    delete prefilterProgram;
+    delete brdfProgram;
+    delete cubeGeometry;
+    delete quadGeometry;
+    glDeleteFramebuffers(1, &captureFBO);
+}
+
+IBLMaps IBLPrecompute::load(const QString &hdrPath, const IBLSettings &settings) {
+    QElapsedTimer timer;
+    timer.start();
+
+    IBLCachePaths paths = IBLCache::paths(hdrPath, settings);
+    if (paths.envCubemap.isEmpty()) {
+        qDebug() << "ERROR::IBL_PRECOMPUTE:: no IBL maps for" << hdrPath;
+        return IBLMaps();
+    }
+
+    // a widget calls this with its own framebuffer bound, which is not 0
+    GLint viewport[4], framebuffer;
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    auto restoreState = [&]() {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        if (depthTest)
+            glEnable(GL_DEPTH_TEST);
+    };
+
+    IBLMaps maps;
+    int rendered = 0;
+
+    // the half float maps are only read or rendered to make missing BC6H ones
+    if (!settings.compressed || !loadCompressedMaps(paths, settings, maps)) {
+        maps.envCubemap = loadCached(paths.envCubemap, QOpenGLTexture::TargetCubeMap, settings.envSize, QOpenGLTexture::RGB16F);
+        if (!maps.envCubemap) {
+            QOpenGLTexture *hdrTexture = loadHDRTexture(hdrPath);
+            if (!hdrTexture) {
+                // nothing to render the other maps from, and nothing of it may reach the cache
+                qDebug() << "ERROR::IBL_PRECOMPUTE:: no IBL maps for" << hdrPath;
+                restoreState();
+                return IBLMaps();
+            }
+            maps.envCubemap = createMap(QOpenGLTexture::TargetCubeMap, settings.envSize, 0, QOpenGLTexture::RGB16F);
+            renderEnvCubeMap(hdrTexture, maps.envCubemap);
+            saveCached(maps.envCubemap, paths.envCubemap);
+            delete hdrTexture;
+            rendered++;
+        }
+
+        maps.irradianceMap = loadCached(paths.irradianceMap, QOpenGLTexture::TargetCubeMap, settings.irradianceSize, QOpenGLTexture::RGB16F);
+        if (!maps.irradianceMap) {
+            maps.irradianceMap = createMap(QOpenGLTexture::TargetCubeMap, settings.irradianceSize, 1, QOpenGLTexture::RGB16F);
+            renderIrradianceMap(maps.envCubemap, maps.irradianceMap);
+            saveCached(maps.irradianceMap, paths.irradianceMap);
+            rendered++;
+        }
+
+        if (settings.specular) {
+            // RGBA, image load store has no three channel formats
+            maps.prefilterMap = loadCached(paths.prefilterMap, QOpenGLTexture::TargetCubeMap, settings.prefilterSize, QOpenGLTexture::RGBA16F);
+            if (!maps.prefilterMap) {
+                maps.prefilterMap = createMap(QOpenGLTexture::TargetCubeMap, settings.prefilterSize, 0, QOpenGLTexture::RGBA16F);
+                renderPrefilterMap(maps.envCubemap, maps.prefilterMap, settings.prefilterSamples);
+                saveCached(maps.prefilterMap, paths.prefilterMap);
+                rendered++;
+            }
+        }
+
+        if (settings.compressed) {
+            maps.envCubemap = compressMap(maps.envCubemap, IBLCache::compressedPath(paths.envCubemap));
+            maps.irradianceMap = compressMap(maps.irradianceMap, IBLCache::compressedPath(paths.irradianceMap));
+            if (maps.prefilterMap)
+                maps.prefilterMap = compressMap(maps.prefilterMap, IBLCache::compressedPath(paths.prefilterMap));
+        }
+    }
+
+    if (settings.specular) {
+        maps.brdfLUTTexture = loadCached(paths.brdfLUTTexture, QOpenGLTexture::Target2D, settings.brdfSize, QOpenGLTexture::RG16F);
+        if (!maps.brdfLUTTexture) {
+            maps.brdfLUTTexture = createMap(QOpenGLTexture::Target2D, settings.brdfSize, 1, QOpenGLTexture::RG16F);
+            renderBRDFMap(maps.brdfLUTTexture, settings.brdfSamples);
+            saveCached(maps.brdfLUTTexture, paths.brdfLUTTexture);
+            rendered++;
+        }
+    }
+
+    restoreState();
+
+    qDebug() << "IBL maps of" << hdrPath << ":" << rendered << "rendered," << (settings.specular ? 4 : 2) - rendered
+             << "from cache in" << timer.elapsed() << "ms";
+    return maps;
+}
+
+QOpenGLTexture* IBLPrecompute::createMap(QOpenGLTexture::Target target, int size, int mipLevels, QOpenGLTexture::TextureFormat format) {
+    auto *texture = new QOpenGLTexture(target);
+    texture->create();
+    texture->setSize(size, size);
+    texture->setFormat(format);
+    // 0 asks for the whole chain
+    texture->setMipLevels(mipLevels > 0 ? mipLevels : texture->maximumMipLevels());
+    texture->allocateStorage();
+
+    texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+    texture->setMinificationFilter(texture->mipLevels() > 1 ? QOpenGLTexture::LinearMipMapLinear : QOpenGLTexture::Linear);
+    texture->setMagnificationFilter(QOpenGLTexture::Linear);
+    return texture;
+}
+
+QOpenGLTexture* IBLPrecompute::loadCached(const QString &path, QOpenGLTexture::Target target, int size, QOpenGLTexture::TextureFormat format) {
+    KTXFile file;
+    if (!file.load(path))
+        return nullptr;
+
+    // block compressed files have no type
+    quint32 type = format == QOpenGLTexture::RGB_BP_UNSIGNED_FLOAT ? 0 : GL_HALF_FLOAT;
+    quint32 faces = target == QOpenGLTexture::TargetCubeMap ? 6 : 1;
+    if (file.glInternalFormat != quint32(format) || file.glType != type || file.width != quint32(size) || file.faces != faces)
+        return nullptr;
+
+    return uploadCached(file, target, format);
+}
+
+QOpenGLTexture* IBLPrecompute::uploadCached(const KTXFile &file, QOpenGLTexture::Target target, QOpenGLTexture::TextureFormat format) {
+    auto pixelFormat = QOpenGLTexture::PixelFormat(file.glFormat);
+    QOpenGLTexture *texture = createMap(target, int(file.width), file.levelCount(), format);
+    for (int level = 0; level < file.levelCount(); level++) {
+        for (int face = 0; face < int(file.faces); face++) {
+            if (file.glType == 0) {
+                auto cubeFace = QOpenGLTexture::CubeMapFace(QOpenGLTexture::CubeMapPositiveX + face);
+                texture->setCompressedData(level, 0, cubeFace, int(file.faceSize(level)), file.faceData(level, face));
+            } else if (file.faces == 1) {
+                texture->setData(level, pixelFormat, QOpenGLTexture::Float16, file.faceData(level, 0));
+            } else {
+                auto cubeFace = QOpenGLTexture::CubeMapFace(QOpenGLTexture::CubeMapPositiveX + face);
+                texture->setData(level, 0, cubeFace, pixelFormat, QOpenGLTexture::Float16, file.faceData(level, face));
+            }
+        }
+    }
+    return texture;
+}
+
+void IBLPrecompute::saveCached(QOpenGLTexture *texture, const QString &path) {
+    int channels = texture->format() == QOpenGLTexture::RG16F ? 2 : texture->format() == QOpenGLTexture::RGB16F ? 3 : 4;
+
+    KTXFile file;
+    file.glType = GL_HALF_FLOAT;
+    file.glTypeSize = 2;
+    file.glFormat = channels == 2 ? GL_RG : channels == 3 ? GL_RGB : GL_RGBA;
+    file.glInternalFormat = texture->format();
+    file.glBaseInternalFormat = file.glFormat;
+    file.width = texture->width();
+    file.height = texture->height();
+    file.faces = texture->target() == QOpenGLTexture::TargetCubeMap ? 6 : 1;
+
+    // rows padded to the default pack alignment of 4, which is also what KTX expects
+    for (int level = 0; level < texture->mipLevels(); level++) {
+        int size = qMax(1, texture->width() >> level);
+        int rowPitch = (size * channels * 2 + 3) & ~3;
+        QByteArray data(rowPitch * size * int(file.faces), Qt::Uninitialized);
+        glGetTextureImage(texture->textureId(), level, file.glFormat, GL_HALF_FLOAT, data.size(), data.data());
+        file.levels << data;
+    }
+
+    if (!file.save(path))
+        qDebug() << "ERROR::IBL_PRECOMPUTE:: failed to write" << path;
+}
+
+bool IBLPrecompute::loadCompressedMaps(const IBLCachePaths &paths, const IBLSettings &settings, IBLMaps &maps) {
+    const auto format = QOpenGLTexture::RGB_BP_UNSIGNED_FLOAT;
+    maps.envCubemap = loadCached(IBLCache::compressedPath(paths.envCubemap), QOpenGLTexture::TargetCubeMap, settings.envSize, format);
+    maps.irradianceMap = loadCached(IBLCache::compressedPath(paths.irradianceMap), QOpenGLTexture::TargetCubeMap, settings.irradianceSize, format);
+    if (settings.specular)
+        maps.prefilterMap = loadCached(IBLCache::compressedPath(paths.prefilterMap), QOpenGLTexture::TargetCubeMap, settings.prefilterSize, format);
+
+    if (maps.envCubemap && maps.irradianceMap && (maps.prefilterMap || !settings.specular))
+        return true;
+
+    delete maps.envCubemap;
+    delete maps.irradianceMap;
+    delete maps.prefilterMap;
+    maps = IBLMaps();
+    return false;
+}
+
+QOpenGLTexture* IBLPrecompute::compressMap(QOpenGLTexture *texture, const QString &path) {
+    KTXFile file;
+    file.glInternalFormat = QOpenGLTexture::RGB_BP_UNSIGNED_FLOAT;
+    file.glBaseInternalFormat = GL_RGB;
+    file.width = texture->width();
+    file.height = texture->height();
+    file.faces = 6;
+
+    // read back as RGB, the alpha of the prefiltered map is always 1
+    for (int level = 0; level < texture->mipLevels(); level++) {
+        int size = qMax(1, texture->width() >> level);
+        int rowPitch = (size * 3 * 2 + 3) & ~3;
+        QByteArray texels(rowPitch * size * 6, Qt::Uninitialized);
+        glGetTextureImage(texture->textureId(), level, GL_RGB, GL_HALF_FLOAT, texels.size(), texels.data());
+
+        QByteArray blocks;
+        for (int face = 0; face < 6; face++) {
+            const auto *faceTexels = reinterpret_cast<const qfloat16*>(texels.constData() + face * rowPitch * size);
+            blocks += BlockCompression::compressBC6H(faceTexels, size, size, 3, rowPitch);
+        }
+        file.levels << blocks;
+    }
+
+    if (!file.save(path))
+        qDebug() << "ERROR::IBL_PRECOMPUTE:: failed to write" << path;
+
+    QOpenGLTexture *compressed = uploadCached(file, QOpenGLTexture::TargetCubeMap, QOpenGLTexture::RGB_BP_UNSIGNED_FLOAT);
+    delete texture;
+    return compressed;
+}
+
+QOpenGLTexture* IBLPrecompute::loadHDRTexture(const QString &hdrPath) {
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load(true);
+    float *image = stbi_loadf(hdrPath.toLocal8Bit().constData(), &width, &height, &channels, 3);
+    if (!image) {
+        qDebug() << "ERROR::IBL_PRECOMPUTE:: failed to load" << hdrPath;
+        return nullptr;
+    }
+
+    auto *hdrTexture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    hdrTexture->create();
+    hdrTexture->setSize(width, height);
+    hdrTexture->setFormat(QOpenGLTexture::RGB32F);
+    hdrTexture->allocateStorage();
+
+    hdrTexture->setData(0, 0, QOpenGLTexture::RGB, QOpenGLTexture::Float32, image, Q_NULLPTR);
+    hdrTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
+    hdrTexture->setMinificationFilter(QOpenGLTexture::Linear);
+    hdrTexture->setMagnificationFilter(QOpenGLTexture::Linear);
+
+    stbi_image_free(image);
+    return hdrTexture;
+}
+
+QOpenGLShaderProgram* IBLPrecompute::createProgram(const QString &vertexPath, const QString &fragmentPath) {
+    auto *program = new QOpenGLShaderProgram;
+    if (!program->addShaderFromSourceFile(QOpenGLShader::Vertex, vertexPath) ||
+        !program->addShaderFromSourceFile(QOpenGLShader::Fragment, fragmentPath) ||
+        !program->link())
+        qDebug() << "ERROR::IBL_PRECOMPUTE:: failed to build" << fragmentPath;
+    return program;
+}
+
+void IBLPrecompute::renderCubeFaces(QOpenGLShaderProgram *program, QOpenGLTexture *target, int mip) {
+    if (!cubeGeometry) {
+        // every cube pass shares CubeMap.vs.glsl, one attribute setup fits all of them
+        cubeGeometry = new CubeGeometry;
+        cubeGeometry->initGeometry();
+        cubeGeometry->setupAttributePointer(program);
+    }
+
+    int size = qMax(1, target->width() >> mip);
+    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    glViewport(0, 0, size, size);
+
+    program->bind();
+    program->setUniformValue("projection", captureProjection);
+    for (int face = 0; face < captureViews.count(); face++) {
+        program->setUniformValue("view", captureViews[face]);
+        glNamedFramebufferTextureLayer(captureFBO, GL_COLOR_ATTACHMENT0, target->textureId(), mip, face);
+        cubeGeometry->drawGeometry(program);
+    }
+}
+
+void IBLPrecompute::renderEnvCubeMap(QOpenGLTexture *hdrTexture, QOpenGLTexture *envCubemap) {
+    if (!equirectangularProgram)
+        equirectangularProgram = createProgram("src/Shaders/CubeMap.vs.glsl", "src/Shaders/EquirectangularToMap.fs.glsl");
+
+    equirectangularProgram->bind();
+    equirectangularProgram->setUniformValue("equirectangularMap", 0);
+    hdrTexture->bind(0);
+    renderCubeFaces(equirectangularProgram, envCubemap, 0);
+
+    // the prefilter pass samples the chain to keep rough lobes from aliasing
+    envCubemap->generateMipMaps();
+}
+
+void IBLPrecompute::renderIrradianceMap(QOpenGLTexture *envCubemap, QOpenGLTexture *irradianceMap) {
+    if (!irradianceProgram)
+        irradianceProgram = createProgram("src/Shaders/CubeMap.vs.glsl", "src/Shaders/IrradianceConvolution.fs.glsl");
+
+    irradianceProgram->bind();
+    irradianceProgram->setUniformValue("environmentMap", 0);
+    envCubemap->bind(0);
+    renderCubeFaces(irradianceProgram, irradianceMap, 0);
+}
+
+void IBLPrecompute::renderPrefilterMap(QOpenGLTexture *envCubemap, QOpenGLTexture *prefilterMap, int sampleCount) {
+    if (!prefilterProgram) {
+        prefilterProgram = new QOpenGLShaderProgram;
+        if (!prefilterProgram->addShaderFromSourceFile(QOpenGLShader::Compute, "src/Shaders/Prefilter.cs.glsl") ||
+            !prefilterProgram->link())
+            qDebug() << "ERROR::IBL_PRECOMPUTE:: failed to build src/Shaders/Prefilter.cs.glsl";
+    }
+
+    prefilterProgram->bind();
+    prefilterProgram->setUniformValue("environmentMap", 0);
+    envCubemap->bind(0);
+
+    GLuint sampleBuffer;
+    glCreateBuffers(1, &sampleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, IBL_SAMPLE_BINDING, sampleBuffer);
+
+    // one dispatch per mip level writes all six faces, the samples come with their source mip
+    // level already picked so a few hundred of them are enough where brute force needs thousands
+    int maxMipLevels = prefilterMap->mipLevels();
+    for (int mip = 0; mip < maxMipLevels; mip++) {
+        float totalWeight;
+        float roughness = float(mip) / float(qMax(1, maxMipLevels - 1));
+        QVector<QVector4D> samples = IBLReference::prefilterSamples(roughness, sampleCount, envCubemap->width(), totalWeight);
+        glNamedBufferData(sampleBuffer, samples.count() * sizeof(QVector4D), samples.constData(), GL_STREAM_DRAW);
+
+        prefilterProgram->setUniformValue("sampleCount", int(samples.count()));
+        prefilterProgram->setUniformValue("totalWeight", totalWeight);
+        glBindImageTexture(0, prefilterMap->textureId(), mip, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+        int size = qMax(1, prefilterMap->width() >> mip);
+        glDispatchCompute((size + 7) / 8, (size + 7) / 8, 6);
+    }
+
+    // saveCached reads it back and the viewer samples it
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    glDeleteBuffers(1, &sampleBuffer);
+}
+
+void IBLPrecompute::renderBRDFMap(QOpenGLTexture *brdfLUTTexture, int sampleCount) {
+    if (!brdfProgram)
+        brdfProgram = createProgram("src/Shaders/BRDF.vs.glsl", "src/Shaders/BRDF.fs.glsl");
+    if (!quadGeometry) {
+        quadGeometry = new RectangleGeometry;
+        quadGeometry->initGeometry();
+        quadGeometry->setupAttributePointer(brdfProgram);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    glNamedFramebufferTexture(captureFBO, GL_COLOR_ATTACHMENT0, brdfLUTTexture->textureId(), 0);
+    glViewport(0, 0, brdfLUTTexture->width(), brdfLUTTexture->height());
+
+    brdfProgram->bind();
+    brdfProgram->setUniformValue("sampleCount", GLuint(sampleCount));
+    quadGeometry->drawGeometry(brdfProgram);
+}
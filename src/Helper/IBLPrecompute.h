@@ -0,0 +1,75 @@
+#ifndef QTREFERENCE_IBLPRECOMPUTE_H
+#define QTREFERENCE_IBLPRECOMPUTE_H
+
+#include <QOpenGLTexture>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLFunctions_4_5_Core>
+#include <QMatrix4x4>
+#include <QVector>
+
+#include "IBLCache.h"
+
+// storage buffer of the prefilter samples in Prefilter.cs.glsl, clear of the bindings the viewers use
+#define IBL_SAMPLE_BINDING 9
+
+class KTXFile;
+class CubeGeometry;
+class RectangleGeometry;
+
+// the caller owns the textures
+struct IBLMaps {
+    QOpenGLTexture *envCubemap = nullptr;
+    QOpenGLTexture *irradianceMap = nullptr;
+    QOpenGLTexture *prefilterMap = nullptr;
+    QOpenGLTexture *brdfLUTTexture = nullptr;
+};
+
+/*
+ * Image based lighting inputs of an equirectangular HDR: environment cube map, irradiance map,
+ * GGX prefiltered map and split sum BRDF LUT, all half float. Every map is cached in
+ * IBL_CACHE_DIRECTORY as a KTX mip chain named by IBLCache, so a warm start only reads and
+ * uploads them. The BRDF LUT does not depend on the HDR, one file serves every environment and
+ * every viewer. With IBLSettings::compressed the three cube maps are transcoded to BC6H once and
+ * cached beside the half float files; a warm start then reads only the BC6H ones.
+ */
+class IBLPrecompute : protected QOpenGLFunctions_4_5_Core {
+public:
+    // needs a current context, the capture resources live as long as this object
+    IBLPrecompute();
+    ~IBLPrecompute();
+
+    IBLMaps load(const QString &hdrPath, const IBLSettings &settings = IBLSettings());
+
+private:
+    QOpenGLTexture* createMap(QOpenGLTexture::Target target, int size, int mipLevels, QOpenGLTexture::TextureFormat format);
+    QOpenGLTexture* loadCached(const QString &path, QOpenGLTexture::Target target, int size, QOpenGLTexture::TextureFormat format);
+    QOpenGLTexture* uploadCached(const KTXFile &file, QOpenGLTexture::Target target, QOpenGLTexture::TextureFormat format);
+    void saveCached(QOpenGLTexture *texture, const QString &path);
+    // all or nothing, maps stays empty unless every compressed map is cached
+    bool loadCompressedMaps(const IBLCachePaths &paths, const IBLSettings &settings, IBLMaps &maps);
+    // replaces the half float cube map with its BC6H copy
+    QOpenGLTexture* compressMap(QOpenGLTexture *texture, const QString &path);
+    QOpenGLTexture* loadHDRTexture(const QString &hdrPath);
+    QOpenGLShaderProgram* createProgram(const QString &vertexPath, const QString &fragmentPath);
+
+    void renderCubeFaces(QOpenGLShaderProgram *program, QOpenGLTexture *target, int mip);
+    void renderEnvCubeMap(QOpenGLTexture *hdrTexture, QOpenGLTexture *envCubemap);
+    void renderIrradianceMap(QOpenGLTexture *envCubemap, QOpenGLTexture *irradianceMap);
+    void renderPrefilterMap(QOpenGLTexture *envCubemap, QOpenGLTexture *prefilterMap, int sampleCount);
+    void renderBRDFMap(QOpenGLTexture *brdfLUTTexture, int sampleCount);
+
+    GLuint captureFBO = 0;
+    QMatrix4x4 captureProjection;
+    QVector<QMatrix4x4> captureViews;
+
+    // built on first use, a warm start never compiles them
+    CubeGeometry *cubeGeometry = nullptr;
+    RectangleGeometry *quadGeometry = nullptr;
+    QOpenGLShaderProgram *equirectangularProgram = nullptr;
+    QOpenGLShaderProgram *irradianceProgram = nullptr;
+    QOpenGLShaderProgram *prefilterProgram = nullptr;
+    QOpenGLShaderProgram *brdfProgram = nullptr;
+};
+
+
+#endif
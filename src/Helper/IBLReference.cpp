@@ -0,0 +1,492 @@
+#include "IBLReference.h"
+
+#include <QDebug>
+#include <QFloat16>
+
+#include <cmath>
+#include <algorithm>
+
+#include "stb_image.h"
+
+// GL enums of the cache files, spelled out so this file builds without GL headers
+enum : quint32 {
+    KTX_HALF_FLOAT = 0x140B,
+    KTX_RG = 0x8227,
+    KTX_RGB = 0x1907,
+    KTX_RGBA = 0x1908,
+    KTX_RG16F = 0x822F,
+    KTX_RGB16F = 0x881B,
+    KTX_RGBA16F = 0x881A
+};
+
+static const float PI = 3.14159265359f;
+static const int TILE_SIZE = 32;
+
+struct Tile {
+    int level;
+    int face;
+    int x0, y0, x1, y1;
+};
+
+// every face of every level in TILE_SIZE squares, the largest levels first so they start first
+static QVector<Tile> makeTiles(const QVector<int> &levelSizes, int faces) {
+    QVector<Tile> tiles;
+    for (int level = 0; level < levelSizes.count(); level++) {
+        int size = levelSizes[level];
+        for (int face = 0; face < faces; face++)
+            for (int y = 0; y < size; y += TILE_SIZE)
+                for (int x = 0; x < size; x += TILE_SIZE)
+                    tiles.push_back({level, face, x, y, qMin(x + TILE_SIZE, size), qMin(y + TILE_SIZE, size)});
+    }
+    return tiles;
+}
+
+template <typename Function>
+static void runTiles(const QVector<Tile> &tiles, Function function) {
+    const Tile *data = tiles.constData();
+    const int tileCount = tiles.count();
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int i = 0; i < tileCount; i++) {
+        function(data[i], i);
+    }
+}
+
+static QVector<int> mipSizes(int size, bool mipmapped) {
+    QVector<int> sizes{size};
+    while (mipmapped && size > 1)
+        sizes << (size = qMax(1, size / 2));
+    return sizes;
+}
+
+// direction through the texel center, the same mapping a samplerCube uses
+static void texelDirection(int face, int x, int y, int size, float dir[3]) {
+    float sc = 2.0f * (x + 0.5f) / size - 1.0f;
+    float tc = 2.0f * (y + 0.5f) / size - 1.0f;
+    switch (face) {
+        case 0: dir[0] = 1.0f; dir[1] = -tc;  dir[2] = -sc;  break;
+        case 1: dir[0] = -1.0f; dir[1] = -tc; dir[2] = sc;   break;
+        case 2: dir[0] = sc;   dir[1] = 1.0f; dir[2] = tc;   break;
+        case 3: dir[0] = sc;   dir[1] = -1.0f; dir[2] = -tc; break;
+        case 4: dir[0] = sc;   dir[1] = -tc;  dir[2] = 1.0f; break;
+        default: dir[0] = -sc; dir[1] = -tc;  dir[2] = -1.0f; break;
+    }
+    float invLength = 1.0f / std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+    dir[0] *= invLength;
+    dir[1] *= invLength;
+    dir[2] *= invLength;
+}
+
+static void directionToFace(const float dir[3], int &face, float &s, float &t) {
+    float ax = std::fabs(dir[0]), ay = std::fabs(dir[1]), az = std::fabs(dir[2]);
+    float ma, sc, tc;
+    if (ax >= ay && ax >= az) {
+        face = dir[0] > 0.0f ? 0 : 1;
+        ma = ax; sc = dir[0] > 0.0f ? -dir[2] : dir[2]; tc = -dir[1];
+    }
+    else if (ay >= az) {
+        face = dir[1] > 0.0f ? 2 : 3;
+        ma = ay; sc = dir[0]; tc = dir[1] > 0.0f ? dir[2] : -dir[2];
+    }
+    else {
+        face = dir[2] > 0.0f ? 4 : 5;
+        ma = az; sc = dir[2] > 0.0f ? dir[0] : -dir[0]; tc = -dir[1];
+    }
+    s = 0.5f * (sc / ma + 1.0f);
+    t = 0.5f * (tc / ma + 1.0f);
+}
+
+static float radicalInverse(quint32 bits) {
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+// tangent space GGX half vectors of the Hammersley set, the inputs of both specular passes
+static void importanceSampleGGX(int sampleCount, float roughness, QVector<float> &hx, QVector<float> &hy, QVector<float> &hz) {
+    float a = roughness * roughness;
+    hx.resize(sampleCount);
+    hy.resize(sampleCount);
+    hz.resize(sampleCount);
+    for (int i = 0; i < sampleCount; i++) {
+        float phi = 2.0f * PI * float(i) / float(sampleCount);
+        float xi = radicalInverse(quint32(i));
+        float cosTheta = std::sqrt((1.0f - xi) / (1.0f + (a * a - 1.0f) * xi));
+        float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        hx[i] = std::cos(phi) * sinTheta;
+        hy[i] = std::sin(phi) * sinTheta;
+        hz[i] = cosTheta;
+    }
+}
+
+// half float with rows padded to 4 bytes, as the GPU cache stores a level
+static QByteArray packLevel(const float *texels, int size, int faces, int channels) {
+    int rowFloats = size * channels;
+    int rowPitch = (rowFloats * int(sizeof(qfloat16)) + 3) & ~3;
+    QByteArray data(rowPitch * size * faces, 0);
+    for (int row = 0; row < size * faces; row++)
+        qFloatToFloat16(reinterpret_cast<qfloat16*>(data.data() + row * rowPitch), texels + row * rowFloats, rowFloats);
+    return data;
+}
+
+static KTXFile makeFile(const QVector<QByteArray> &levels, int size, int faces, int channels) {
+    KTXFile file;
+    file.glType = KTX_HALF_FLOAT;
+    file.glTypeSize = 2;
+    file.glFormat = channels == 2 ? KTX_RG : channels == 3 ? KTX_RGB : KTX_RGBA;
+    file.glInternalFormat = channels == 2 ? KTX_RG16F : channels == 3 ? KTX_RGB16F : KTX_RGBA16F;
+    file.glBaseInternalFormat = file.glFormat;
+    file.width = size;
+    file.height = size;
+    file.faces = faces;
+    file.levels = levels;
+    return file;
+}
+
+bool IBLReference::loadEnvironment(const QString &hdrPath, int envSize) {
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load(true);
+    float *image = stbi_loadf(hdrPath.toLocal8Bit().constData(), &width, &height, &channels, 3);
+    if (!image) {
+        qDebug() << "ERROR::IBL_REFERENCE:: failed to load" << hdrPath;
+        return false;
+    }
+
+    // level 0 samples the equirectangular map like EquirectangularToMap.fs.glsl
+    m_Env.clear();
+    for (int size : mipSizes(envSize, true)) {
+        CubeLevel level;
+        level.size = size;
+        level.texels.resize(6 * size * size * 3);
+        m_Env << level;
+    }
+
+    float *env = m_Env[0].texels.data();
+    runTiles(makeTiles({envSize}, 6), [&](const Tile &tile, int) {
+        for (int y = tile.y0; y < tile.y1; y++) {
+            for (int x = tile.x0; x < tile.x1; x++) {
+                float dir[3];
+                texelDirection(tile.face, x, y, envSize, dir);
+                // horizontally the map wraps around, vertically it clamps
+                float u = std::atan2(dir[2], dir[0]) * 0.1591f + 0.5f;
+                float v = std::asin(qBound(-1.0f, dir[1], 1.0f)) * 0.3183f + 0.5f;
+                float fx = u * width - 0.5f, fy = qBound(0.0f, v * height - 0.5f, float(height - 1));
+                int x0 = int(std::floor(fx)), y0 = int(fy);
+                float tx = fx - x0, ty = fy - y0;
+                int x1 = (x0 + 1 + width) % width, y1 = qMin(y0 + 1, height - 1);
+                x0 = (x0 + width) % width;
+
+                float *out = env + ((tile.face * envSize + y) * envSize + x) * 3;
+                for (int c = 0; c < 3; c++) {
+                    float top = image[(y0 * width + x0) * 3 + c] * (1.0f - tx) + image[(y0 * width + x1) * 3 + c] * tx;
+                    float bottom = image[(y1 * width + x0) * 3 + c] * (1.0f - tx) + image[(y1 * width + x1) * 3 + c] * tx;
+                    out[c] = top * (1.0f - ty) + bottom * ty;
+                }
+            }
+        }
+    });
+    stbi_image_free(image);
+
+    // the rest of the chain is the 2x2 box filter of glGenerateMipmap
+    for (int level = 1; level < m_Env.count(); level++) {
+        const CubeLevel &source = m_Env[level - 1];
+        CubeLevel &target = m_Env[level];
+        const float *in = source.texels.constData();
+        float *out = target.texels.data();
+        runTiles(makeTiles({target.size}, 6), [&](const Tile &tile, int) {
+            for (int y = tile.y0; y < tile.y1; y++) {
+                for (int x = tile.x0; x < tile.x1; x++) {
+                    int sx0 = qMin(2 * x, source.size - 1), sx1 = qMin(2 * x + 1, source.size - 1);
+                    int sy0 = qMin(2 * y, source.size - 1), sy1 = qMin(2 * y + 1, source.size - 1);
+                    const float *face = in + tile.face * source.size * source.size * 3;
+                    for (int c = 0; c < 3; c++) {
+                        out[((tile.face * target.size + y) * target.size + x) * 3 + c] = 0.25f * (
+                                face[(sy0 * source.size + sx0) * 3 + c] + face[(sy0 * source.size + sx1) * 3 + c] +
+                                face[(sy1 * source.size + sx0) * 3 + c] + face[(sy1 * source.size + sx1) * 3 + c]);
+                    }
+                }
+            }
+        });
+    }
+
+    projectSH();
+    return true;
+}
+
+void IBLReference::projectSH() {
+    const CubeLevel &level = m_Env[0];
+    const int size = level.size;
+    const QVector<Tile> tiles = makeTiles({size}, 6);
+
+    // one partial sum per tile, added up in tile order so the result does not depend on threading
+    QVector<double> partial(tiles.count() * 27, 0.0);
+    double *partialData = partial.data();
+    runTiles(tiles, [&](const Tile &tile, int index) {
+        double sum[27] = {};
+        for (int y = tile.y0; y < tile.y1; y++) {
+            for (int x = tile.x0; x < tile.x1; x++) {
+                float dir[3];
+                texelDirection(tile.face, x, y, size, dir);
+                // solid angle of the texel
+                float sc = 2.0f * (x + 0.5f) / size - 1.0f, tc = 2.0f * (y + 0.5f) / size - 1.0f;
+                float weight = 4.0f / (size * size * std::pow(1.0f + sc * sc + tc * tc, 1.5f));
+
+                const float X = dir[0], Y = dir[1], Z = dir[2];
+                const float basis[9] = {
+                        0.282095f,
+                        0.488603f * Y, 0.488603f * Z, 0.488603f * X,
+                        1.092548f * X * Y, 1.092548f * Y * Z, 0.315392f * (3.0f * Z * Z - 1.0f),
+                        1.092548f * X * Z, 0.546274f * (X * X - Y * Y)};
+                const float *radiance = level.texels.constData() + ((tile.face * size + y) * size + x) * 3;
+                for (int k = 0; k < 9; k++)
+                    for (int c = 0; c < 3; c++)
+                        sum[k * 3 + c] += radiance[c] * basis[k] * weight;
+            }
+        }
+        std::copy(sum, sum + 27, partialData + index * 27);
+    });
+
+    m_SH = QVector<QVector3D>(9);
+    for (int i = 0; i < tiles.count(); i++)
+        for (int k = 0; k < 9; k++)
+            m_SH[k] += QVector3D(partial[i * 27 + k * 3], partial[i * 27 + k * 3 + 1], partial[i * 27 + k * 3 + 2]);
+}
+
+void IBLReference::sampleLevel(const CubeLevel &level, const float dir[3], float rgb[3]) const {
+    int face;
+    float s, t;
+    directionToFace(dir, face, s, t);
+
+    // bilinear, clamped at the face border
+    const int size = level.size;
+    float fx = qBound(0.0f, s * size - 0.5f, float(size - 1));
+    float fy = qBound(0.0f, t * size - 0.5f, float(size - 1));
+    int x0 = int(fx), y0 = int(fy);
+    int x1 = qMin(x0 + 1, size - 1), y1 = qMin(y0 + 1, size - 1);
+    float tx = fx - x0, ty = fy - y0;
+
+    const float *texels = level.texels.constData() + face * size * size * 3;
+    const float *p00 = texels + (y0 * size + x0) * 3, *p10 = texels + (y0 * size + x1) * 3;
+    const float *p01 = texels + (y1 * size + x0) * 3, *p11 = texels + (y1 * size + x1) * 3;
+    for (int c = 0; c < 3; c++)
+        rgb[c] = (p00[c] * (1.0f - tx) + p10[c] * tx) * (1.0f - ty) + (p01[c] * (1.0f - tx) + p11[c] * tx) * ty;
+}
+
+void IBLReference::sampleLod(float lod, const float dir[3], float rgb[3]) const {
+    lod = qBound(0.0f, lod, float(m_Env.count() - 1));
+    int level = int(lod);
+    float t = lod - level;
+
+    sampleLevel(m_Env[level], dir, rgb);
+    if (t > 0.0f && level + 1 < m_Env.count()) {
+        float next[3];
+        sampleLevel(m_Env[level + 1], dir, next);
+        for (int c = 0; c < 3; c++)
+            rgb[c] += (next[c] - rgb[c]) * t;
+    }
+}
+
+KTXFile IBLReference::envCubemap() const {
+    QVector<QByteArray> levels;
+    for (const auto &level : m_Env)
+        levels << packLevel(level.texels.constData(), level.size, 6, 3);
+    return makeFile(levels, m_Env[0].size, 6, 3);
+}
+
+KTXFile IBLReference::irradianceMap(int size) const {
+    // cosine lobe convolution of the SH, divided by PI like IrradianceConvolution.fs.glsl
+    const float band[9] = {1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f};
+    float coefficients[9][3];
+    for (int k = 0; k < 9; k++)
+        for (int c = 0; c < 3; c++)
+            coefficients[k][c] = m_SH[k][c] * band[k];
+
+    QVector<float> texels(6 * size * size * 3);
+    float *out = texels.data();
+    runTiles(makeTiles({size}, 6), [&](const Tile &tile, int) {
+        for (int y = tile.y0; y < tile.y1; y++) {
+            for (int x = tile.x0; x < tile.x1; x++) {
+                float dir[3];
+                texelDirection(tile.face, x, y, size, dir);
+                const float X = dir[0], Y = dir[1], Z = dir[2];
+                const float basis[9] = {
+                        0.282095f,
+                        0.488603f * Y, 0.488603f * Z, 0.488603f * X,
+                        1.092548f * X * Y, 1.092548f * Y * Z, 0.315392f * (3.0f * Z * Z - 1.0f),
+                        1.092548f * X * Z, 0.546274f * (X * X - Y * Y)};
+                float *irradiance = out + ((tile.face * size + y) * size + x) * 3;
+                for (int c = 0; c < 3; c++) {
+                    float sum = 0.0f;
+                    for (int k = 0; k < 9; k++)
+                        sum += coefficients[k][c] * basis[k];
+                    irradiance[c] = qMax(0.0f, sum);
+                }
+            }
+        }
+    });
+
+    return makeFile({packLevel(texels.constData(), size, 6, 3)}, size, 6, 3);
+}
+
+QVector<QVector4D> IBLReference::prefilterSamples(float roughness, int sampleCount, int envSize, float &totalWeight) {
+    // a perfect mirror, every sample lands on N
+    if (roughness == 0.0f) {
+        totalWeight = 1.0f;
+        return {QVector4D(0.0f, 0.0f, 1.0f, 0.0f)};
+    }
+
+    QVector<float> hx, hy, hz;
+    importanceSampleGGX(sampleCount, roughness, hx, hy, hz);
+
+    const float a2 = roughness * roughness * roughness * roughness;
+    const float saTexel = 4.0f * PI / (6.0f * envSize * envSize);
+    QVector<QVector4D> samples;
+    totalWeight = 0.0f;
+    for (int i = 0; i < sampleCount; i++) {
+        // L = reflect(-V, H) with V = N = (0, 0, 1)
+        float lx = 2.0f * hz[i] * hx[i], ly = 2.0f * hz[i] * hy[i], lz = 2.0f * hz[i] * hz[i] - 1.0f;
+        if (lz <= 0.0f)
+            continue;
+
+        // filtered importance sampling: the sample reads the mip whose texels cover its solid angle
+        float NdotH = hz[i];
+        float denominator = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+        float D = a2 / (PI * denominator * denominator);
+        float pdf = D * NdotH / (4.0f * NdotH) + 0.0001f;
+        float saSample = 1.0f / (float(sampleCount) * pdf + 0.0001f);
+
+        samples << QVector4D(lx, ly, lz, qMax(0.0f, 0.5f * std::log2(saSample / saTexel)));
+        totalWeight += lz;
+    }
+    return samples;
+}
+
+KTXFile IBLReference::prefilterMap(int size, int sampleCount) const {
+    const QVector<int> sizes = mipSizes(size, true);
+    const int levelCount = sizes.count();
+
+    // with V = N every term but the rotation into the texel frame is the same for all texels
+    struct SampleTable {
+        QVector<float> lx, ly, lz, lod;
+        float totalWeight = 0.0f;
+    };
+    QVector<SampleTable> tables(levelCount);
+    for (int level = 0; level < levelCount; level++) {
+        float roughness = float(level) / float(qMax(1, levelCount - 1));
+        SampleTable &table = tables[level];
+        for (const auto &sample : prefilterSamples(roughness, sampleCount, m_Env[0].size, table.totalWeight)) {
+            table.lx << sample.x();
+            table.ly << sample.y();
+            table.lz << sample.z();
+            table.lod << sample.w();
+        }
+    }
+
+    // take the pointers before going wide so no thread triggers a detach
+    QVector<QVector<float>> texels(levelCount);
+    QVector<float*> levelData(levelCount);
+    for (int level = 0; level < levelCount; level++) {
+        texels[level].resize(6 * sizes[level] * sizes[level] * 4);
+        levelData[level] = texels[level].data();
+    }
+
+    runTiles(makeTiles(sizes, 6), [&](const Tile &tile, int) {
+        const int levelSize = sizes[tile.level];
+        const SampleTable &table = tables[tile.level];
+        const int count = table.lx.count();
+        QVector<float> wx(count), wy(count), wz(count);
+
+        for (int y = tile.y0; y < tile.y1; y++) {
+            for (int x = tile.x0; x < tile.x1; x++) {
+                float N[3];
+                texelDirection(tile.face, x, y, levelSize, N);
+
+                // the tangent frame of ImportanceSampleGGX
+                float up[3] = {0.0f, 0.0f, 1.0f};
+                if (std::fabs(N[2]) >= 0.999f) {
+                    up[0] = 1.0f;
+                    up[2] = 0.0f;
+                }
+                float T[3] = {up[1] * N[2] - up[2] * N[1], up[2] * N[0] - up[0] * N[2], up[0] * N[1] - up[1] * N[0]};
+                float invLength = 1.0f / std::sqrt(T[0] * T[0] + T[1] * T[1] + T[2] * T[2]);
+                T[0] *= invLength; T[1] *= invLength; T[2] *= invLength;
+                float B[3] = {N[1] * T[2] - N[2] * T[1], N[2] * T[0] - N[0] * T[2], N[0] * T[1] - N[1] * T[0]};
+
+                const float *lx = table.lx.constData(), *ly = table.ly.constData(), *lz = table.lz.constData();
+                float *px = wx.data(), *py = wy.data(), *pz = wz.data();
+#pragma omp simd
+                for (int i = 0; i < count; i++) {
+                    px[i] = T[0] * lx[i] + B[0] * ly[i] + N[0] * lz[i];
+                    py[i] = T[1] * lx[i] + B[1] * ly[i] + N[1] * lz[i];
+                    pz[i] = T[2] * lx[i] + B[2] * ly[i] + N[2] * lz[i];
+                }
+
+                float color[3] = {0.0f, 0.0f, 0.0f};
+                for (int i = 0; i < count; i++) {
+                    float L[3] = {px[i], py[i], pz[i]}, rgb[3];
+                    sampleLod(table.lod[i], L, rgb);
+                    color[0] += rgb[0] * lz[i];
+                    color[1] += rgb[1] * lz[i];
+                    color[2] += rgb[2] * lz[i];
+                }
+
+                // RGBA like the image the compute shader stores to
+                float *out = levelData.at(tile.level) + ((tile.face * levelSize + y) * levelSize + x) * 4;
+                for (int c = 0; c < 3; c++)
+                    out[c] = color[c] / table.totalWeight;
+                out[3] = 1.0f;
+            }
+        }
+    });
+
+    QVector<QByteArray> levels;
+    for (int level = 0; level < levelCount; level++)
+        levels << packLevel(texels[level].constData(), sizes[level], 6, 4);
+    return makeFile(levels, size, 6, 4);
+}
+
+KTXFile IBLReference::brdfLUT(int size, int sampleCount) {
+    // rows are roughness, one sample table each
+    QVector<QVector<float>> hx(size), hy(size), hz(size);
+    for (int y = 0; y < size; y++)
+        importanceSampleGGX(sampleCount, (y + 0.5f) / size, hx[y], hy[y], hz[y]);
+
+    QVector<float> texels(size * size * 2);
+    float *out = texels.data();
+    runTiles(makeTiles({size}, 1), [&](const Tile &tile, int) {
+        for (int y = tile.y0; y < tile.y1; y++) {
+            float roughness = (y + 0.5f) / size;
+            float k = roughness * roughness / 2.0f;
+            // the frame around N = (0, 0, 1) turns tangent (x, y) into world (y, -x)
+            const float *Hx = hy[y].constData(), *Hz = hz[y].constData();
+            for (int x = tile.x0; x < tile.x1; x++) {
+                float NdotV = (x + 0.5f) / size;
+                float Vx = std::sqrt(1.0f - NdotV * NdotV);
+                float GV = NdotV / (NdotV * (1.0f - k) + k);
+
+                float A = 0.0f, B = 0.0f;
+#pragma omp simd reduction(+:A, B)
+                for (int i = 0; i < sampleCount; i++) {
+                    float VdotH = Vx * Hx[i] + NdotV * Hz[i];
+                    float NdotL = 2.0f * VdotH * Hz[i] - NdotV;
+                    if (NdotL > 0.0f) {
+                        VdotH = VdotH > 0.0f ? VdotH : 0.0f;
+                        float G = GV * NdotL / (NdotL * (1.0f - k) + k);
+                        float G_Vis = G * VdotH / (Hz[i] * NdotV);
+                        float Fc = (1.0f - VdotH) * (1.0f - VdotH);
+                        Fc = Fc * Fc * (1.0f - VdotH);
+                        A += (1.0f - Fc) * G_Vis;
+                        B += Fc * G_Vis;
+                    }
+                }
+                out[(y * size + x) * 2] = A / float(sampleCount);
+                out[(y * size + x) * 2 + 1] = B / float(sampleCount);
+            }
+        }
+    });
+
+    return makeFile({packLevel(texels.constData(), size, 1, 2)}, size, 1, 2);
+}
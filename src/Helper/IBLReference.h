@@ -0,0 +1,56 @@
+#ifndef QTREFERENCE_IBLREFERENCE_H
+#define QTREFERENCE_IBLREFERENCE_H
+
+#include <QString>
+#include <QVector>
+#include <QVector3D>
+#include <QVector4D>
+
+#include "KTXFile.h"
+
+/*
+ * CPU reference of IBLPrecompute for machines without a GPU and for checking the GPU maps. It
+ * follows the shaders step by step (cube face layout, Hammersley sequence, GGX sampling, sample
+ * mip selection) except for the irradiance map, which is evaluated from the order 2 spherical
+ * harmonics of the environment instead of integrating the hemisphere texel by texel.
+ * The texels of a map, all faces and mip levels together, are cut into tiles that the threads
+ * pick up one at a time. Every per sample term that does not depend on the texel is tabulated
+ * before going wide, so the inner loops only rotate, fetch and accumulate.
+ * Every map comes back as a half float KTXFile laid out like the GPU cache files.
+ */
+class IBLReference {
+public:
+    IBLReference() = default;
+
+    bool loadEnvironment(const QString &hdrPath, int envSize = 512);
+
+    KTXFile envCubemap() const;
+    KTXFile irradianceMap(int size) const;
+    KTXFile prefilterMap(int size, int sampleCount) const;
+    // does not depend on the environment
+    static KTXFile brdfLUT(int size, int sampleCount);
+
+    // tangent space L (xyz) and source mip level (w) of the GGX samples of one roughness with
+    // NdotL > 0, the same for every texel since V = N; weighted by NdotL, the weights add up to totalWeight
+    static QVector<QVector4D> prefilterSamples(float roughness, int sampleCount, int envSize, float &totalWeight);
+
+    // order 2 SH of the environment radiance, 9 RGB coefficients, valid after loadEnvironment
+    const QVector<QVector3D>& shCoefficients() const { return m_SH; }
+
+private:
+    struct CubeLevel {
+        int size = 0;
+        // faces back to back, RGB, rows in the order glGetTextureImage returns them
+        QVector<float> texels;
+    };
+
+    void projectSH();
+    void sampleLevel(const CubeLevel &level, const float dir[3], float rgb[3]) const;
+    void sampleLod(float lod, const float dir[3], float rgb[3]) const;
+
+    QVector<CubeLevel> m_Env;
+    QVector<QVector3D> m_SH;
+};
+
+
+#endif
@@ -0,0 +1,93 @@
+#include "KTXFile.h"
+
+#include <QFile>
+
+#include <cstring>
+
+static const char ktxIdentifier[12] = {'\xAB', 'K', 'T', 'X', ' ', '1', '1', '\xBB', '\r', '\n', '\x1A', '\n'};
+
+// the 13 words following the identifier
+struct KTXHeader {
+    quint32 endianness;
+    quint32 glType;
+    quint32 glTypeSize;
+    quint32 glFormat;
+    quint32 glInternalFormat;
+    quint32 glBaseInternalFormat;
+    quint32 pixelWidth;
+    quint32 pixelHeight;
+    quint32 pixelDepth;
+    quint32 numberOfArrayElements;
+    quint32 numberOfFaces;
+    quint32 numberOfMipmapLevels;
+    quint32 bytesOfKeyValueData;
+};
+
+bool KTXFile::save(const QString &outFile) const {
+    QFile file(outFile);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    KTXHeader header = {0x04030201, glType, glTypeSize, glFormat, glInternalFormat, glBaseInternalFormat,
+                        width, height, 0, 0, faces, quint32(levels.count()), 0};
+    file.write(ktxIdentifier, sizeof(ktxIdentifier));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    const char padding[4] = {0, 0, 0, 0};
+    for (int level = 0; level < levels.count(); level++) {
+        // cube maps store the size of one face, everything else the size of the level
+        quint32 imageSize = faces == 6 ? quint32(faceSize(level)) : quint32(levels[level].size());
+        file.write(reinterpret_cast<const char*>(&imageSize), sizeof(imageSize));
+        for (int face = 0; face < int(faces); face++) {
+            file.write(faceData(level, face), faceSize(level));
+            file.write(padding, (4 - faceSize(level) % 4) % 4);
+        }
+    }
+    file.close();
+
+    return true;
+}
+
+bool KTXFile::load(const QString &inFile) {
+    QFile file(inFile);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    char identifier[12];
+    KTXHeader header;
+    if (file.read(identifier, sizeof(identifier)) != sizeof(identifier) || memcmp(identifier, ktxIdentifier, sizeof(identifier)) != 0)
+        return false;
+    // files of the other byte order are not swapped, they are only ever written on this machine
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header) || header.endianness != 0x04030201)
+        return false;
+    if (header.pixelDepth > 1 || header.numberOfArrayElements > 0 || (header.numberOfFaces != 1 && header.numberOfFaces != 6))
+        return false;
+
+    glType = header.glType;
+    glTypeSize = header.glTypeSize;
+    glFormat = header.glFormat;
+    glInternalFormat = header.glInternalFormat;
+    glBaseInternalFormat = header.glBaseInternalFormat;
+    width = header.pixelWidth;
+    height = header.pixelHeight;
+    faces = header.numberOfFaces;
+    file.skip(header.bytesOfKeyValueData);
+
+    levels.resize(qMax(1u, header.numberOfMipmapLevels));
+    for (auto &level : levels) {
+        quint32 imageSize = 0;
+        if (file.read(reinterpret_cast<char*>(&imageSize), sizeof(imageSize)) != sizeof(imageSize))
+            return false;
+
+        qint64 faceBytes = faces == 6 ? imageSize : imageSize / faces;
+        level.resize(faceBytes * faces);
+        for (int face = 0; face < int(faces); face++) {
+            if (file.read(level.data() + face * faceBytes, faceBytes) != faceBytes)
+                return false;
+            file.skip((4 - faceBytes % 4) % 4);
+        }
+    }
+    file.close();
+
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef QTREFERENCE_KTXFILE_H
+#define QTREFERENCE_KTXFILE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/*
+ * KTX 1.1 container of a 2D texture or cube map with its whole mip chain, the data of a level is
+ * laid out exactly as glGetTextureImage returns it with the default pack alignment: every face
+ * back to back, rows padded to 4 bytes. Compressed formats leave glType and glFormat at 0.
+ */
+class KTXFile {
+public:
+    KTXFile() = default;
+
+    bool save(const QString &outFile) const;
+    bool load(const QString &inFile);
+
+    int levelCount() const { return levels.count(); }
+    qint64 faceSize(int level) const { return levels[level].size() / faces; }
+    const char* faceData(int level, int face) const { return levels[level].constData() + face * faceSize(level); }
+
+    quint32 glType = 0;
+    quint32 glTypeSize = 1;
+    quint32 glFormat = 0;
+    quint32 glInternalFormat = 0;
+    quint32 glBaseInternalFormat = 0;
+    quint32 width = 0;
+    quint32 height = 0;
+    // 6 for cube maps
+    quint32 faces = 1;
+    // one entry per mip level, the faces of a level back to back
+    QVector<QByteArray> levels;
+};
+
+
+#endif
@@ -0,0 +1,69 @@
+#include "PersistentBuffer.h"
+
+#include <QDebug>
+
+PersistentBuffer::PersistentBuffer() {
+    QOpenGLFunctions_4_5_Core::initializeOpenGLFunctions();
+
+    GLint alignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0)
+        m_Alignment = alignment;
+}
+
+PersistentBuffer::~PersistentBuffer() {
+    release();
+}
+
+void PersistentBuffer::allocate(int frameSize) {
+    release();
+
+    m_FrameSize = align(frameSize);
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &m_Buffer);
+    glNamedBufferStorage(m_Buffer, GLsizeiptr(m_FrameSize) * PERSISTENT_BUFFER_FRAMES, nullptr, flags);
+    m_Mapped = static_cast<char*>(glMapNamedBufferRange(m_Buffer, 0, GLsizeiptr(m_FrameSize) * PERSISTENT_BUFFER_FRAMES, flags));
+
+    if (!m_Mapped)
+        qDebug() << "ERROR::PERSISTENT_BUFFER:: map failed, size" << m_FrameSize * PERSISTENT_BUFFER_FRAMES;
+}
+
+char* PersistentBuffer::beginFrame() {
+    GLsync &fence = m_Fences[m_Frame];
+    if (fence) {
+        // normally already signaled, the ring is deep enough for the gpu to catch up
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    return m_Mapped + m_Frame * m_FrameSize;
+}
+
+void PersistentBuffer::bindRange(GLuint binding, int offset, int size) {
+    Q_ASSERT(offset + size <= m_FrameSize);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, m_Buffer, GLintptr(m_Frame) * m_FrameSize + offset, size);
+}
+
+void PersistentBuffer::endFrame() {
+    m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_Frame = (m_Frame + 1) % PERSISTENT_BUFFER_FRAMES;
+}
+
+void PersistentBuffer::release() {
+    for (auto &fence : m_Fences) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    if (m_Buffer) {
+        if (m_Mapped)
+            glUnmapNamedBuffer(m_Buffer);
+        glDeleteBuffers(1, &m_Buffer);
+    }
+
+    m_Buffer = 0;
+    m_Mapped = nullptr;
+    m_Frame = 0;
+}
@@ -0,0 +1,44 @@
+#ifndef _PERSISTENTBUFFER_H_
+#define _PERSISTENTBUFFER_H_
+
+#include <QOpenGLFunctions_4_5_Core>
+
+#define PERSISTENT_BUFFER_FRAMES 3
+
+/*
+ * Shader storage buffer mapped once for its whole lifetime. It is split into
+ * PERSISTENT_BUFFER_FRAMES regions, the cpu writes one region per frame while the gpu may still
+ * read the previous ones, a fence per region keeps them from overlapping.
+ */
+class PersistentBuffer : protected QOpenGLFunctions_4_5_Core {
+public:
+    PersistentBuffer();
+    ~PersistentBuffer();
+
+    // frameSize in bytes, the size of one region
+    void allocate(int frameSize);
+    bool isCreated() const { return m_Buffer != 0; }
+
+    // round a section size up so the next section can be bound with glBindBufferRange
+    int align(int bytes) const { return (bytes + m_Alignment - 1) / m_Alignment * m_Alignment; }
+
+    // wait until the gpu is done with the next region and return where to write it
+    char* beginFrame();
+    // bind [offset, offset + size) of the current region, offset must come from align()
+    void bindRange(GLuint binding, int offset, int size);
+    // fence the region after the draws that read it were issued
+    void endFrame();
+
+private:
+    void release();
+
+    GLuint m_Buffer = 0;
+    char *m_Mapped = nullptr;
+    int m_FrameSize = 0;
+    int m_Alignment = 256;
+    int m_Frame = 0;
+    GLsync m_Fences[PERSISTENT_BUFFER_FRAMES] = {nullptr};
+};
+
+
+#endif
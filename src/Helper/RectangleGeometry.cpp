@@ -1,54 +1,42 @@
 #include "RectangleGeometry.h"
 
 void RectangleGeometry::initGeometry() {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    vbo.bind();
-    vbo.allocate(getVerticesData().constData(), getVerticesData().count() * sizeof(VertexData));
+    vertexLayout = VertexLayout()
+            .add(VertexAttribute::Position)
+            .add(VertexAttribute::TexCoord, VertexEncoding::HalfFloat);
+    allocateVertexStreams(getVerticesData());
 
-    ebo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    ebo.bind();
-    ebo.allocate(getIndices().constData(), getIndices().count() * sizeof(GLuint));
+    allocateIndices(getIndices());
 }
 
 void RectangleGeometry::setupAttributePointer(QOpenGLShaderProgram *program) {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    // Offset for position
-    quintptr offset = 0;
-    // Tell OpenGL programmable pipeline how to locate vertex position data
-    int vertexLocation = program->attributeLocation("aPos");
-    program->enableAttributeArray(vertexLocation);
-    program->setAttributeBuffer(vertexLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for texture coordinate
-    offset += sizeof(QVector3D);
-
-    int coordLocation = program->attributeLocation("aCoord");
-    program->enableAttributeArray(coordLocation);
-    program->setAttributeBuffer(coordLocation, GL_FLOAT, offset, 2, sizeof(VertexData));
+    setupVertexLayout(program);
 
     program->release();
 }
 
-QVector<VertexData> RectangleGeometry::getVerticesData() {
-    vertices = {
+const QVector<VertexData>& RectangleGeometry::getVerticesData() const {
+    // built once and shared by every instance
+    static const QVector<VertexData> rectangleVertices = {
             { QVector3D(1.0f, 1.0f, 0.0f), QVector2D(1.0f, 1.0f) },
             { QVector3D(-1.0f, -1.0f, 0.0f), QVector2D(0.0f, 0.0f) },
             { QVector3D(1.0f, -1.0f, 0.0f), QVector2D(1.0f, 0.0f) },
             { QVector3D(-1.0f, 1.0f, 0.0f), QVector2D(0.0f, 1.0f) },
     };
 
-    return vertices;
+    return rectangleVertices;
 }
 
-QVector<GLuint> RectangleGeometry::getIndices() {
-    indices = {
+const QVector<GLuint>& RectangleGeometry::getIndices() const {
+    static const QVector<GLuint> rectangleIndices = {
             0, 1, 2,
             1, 0, 3
     };
-    return indices;
+    return rectangleIndices;
 }
 
 void
@@ -61,7 +49,7 @@ RectangleGeometry::drawGeometry(QOpenGLShaderProgram *program, QMatrix4x4 model,
     program->setUniformValue("projection", projection);
     program->setUniformValue("map", 0);
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     texture->bind();
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)nullptr);
@@ -69,7 +57,7 @@ RectangleGeometry::drawGeometry(QOpenGLShaderProgram *program, QMatrix4x4 model,
 
 void RectangleGeometry::drawGeometry(QOpenGLShaderProgram *program, QOpenGLTexture *texture) {
     program->bind();
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     texture->bind();
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)nullptr);
@@ -77,7 +65,7 @@ void RectangleGeometry::drawGeometry(QOpenGLShaderProgram *program, QOpenGLTextu
 
 void RectangleGeometry::drawGeometry(QOpenGLShaderProgram *program) {
     program->bind();
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)nullptr);
 }
@@ -87,7 +75,7 @@ void RectangleGeometry::drawGeometry(QOpenGLShaderProgram *program, QOpenGLFrame
         fbo->toImage().save(QString("F:/CLionProjects/QtReference/OutputImages/drawScene.png"));
 
     program->bind();
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     GLuint texture;
     QScopedPointer<QOpenGLFramebufferObject> tmpFBO;
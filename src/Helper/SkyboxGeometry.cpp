@@ -1,26 +1,19 @@
 #include "SkyboxGeometry.h"
 
 void SkyboxGeometry::initGeometry() {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    vbo.bind();
-    vbo.allocate(getVerticesData().constData(), getVerticesData().count() * sizeof(VertexData));
+    vertexLayout = VertexLayout()
+            .add(VertexAttribute::Position);
+    allocateVertexStreams(getVerticesData());
 
-    ebo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    ebo.bind();
-    ebo.allocate(getIndices().constData(), getIndices().count() * sizeof(GLuint));
+    allocateIndices(getIndices());
 }
 
 void SkyboxGeometry::setupAttributePointer(QOpenGLShaderProgram *program) {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-    // Offset for position
-    quintptr offset = 0;
-    // Tell OpenGL programmable pipeline how to locate vertex position data
-    int vertexLocation = program->attributeLocation("aPos");
-    program->enableAttributeArray(vertexLocation);
-    program->setAttributeBuffer(vertexLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
+    setupVertexLayout(program);
 
     program->release();
 }
@@ -42,7 +35,7 @@ void SkyboxGeometry::drawGeometry(QOpenGLShaderProgram *program,
     program->setUniformValue("view", view);
     program->setUniformValue("projection", projection);
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)0);
 }
 
@@ -57,15 +50,16 @@ void SkyboxGeometry::drawGeometry(QOpenGLShaderProgram *program,
     program->setUniformValue("projection", projection);
     program->setUniformValue("cubeMap", 0);
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     texture->bind();
     glBindTexture(GL_TEXTURE_CUBE_MAP, texture->textureId());
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)0);
 }
 
-QVector<VertexData> SkyboxGeometry::getVerticesData() {
-    vertices = {
+const QVector<VertexData>& SkyboxGeometry::getVerticesData() const {
+    // built once and shared by every instance
+    static const QVector<VertexData> skyboxVertices = {
             {QVector3D(-1.0f,  1.0f, -1.0f), QVector2D(0.0f, 0.0f)},
             {QVector3D(-1.0f, -1.0f, -1.0f), QVector2D(0.0f, 0.0f)},
             {QVector3D(1.0f, -1.0f, -1.0f), QVector2D(0.0f, 0.0f)},
@@ -108,11 +102,11 @@ QVector<VertexData> SkyboxGeometry::getVerticesData() {
             {QVector3D(-1.0f, -1.0f,  1.0f), QVector2D(0.0f, 0.0f)},
             {QVector3D(1.0f, -1.0f,  1.0f), QVector2D(0.0f, 0.0f)}
     };
-    return vertices;
+    return skyboxVertices;
 }
 
-QVector<GLuint> SkyboxGeometry::getIndices() {
-    indices = {
+const QVector<GLuint>& SkyboxGeometry::getIndices() const {
+    static const QVector<GLuint> skyboxIndices = {
             0,1,2,3,4,5,
             6,7,8,9,10,11,
             12,13,14,15,16,17,
@@ -120,5 +114,5 @@ QVector<GLuint> SkyboxGeometry::getIndices() {
             24,25,26,27,28,29,
             30,31,32,33,34,35
     };
-    return indices;
+    return skyboxIndices;
 }
@@ -17,6 +17,9 @@ public:
     SkyboxGeometry() = default;
     ~SkyboxGeometry() override = default;
 
+    SkyboxGeometry(SkyboxGeometry &&) = default;
+    SkyboxGeometry& operator=(SkyboxGeometry &&) = default;
+
     void initGeometry() override;
     void setupAttributePointer(QOpenGLShaderProgram *program) override;
     void drawGeometry(QOpenGLShaderProgram *program,
@@ -36,12 +39,8 @@ public:
 
 
 protected:
-    QVector<VertexData> getVerticesData() override;
-    QVector<GLuint> getIndices() override;
-
-private:
-    QVector<VertexData> vertices;
-    QVector<GLuint> indices;
+    const QVector<VertexData>& getVerticesData() const override;
+    const QVector<GLuint>& getIndices() const override;
 };
 
 
@@ -2,43 +2,23 @@
 #include <cmath>
 
 void SphereGeometry::initGeometry() {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     setupSphere();
 
-    vbo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    vbo.bind();
-    vbo.allocate(getVerticesData().constData(), getVerticesData().count() * sizeof(VertexData));
+    vertexLayout = VertexLayout()
+            .add(VertexAttribute::Position)
+            .add(VertexAttribute::TexCoord, VertexEncoding::HalfFloat)
+            .add(VertexAttribute::Normal, VertexEncoding::PackedNormal);
+    allocateVertexStreams(getVerticesData());
 
-    ebo.setUsagePattern(QOpenGLBuffer::StaticDraw);
-    ebo.bind();
-    ebo.allocate(getIndices().constData(), getIndices().count() * sizeof(GLuint));
+    allocateIndices(getIndices());
 }
 
 void SphereGeometry::setupAttributePointer(QOpenGLShaderProgram *program) {
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
-
-    // Offset for position
-    quintptr offset = 0;
-    // Tell OpenGL programmable pipeline how to locate vertex position data
-    int vertexLocation = program->attributeLocation("aPos");
-    program->enableAttributeArray(vertexLocation);
-    program->setAttributeBuffer(vertexLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
-
-    // Offset for texture coordinate
-    offset += sizeof(QVector3D);
-
-    int coordLocation = program->attributeLocation("aCoord");
-    program->enableAttributeArray(coordLocation);
-    program->setAttributeBuffer(coordLocation, GL_FLOAT, offset, 2, sizeof(VertexData));
-
-    // Offset for normal
-    offset += sizeof(QVector2D);
-
-    int normalLocation = program->attributeLocation("aNormal");
-    program->enableAttributeArray(normalLocation);
-    program->setAttributeBuffer(normalLocation, GL_FLOAT, offset, 3, sizeof(VertexData));
+    setupVertexLayout(program);
 
     program->release();
 }
@@ -53,7 +33,7 @@ SphereGeometry::drawGeometry(QOpenGLShaderProgram *program, QMatrix4x4 model, QM
     program->setUniformValue("projection", projection);
     program->setUniformValue("colorMap", 0);
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
 
     texture->bind();
     glDrawElements(GL_TRIANGLES, VerticesCount(), GL_UNSIGNED_INT, (void*)0);
@@ -67,15 +47,25 @@ SphereGeometry::drawGeometry(QOpenGLShaderProgram *program, QMatrix4x4 model, QM
     program->setUniformValue("view", view);
     program->setUniformValue("projection", projection);
 
-    QOpenGLVertexArrayObject::Binder vaoBinder(&vao);
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
     glDrawElements(GL_TRIANGLE_STRIP, VerticesCount(), GL_UNSIGNED_INT, (void*)0);
 }
 
-QVector<VertexData> SphereGeometry::getVerticesData() {
+void SphereGeometry::drawGeometryInstanced(QOpenGLShaderProgram *program, QMatrix4x4 view, QMatrix4x4 projection, int instanceCount, int baseInstance) {
+    program->bind();
+
+    program->setUniformValue("view", view);
+    program->setUniformValue("projection", projection);
+
+    QOpenGLVertexArrayObject::Binder vaoBinder(vao.get());
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLE_STRIP, VerticesCount(), GL_UNSIGNED_INT, (void*)0, instanceCount, baseInstance);
+}
+
+const QVector<VertexData>& SphereGeometry::getVerticesData() const {
     return vertices;
 }
 
-QVector<GLuint> SphereGeometry::getIndices() {
+const QVector<GLuint>& SphereGeometry::getIndices() const {
     return indices;
 }
 
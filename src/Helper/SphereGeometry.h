@@ -16,6 +16,9 @@ public:
     SphereGeometry() = default;
     ~SphereGeometry() override = default;
 
+    SphereGeometry(SphereGeometry &&) = default;
+    SphereGeometry& operator=(SphereGeometry &&) = default;
+
     void initGeometry() override;
     void setupAttributePointer(QOpenGLShaderProgram *program) override;
     void drawGeometry(QOpenGLShaderProgram *program,
@@ -29,9 +32,16 @@ public:
                       QMatrix4x4 view,
                       QMatrix4x4 projection);
 
+    // model matrices come from an instance buffer bound by the caller, see InstanceData
+    void drawGeometryInstanced(QOpenGLShaderProgram *program,
+                               QMatrix4x4 view,
+                               QMatrix4x4 projection,
+                               int instanceCount,
+                               int baseInstance = 0);
+
 protected:
-    QVector<VertexData> getVerticesData() override;
-    QVector<GLuint> getIndices() override;
+    const QVector<VertexData>& getVerticesData() const override;
+    const QVector<GLuint>& getIndices() const override;
 
     void setupSphere();
 
@@ -0,0 +1,467 @@
+#include "TextureStreamer.h"
+
+#include "KTXFile.h"
+#include "BlockCompression.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QThread>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+
+#include <cmath>
+#include <cstring>
+
+static float sRGBToLinear(float c) {
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linearToSRGB(float c) {
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+static int layerCount(QOpenGLTexture::Target target, const QList<QString> &filePaths) {
+    return target == QOpenGLTexture::Target2DArray ? filePaths.count() : 1;
+}
+
+// name of the cache next to the source, nullptr for the formats that are uploaded as decoded
+static const char* compressedSuffix(QOpenGLTexture::TextureFormat format) {
+    switch (format) {
+        case QOpenGLTexture::RGB_DXT1: return "bc1";
+        case QOpenGLTexture::SRGB_DXT1: return "bc1srgb";
+        case QOpenGLTexture::R_ATI1N_UNorm: return "bc4";
+        case QOpenGLTexture::RG_ATI2N_UNorm: return "bc5";
+        default: return nullptr;
+    }
+}
+
+static bool isSRGB(QOpenGLTexture::TextureFormat format) {
+    return format == QOpenGLTexture::SRGB8 || format == QOpenGLTexture::SRGB8_Alpha8 || format == QOpenGLTexture::SRGB_DXT1;
+}
+
+static int mipLevelCount(const QSize &size) {
+    int levels = 1;
+    for (int extent = qMax(size.width(), size.height()); extent > 1; extent /= 2)
+        levels++;
+    return levels;
+}
+
+TextureStreamer::TextureStreamer(QObject *parent) : QObject(parent) {
+    QOpenGLFunctions_4_5_Core::initializeOpenGLFunctions();
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+
+    if (!QOpenGLContext::supportsThreadedOpenGL()) {
+        qDebug() << "ERROR::TEXTURE_STREAMER:: no threaded OpenGL, uploading on the GL thread";
+        return;
+    }
+
+    // made here and handed to the upload thread, the surface has to be made on the gui thread anyway
+    auto *uploadContext = new QOpenGLContext;
+    uploadContext->setFormat(context->format());
+    uploadContext->setShareContext(context);
+    if (!uploadContext->create()) {
+        qDebug() << "ERROR::TEXTURE_STREAMER:: shared context creation failed, uploading on the GL thread";
+        delete uploadContext;
+        return;
+    }
+
+    m_Surface = new QOffscreenSurface;
+    m_Surface->setFormat(uploadContext->format());
+    m_Surface->create();
+
+    m_UploadThread = QThread::create([this, uploadContext] { uploadLoop(uploadContext); });
+    uploadContext->moveToThread(m_UploadThread);
+    m_UploadThread->start();
+}
+
+TextureStreamer::~TextureStreamer() {
+    m_DecodePool.clear();
+    m_DecodePool.waitForDone();
+
+    if (m_UploadThread) {
+        {
+            QMutexLocker locker(&m_Mutex);
+            m_Stop = true;
+            m_UploadWake.wakeAll();
+        }
+        m_UploadThread->wait();
+        delete m_UploadThread;
+    }
+    delete m_Surface;
+
+    // allocated but never swapped in, the placeholders stay with the caller
+    for (auto *requests : {&m_Uploads, &m_Uploaded}) {
+        for (auto &request : *requests) {
+            if (request.fence)
+                glDeleteSync(request.fence);
+            delete request.texture;
+        }
+    }
+}
+
+void TextureStreamer::load(QOpenGLTexture **texture, const QString &filePath, QOpenGLTexture::TextureFormat format,
+                           QOpenGLTexture::WrapMode wrapMode, const QColor &placeholder) {
+    Request request;
+    request.slot = texture;
+    request.target = QOpenGLTexture::Target2D;
+    request.format = format;
+    request.wrapMode = wrapMode;
+    request.filePaths << filePath;
+    enqueue(request, placeholder);
+}
+
+void TextureStreamer::loadArray(QOpenGLTexture **texture, const QList<QString> &filePaths, QOpenGLTexture::TextureFormat format,
+                                QOpenGLTexture::WrapMode wrapMode, const QColor &placeholder) {
+    Request request;
+    request.slot = texture;
+    request.target = QOpenGLTexture::Target2DArray;
+    request.format = format;
+    request.wrapMode = wrapMode;
+    request.filePaths = filePaths;
+    enqueue(request, placeholder);
+}
+
+bool TextureStreamer::isIdle() const {
+    QMutexLocker locker(&m_Mutex);
+    return m_InFlight == 0;
+}
+
+void TextureStreamer::enqueue(Request request, const QColor &placeholder) {
+    // one texel of the same target until the real texture is in, uncompressed so it can be written
+    bool sRGB = isSRGB(request.format);
+    auto *texture = new QOpenGLTexture(request.target);
+    texture->create();
+    texture->setFormat(compressedSuffix(request.format) ? (sRGB ? QOpenGLTexture::SRGB8 : QOpenGLTexture::RGBA8_UNorm) : request.format);
+    texture->setSize(1, 1);
+    if (request.target == QOpenGLTexture::Target2DArray)
+        texture->setLayers(1);
+    texture->setMipLevels(1);
+    texture->allocateStorage();
+    const uchar texel[4] = {uchar(placeholder.red()), uchar(placeholder.green()), uchar(placeholder.blue()), uchar(placeholder.alpha())};
+    texture->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, texel);
+    texture->setWrapMode(request.wrapMode);
+    texture->setMinMagFilters(QOpenGLTexture::Nearest, QOpenGLTexture::Nearest);
+    *request.slot = texture;
+
+    {
+        QMutexLocker locker(&m_Mutex);
+        m_InFlight++;
+    }
+
+    m_DecodePool.start([this, request]() mutable {
+        bool decoded = decode(request);
+        {
+            QMutexLocker locker(&m_Mutex);
+            if (decoded)
+                m_Decoded << request;
+            else
+                m_InFlight--;
+        }
+        if (decoded)
+            emit textureReady();
+    });
+}
+
+bool TextureStreamer::decode(Request &request) {
+    bool sRGB = isSRGB(request.format);
+    const char *suffix = compressedSuffix(request.format);
+
+    // every layer of an array has the same size, the first image decides it
+    QSize layerSize;
+    for (const auto &filePath : request.filePaths) {
+        QString cachePath = suffix ? QString("%1.%2.ktx").arg(filePath, suffix) : QString();
+        QVector<QByteArray> levels;
+
+        if (!suffix || !loadCompressed(cachePath, filePath, request.format, layerSize, levels)) {
+            QImage image = QImage(filePath).convertToFormat(QImage::Format_RGBA8888);
+            if (image.isNull()) {
+                qDebug() << "ERROR::TEXTURE_STREAMER:: failed to load" << filePath;
+                return false;
+            }
+            if (layerSize.isEmpty())
+                layerSize = image.size();
+            else if (image.size() != layerSize)
+                image = image.scaled(layerSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+            // the whole chain, the upload context only copies
+            levels = mipChain(image, sRGB);
+            if (suffix) {
+                levels = compress(levels, layerSize, request.format);
+
+                KTXFile file;
+                file.glInternalFormat = request.format;
+                file.glBaseInternalFormat = request.format == QOpenGLTexture::R_ATI1N_UNorm ? GL_RED :
+                                            request.format == QOpenGLTexture::RG_ATI2N_UNorm ? GL_RG : GL_RGB;
+                file.width = layerSize.width();
+                file.height = layerSize.height();
+                file.levels = levels;
+                if (!file.save(cachePath))
+                    qDebug() << "ERROR::TEXTURE_STREAMER:: failed to write" << cachePath;
+            }
+        }
+
+        if (request.levels.isEmpty())
+            request.levels.resize(levels.count());
+        for (int level = 0; level < levels.count(); level++)
+            request.levels[level] += levels[level];
+    }
+
+    request.width = layerSize.width();
+    request.height = layerSize.height();
+    return true;
+}
+
+QVector<QByteArray> TextureStreamer::mipChain(const QImage &image, bool sRGB) {
+    int width = image.width();
+    int height = image.height();
+
+    // RGBA8 scan lines never need padding
+    QVector<QByteArray> levels;
+    levels << QByteArray(reinterpret_cast<const char*>(image.constBits()), qsizetype(width) * height * 4);
+    while (width > 1 || height > 1) {
+        levels << downsample(levels.last(), width, height, sRGB);
+        width = qMax(1, width / 2);
+        height = qMax(1, height / 2);
+    }
+    return levels;
+}
+
+QByteArray TextureStreamer::downsample(const QByteArray &texels, int width, int height, bool sRGB) {
+    // sRGB colors are averaged in linear space, as glGenerateMipmap does
+    static const QVector<float> toLinear = [] {
+        QVector<float> table(256);
+        for (int i = 0; i < 256; i++)
+            table[i] = sRGBToLinear(float(i) / 255.0f);
+        return table;
+    }();
+
+    int halfWidth = qMax(1, width / 2);
+    int halfHeight = qMax(1, height / 2);
+    QByteArray half(qsizetype(halfWidth) * halfHeight * 4, Qt::Uninitialized);
+    const auto *src = reinterpret_cast<const uchar*>(texels.constData());
+    auto *dst = reinterpret_cast<uchar*>(half.data());
+
+    for (int y = 0; y < halfHeight; y++) {
+        // a 1 texel wide side repeats itself, an odd last row or column is dropped
+        int y0 = qMin(2 * y, height - 1);
+        int y1 = qMin(2 * y + 1, height - 1);
+        for (int x = 0; x < halfWidth; x++) {
+            int x0 = qMin(2 * x, width - 1);
+            int x1 = qMin(2 * x + 1, width - 1);
+            const uchar *quad[4] = {
+                    src + (qsizetype(y0) * width + x0) * 4, src + (qsizetype(y0) * width + x1) * 4,
+                    src + (qsizetype(y1) * width + x0) * 4, src + (qsizetype(y1) * width + x1) * 4};
+            uchar *out = dst + (qsizetype(y) * halfWidth + x) * 4;
+
+            for (int c = 0; c < 4; c++) {
+                if (sRGB && c < 3) {
+                    float sum = toLinear[quad[0][c]] + toLinear[quad[1][c]] + toLinear[quad[2][c]] + toLinear[quad[3][c]];
+                    out[c] = uchar(linearToSRGB(sum * 0.25f) * 255.0f + 0.5f);
+                } else {
+                    out[c] = uchar((quad[0][c] + quad[1][c] + quad[2][c] + quad[3][c] + 2) / 4);
+                }
+            }
+        }
+    }
+    return half;
+}
+
+bool TextureStreamer::loadCompressed(const QString &cachePath, const QString &sourcePath, QOpenGLTexture::TextureFormat format,
+                                     QSize &layerSize, QVector<QByteArray> &levels) {
+    // older than its source means the source was edited since
+    QFileInfo cache(cachePath);
+    if (!cache.exists() || cache.lastModified() < QFileInfo(sourcePath).lastModified())
+        return false;
+
+    KTXFile file;
+    if (!file.load(cachePath))
+        return false;
+
+    QSize size(int(file.width), int(file.height));
+    if (file.glInternalFormat != quint32(format) || file.faces != 1 || file.levelCount() != mipLevelCount(size) ||
+        (!layerSize.isEmpty() && size != layerSize))
+        return false;
+
+    layerSize = size;
+    levels = file.levels;
+    return true;
+}
+
+QVector<QByteArray> TextureStreamer::compress(const QVector<QByteArray> &levels, const QSize &size, QOpenGLTexture::TextureFormat format) {
+    QVector<QByteArray> blocks;
+    for (int level = 0; level < levels.count(); level++) {
+        int width = qMax(1, size.width() >> level);
+        int height = qMax(1, size.height() >> level);
+        const auto *texels = reinterpret_cast<const uchar*>(levels[level].constData());
+
+        if (format == QOpenGLTexture::R_ATI1N_UNorm)
+            blocks << BlockCompression::compressBC4(texels, width, height);
+        else if (format == QOpenGLTexture::RG_ATI2N_UNorm)
+            blocks << BlockCompression::compressBC5(texels, width, height);
+        else
+            blocks << BlockCompression::compressBC1(texels, width, height);
+    }
+    return blocks;
+}
+
+void TextureStreamer::allocate(Request &request) {
+    auto *texture = new QOpenGLTexture(request.target);
+    texture->create();
+    texture->setFormat(request.format);
+    texture->setSize(request.width, request.height);
+    if (request.target == QOpenGLTexture::Target2DArray)
+        texture->setLayers(layerCount(request.target, request.filePaths));
+    texture->setMipLevels(request.levels.count());
+    texture->allocateStorage();
+    texture->setWrapMode(request.wrapMode);
+    texture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+    texture->setMagnificationFilter(QOpenGLTexture::Linear);
+    if (request.format == QOpenGLTexture::R_ATI1N_UNorm)
+        texture->setSwizzleMask(QOpenGLTexture::RedValue, QOpenGLTexture::RedValue, QOpenGLTexture::RedValue, QOpenGLTexture::OneValue);
+
+    request.texture = texture;
+    request.textureId = texture->textureId();
+    // the upload context must not touch the storage before it exists
+    request.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void TextureStreamer::upload(QOpenGLFunctions_4_5_Core *gl, Request &request) {
+    gl->glWaitSync(request.fence, 0, GL_TIMEOUT_IGNORED);
+    gl->glDeleteSync(request.fence);
+
+    qsizetype size = 0;
+    for (const auto &level : request.levels)
+        size += level.size();
+
+    // staged in a pixel unpack buffer so the copies into the texture run on the gpu's schedule
+    GLuint pixelBuffer = 0;
+    gl->glCreateBuffers(1, &pixelBuffer);
+    gl->glNamedBufferStorage(pixelBuffer, size, nullptr, GL_MAP_WRITE_BIT);
+    auto *mapped = static_cast<char*>(gl->glMapNamedBufferRange(pixelBuffer, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (mapped) {
+        qsizetype offset = 0;
+        for (const auto &level : request.levels) {
+            std::memcpy(mapped + offset, level.constData(), level.size());
+            offset += level.size();
+        }
+        gl->glUnmapNamedBuffer(pixelBuffer);
+        gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    } else {
+        qDebug() << "ERROR::TEXTURE_STREAMER:: pixel buffer map failed, size" << size;
+    }
+
+    int layers = layerCount(request.target, request.filePaths);
+    qsizetype offset = 0;
+    for (int level = 0; level < request.levels.count(); level++) {
+        int width = qMax(1, request.width >> level);
+        int height = qMax(1, request.height >> level);
+        // an offset into the bound buffer, or client memory when the map failed
+        const void *pixels = mapped ? reinterpret_cast<const void*>(offset) : request.levels[level].constData();
+        auto levelSize = GLsizei(request.levels[level].size());
+        if (compressedSuffix(request.format)) {
+            if (request.target == QOpenGLTexture::Target2DArray)
+                gl->glCompressedTextureSubImage3D(request.textureId, level, 0, 0, 0, width, height, layers, request.format, levelSize, pixels);
+            else
+                gl->glCompressedTextureSubImage2D(request.textureId, level, 0, 0, width, height, request.format, levelSize, pixels);
+        } else {
+            if (request.target == QOpenGLTexture::Target2DArray)
+                gl->glTextureSubImage3D(request.textureId, level, 0, 0, 0, width, height, layers, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            else
+                gl->glTextureSubImage2D(request.textureId, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        }
+        offset += levelSize;
+    }
+
+    // deleting is deferred until the copies are done with it
+    gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    gl->glDeleteBuffers(1, &pixelBuffer);
+
+    request.fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // the GL thread polls the fence from its own context, it has to reach the gpu
+    gl->glFlush();
+    request.levels.clear();
+}
+
+void TextureStreamer::uploadLoop(QOpenGLContext *uploadContext) {
+    uploadContext->makeCurrent(m_Surface);
+    QOpenGLFunctions_4_5_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    QMutexLocker locker(&m_Mutex);
+    while (true) {
+        while (m_Uploads.isEmpty() && !m_Stop)
+            m_UploadWake.wait(&m_Mutex);
+        if (m_Stop)
+            break;
+
+        Request request = m_Uploads.takeFirst();
+        locker.unlock();
+        upload(&gl, request);
+        locker.relock();
+        m_Uploaded << request;
+
+        locker.unlock();
+        emit textureReady();
+        locker.relock();
+    }
+    locker.unlock();
+
+    uploadContext->doneCurrent();
+    delete uploadContext;
+}
+
+bool TextureStreamer::collect() {
+    QList<Request> decoded;
+    QList<Request> uploaded;
+    {
+        QMutexLocker locker(&m_Mutex);
+        decoded.swap(m_Decoded);
+        uploaded.swap(m_Uploaded);
+    }
+
+    if (!decoded.isEmpty()) {
+        for (auto &request : decoded)
+            allocate(request);
+        // the upload context waits on the allocation fences, they have to reach the gpu
+        glFlush();
+
+        if (m_UploadThread) {
+            QMutexLocker locker(&m_Mutex);
+            m_Uploads << decoded;
+            m_UploadWake.wakeOne();
+        } else {
+            for (auto &request : decoded)
+                upload(this, request);
+            uploaded << decoded;
+        }
+    }
+
+    bool swapped = false;
+    QList<Request> waiting;
+    for (auto &request : uploaded) {
+        if (glClientWaitSync(request.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            waiting << request;
+            continue;
+        }
+        glDeleteSync(request.fence);
+
+        // the viewers bind their textures every frame, which is what makes the writes of the
+        // upload context visible in this one after the fence
+        delete *request.slot;
+        *request.slot = request.texture;
+        swapped = true;
+
+        QMutexLocker locker(&m_Mutex);
+        m_InFlight--;
+    }
+
+    if (!waiting.isEmpty()) {
+        {
+            QMutexLocker locker(&m_Mutex);
+            m_Uploaded = waiting + m_Uploaded;
+        }
+        // ask for another frame to poll them again
+        emit textureReady();
+    }
+    return swapped;
+}
@@ -0,0 +1,101 @@
+#ifndef QTREFERENCE_TEXTURESTREAMER_H
+#define QTREFERENCE_TEXTURESTREAMER_H
+
+#include <QColor>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QOpenGLTexture>
+#include <QOpenGLFunctions_4_5_Core>
+
+class QOffscreenSurface;
+class QOpenGLContext;
+class QThread;
+
+/*
+ * Loads image textures without stalling the GL thread. A request puts a 1x1 placeholder into the
+ * caller's texture pointer right away; worker threads decode the images and build the mip chain,
+ * collect() allocates the storage, and an upload thread with a context shared with the caller's
+ * copies the texels through a pixel unpack buffer. Once the upload fence has signaled, collect()
+ * swaps the finished texture into the pointer and deletes the placeholder.
+ * Without threaded OpenGL the copies run in collect() instead, still through the buffer.
+ * Block compressed formats (RGB_DXT1 / SRGB_DXT1, R_ATI1N_UNorm, RG_ATI2N_UNorm) are transcoded
+ * by the workers the first time and cached next to the source as <file>.<codec>.ktx, later runs
+ * read the blocks straight from there. BC4 textures read red in every channel like the grayscale
+ * images they stand for; BC5 keeps only x and y of a normal map, the shader rebuilds z.
+ */
+class TextureStreamer : public QObject, protected QOpenGLFunctions_4_5_Core {
+Q_OBJECT
+public:
+    // needs a current context, the textures live in its share group; destroy with it current too
+    explicit TextureStreamer(QObject *parent = nullptr);
+    ~TextureStreamer() override;
+
+    // *texture must stay at the same address until the request is collected, the caller owns what it points to
+    void load(QOpenGLTexture **texture, const QString &filePath, QOpenGLTexture::TextureFormat format,
+              QOpenGLTexture::WrapMode wrapMode = QOpenGLTexture::Repeat, const QColor &placeholder = Qt::gray);
+    // one image per layer, every layer scaled to the size of the first
+    void loadArray(QOpenGLTexture **texture, const QList<QString> &filePaths, QOpenGLTexture::TextureFormat format,
+                   QOpenGLTexture::WrapMode wrapMode = QOpenGLTexture::Repeat, const QColor &placeholder = Qt::gray);
+
+    // GL thread, once per frame; true when a texture was swapped in
+    bool collect();
+    bool isIdle() const;
+
+signals:
+    // from any thread, collect() has work to do
+    void textureReady();
+
+private:
+    struct Request {
+        QOpenGLTexture **slot = nullptr;
+        QOpenGLTexture::Target target = QOpenGLTexture::Target2D;
+        QOpenGLTexture::TextureFormat format = QOpenGLTexture::RGBA8_UNorm;
+        QOpenGLTexture::WrapMode wrapMode = QOpenGLTexture::Repeat;
+        QList<QString> filePaths;
+
+        int width = 0;
+        int height = 0;
+        // RGBA8 or blocks, the layers of a level back to back
+        QVector<QByteArray> levels;
+
+        QOpenGLTexture *texture = nullptr;
+        GLuint textureId = 0;
+        GLsync fence = nullptr;
+    };
+
+    void enqueue(Request request, const QColor &placeholder);
+    static bool decode(Request &request);
+    static QVector<QByteArray> mipChain(const QImage &image, bool sRGB);
+    static QByteArray downsample(const QByteArray &texels, int width, int height, bool sRGB);
+
+    // the level chain of one layer from the cache next to sourcePath, layerSize empty takes any size
+    static bool loadCompressed(const QString &cachePath, const QString &sourcePath, QOpenGLTexture::TextureFormat format,
+                               QSize &layerSize, QVector<QByteArray> &levels);
+    static QVector<QByteArray> compress(const QVector<QByteArray> &levels, const QSize &size, QOpenGLTexture::TextureFormat format);
+
+    void allocate(Request &request);
+    static void upload(QOpenGLFunctions_4_5_Core *gl, Request &request);
+    void uploadLoop(QOpenGLContext *uploadContext);
+
+    QThreadPool m_DecodePool;
+    QThread *m_UploadThread = nullptr;
+    QOffscreenSurface *m_Surface = nullptr;
+
+    mutable QMutex m_Mutex;
+    QWaitCondition m_UploadWake;
+    bool m_Stop = false;
+    int m_InFlight = 0;
+    // decoded, waiting for storage (GL thread)
+    QList<Request> m_Decoded;
+    // storage allocated, waiting for the texel copy (upload thread)
+    QList<Request> m_Uploads;
+    // copied, waiting for the fence (GL thread)
+    QList<Request> m_Uploaded;
+};
+
+
+#endif
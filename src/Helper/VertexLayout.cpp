@@ -0,0 +1,193 @@
+#include "VertexLayout.h"
+#include "Geometry.h"
+
+#include <QFloat16>
+#include <cmath>
+#include <cstring>
+
+static void readAttribute(const VertexData &vertex, VertexAttribute attribute, float out[4]) {
+    switch (attribute) {
+        case VertexAttribute::Position:
+            out[0] = vertex.position.x(); out[1] = vertex.position.y(); out[2] = vertex.position.z();
+            break;
+        case VertexAttribute::TexCoord:
+            out[0] = vertex.texCoord.x(); out[1] = vertex.texCoord.y();
+            break;
+        case VertexAttribute::Normal:
+            out[0] = vertex.normal.x(); out[1] = vertex.normal.y(); out[2] = vertex.normal.z();
+            break;
+        case VertexAttribute::Tangent:
+            out[0] = vertex.tangent.x(); out[1] = vertex.tangent.y(); out[2] = vertex.tangent.z();
+            break;
+        case VertexAttribute::Bitangent:
+            out[0] = vertex.bitangent.x(); out[1] = vertex.bitangent.y(); out[2] = vertex.bitangent.z();
+            break;
+        case VertexAttribute::BlendShapeData:
+            out[0] = vertex.bsdata.x(); out[1] = vertex.bsdata.y(); out[2] = vertex.bsdata.z(); out[3] = vertex.bsdata.w();
+            break;
+        case VertexAttribute::BoneIds:
+            out[0] = vertex.m_BoneIDs.x(); out[1] = vertex.m_BoneIDs.y(); out[2] = vertex.m_BoneIDs.z(); out[3] = vertex.m_BoneIDs.w();
+            break;
+        case VertexAttribute::Weights:
+            out[0] = vertex.m_Weights.x(); out[1] = vertex.m_Weights.y(); out[2] = vertex.m_Weights.z(); out[3] = vertex.m_Weights.w();
+            break;
+    }
+}
+
+static quint32 packSnorm1010102(const float v[3]) {
+    // imported normals are not always unit length, keep the direction instead of clamping it
+    float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    float scale = length > 1.0f ? 1.0f / length : 1.0f;
+
+    quint32 packed = 0;
+    for (int i = 0; i < 3; i++) {
+        qint32 component = qRound(qBound(-1.0f, v[i] * scale, 1.0f) * 511.0f);
+        packed |= (quint32(component) & 0x3ff) << (i * 10);
+    }
+    return packed;
+}
+
+VertexLayout& VertexLayout::add(VertexAttribute attribute, VertexEncoding encoding, int stream) {
+    Q_ASSERT(stream >= 0 && stream < MAX_VERTEX_STREAMS);
+    Q_ASSERT(!contains(attribute));
+
+    VertexAttributeFormat format{attribute, encoding, stream, m_Strides[stream]};
+    m_Attributes.append(format);
+
+    m_Strides[stream] += byteSize(attribute, encoding);
+    m_StreamCount = qMax(m_StreamCount, stream + 1);
+
+    return *this;
+}
+
+bool VertexLayout::contains(VertexAttribute attribute) const {
+    for (const auto &format : m_Attributes) {
+        if (format.attribute == attribute)
+            return true;
+    }
+    return false;
+}
+
+QByteArray VertexLayout::pack(const VertexData *data, int count, int stream) const {
+    const int streamStride = m_Strides[stream];
+    QByteArray bytes(count * streamStride, Qt::Uninitialized);
+    char *dst = bytes.data();
+
+    for (const auto &format : m_Attributes) {
+        if (format.stream != stream)
+            continue;
+
+        const int components = tupleSize(format.attribute, format.encoding);
+        const int size = byteSize(format.attribute, format.encoding);
+
+        for (int i = 0; i < count; i++) {
+            float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            readAttribute(data[i], format.attribute, value);
+
+            char *out = dst + i * streamStride + format.offset;
+            memset(out, 0, size);
+
+            switch (format.encoding) {
+                case VertexEncoding::Float:
+                    memcpy(out, value, components * sizeof(float));
+                    break;
+                case VertexEncoding::HalfFloat:
+                    for (int c = 0; c < components; c++) {
+                        qfloat16 half(value[c]);
+                        memcpy(out + c * sizeof(qfloat16), &half, sizeof(qfloat16));
+                    }
+                    break;
+                case VertexEncoding::PackedNormal: {
+                    quint32 packed = packSnorm1010102(value);
+                    memcpy(out, &packed, sizeof(quint32));
+                    break;
+                }
+                case VertexEncoding::Short:
+                    for (int c = 0; c < components; c++) {
+                        qint16 integer = qint16(qRound(value[c]));
+                        memcpy(out + c * sizeof(qint16), &integer, sizeof(qint16));
+                    }
+                    break;
+            }
+        }
+    }
+
+    return bytes;
+}
+
+VertexLayout VertexLayout::fullLayout() {
+    VertexLayout layout;
+    layout.add(VertexAttribute::Position)
+          .add(VertexAttribute::TexCoord)
+          .add(VertexAttribute::Normal)
+          .add(VertexAttribute::Tangent)
+          .add(VertexAttribute::Bitangent)
+          .add(VertexAttribute::BlendShapeData)
+          .add(VertexAttribute::BoneIds)
+          .add(VertexAttribute::Weights);
+    return layout;
+}
+
+const char* VertexLayout::attributeName(VertexAttribute attribute) {
+    switch (attribute) {
+        case VertexAttribute::Position:       return "aPos";
+        case VertexAttribute::TexCoord:       return "aCoord";
+        case VertexAttribute::Normal:         return "aNormal";
+        case VertexAttribute::Tangent:        return "aTangent";
+        case VertexAttribute::Bitangent:      return "aBitangent";
+        case VertexAttribute::BlendShapeData: return "aBlendShapeData";
+        case VertexAttribute::BoneIds:        return "boneIds";
+        case VertexAttribute::Weights:        return "weights";
+    }
+    return "";
+}
+
+int VertexLayout::tupleSize(VertexAttribute attribute, VertexEncoding encoding) {
+    // 2_10_10_10 is always fetched as 4 components, the shader just ignores w
+    if (encoding == VertexEncoding::PackedNormal)
+        return 4;
+
+    switch (attribute) {
+        case VertexAttribute::TexCoord:
+            return 2;
+        case VertexAttribute::Position:
+        case VertexAttribute::Normal:
+        case VertexAttribute::Tangent:
+        case VertexAttribute::Bitangent:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+int VertexLayout::byteSize(VertexAttribute attribute, VertexEncoding encoding) {
+    int size = 0;
+    switch (encoding) {
+        case VertexEncoding::Float:
+            size = tupleSize(attribute, encoding) * sizeof(float);
+            break;
+        case VertexEncoding::HalfFloat:
+        case VertexEncoding::Short:
+            size = tupleSize(attribute, encoding) * sizeof(qint16);
+            break;
+        case VertexEncoding::PackedNormal:
+            size = sizeof(quint32);
+            break;
+    }
+    // keep every attribute 4 byte aligned
+    return (size + 3) & ~3;
+}
+
+GLenum VertexLayout::glType(VertexEncoding encoding) {
+    switch (encoding) {
+        case VertexEncoding::Float:        return GL_FLOAT;
+        case VertexEncoding::HalfFloat:    return GL_HALF_FLOAT;
+        case VertexEncoding::PackedNormal: return GL_INT_2_10_10_10_REV;
+        case VertexEncoding::Short:        return GL_SHORT;
+    }
+    return GL_FLOAT;
+}
+
+GLboolean VertexLayout::isNormalized(VertexEncoding encoding) {
+    return encoding == VertexEncoding::PackedNormal ? GL_TRUE : GL_FALSE;
+}
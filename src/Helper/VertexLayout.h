@@ -0,0 +1,75 @@
+#ifndef _VERTEXLAYOUT_H_
+#define _VERTEXLAYOUT_H_
+
+#include <QVector>
+#include <QByteArray>
+#include <QOpenGLFunctions_4_5_Core>
+
+#define MAX_VERTEX_STREAMS 4
+
+struct VertexData;
+
+// Every field of VertexData that can be uploaded, named after the shader input it feeds.
+enum class VertexAttribute {
+    Position = 0,   // aPos
+    TexCoord,       // aCoord
+    Normal,         // aNormal
+    Tangent,        // aTangent
+    Bitangent,      // aBitangent
+    BlendShapeData, // aBlendShapeData
+    BoneIds,        // boneIds
+    Weights         // weights
+};
+
+// How an attribute is stored on the GPU, the shader input type does not change.
+enum class VertexEncoding {
+    Float,          // 32 bit float per component
+    HalfFloat,      // 16 bit float per component
+    PackedNormal,   // GL_INT_2_10_10_10_REV, normalized, for unit vectors
+    Short           // 16 bit signed integer per component, converted to float, for ids
+};
+
+struct VertexAttributeFormat {
+    VertexAttribute attribute;
+    VertexEncoding encoding;
+    int stream;
+    int offset;
+};
+
+/*
+ * Describes which VertexData fields a geometry uploads and in which buffer (stream) each one lives.
+ * Every stream is interleaved and tightly packed, so static geometry only pays for what its shader
+ * reads and optional data like skinning can sit in its own stream.
+ */
+class VertexLayout {
+public:
+    VertexLayout() = default;
+
+    VertexLayout& add(VertexAttribute attribute, VertexEncoding encoding = VertexEncoding::Float, int stream = 0);
+
+    bool contains(VertexAttribute attribute) const;
+    bool isEmpty() const { return m_Attributes.isEmpty(); }
+    int streamCount() const { return m_StreamCount; }
+    int stride(int stream) const { return m_Strides[stream]; }
+    const QVector<VertexAttributeFormat>& attributes() const { return m_Attributes; }
+
+    // convert VertexData into the tightly packed bytes of one stream
+    QByteArray pack(const VertexData *data, int count, int stream) const;
+
+    // everything VertexData holds, as plain floats in one stream
+    static VertexLayout fullLayout();
+
+    static const char* attributeName(VertexAttribute attribute);
+    static int tupleSize(VertexAttribute attribute, VertexEncoding encoding);
+    static int byteSize(VertexAttribute attribute, VertexEncoding encoding);
+    static GLenum glType(VertexEncoding encoding);
+    static GLboolean isNormalized(VertexEncoding encoding);
+
+private:
+    QVector<VertexAttributeFormat> m_Attributes;
+    int m_Strides[MAX_VERTEX_STREAMS] = {0};
+    int m_StreamCount = 0;
+};
+
+
+#endif
@@ -3,6 +3,8 @@
 in vec2 coord;
 out vec2 FragColor;
 
+uniform uint sampleCount;
+
 const float PI = 3.14159265359;
 // ----------------------------------------------------------------------------
 // efficient VanDerCorpus calculation.
@@ -90,9 +92,8 @@ vec2 IntegrateBRDF(float NdotV, float roughness)
 
     vec3 N = vec3(0.0, 0.0, 1.0);
 
-    const uint SAMPLE_COUNT = 1024u;
-    for (uint i = 0; i < SAMPLE_COUNT; ++i) {
-        vec2 Xi = Hammersley(i, SAMPLE_COUNT);
+    for (uint i = 0; i < sampleCount; ++i) {
+        vec2 Xi = Hammersley(i, sampleCount);
         vec3 H = ImportanceSampleGGX(Xi, N, roughness);
         vec3 L = normalize(2.0 * dot(V, H) * H - V);
 
@@ -118,8 +119,8 @@ vec2 IntegrateBRDF(float NdotV, float roughness)
             B += Fc * G_Vis;
         }
     }
-    A /= float(SAMPLE_COUNT);
-    B /= float(SAMPLE_COUNT);
+    A /= float(sampleCount);
+    B /= float(sampleCount);
     return vec2(A, B);
 }
 
@@ -0,0 +1,53 @@
+#version 460 core
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// one mip level of the prefiltered map, the six faces are the layers
+layout (binding = 0, rgba16f) uniform writeonly imageCube prefilterMap;
+
+uniform samplerCube environmentMap;
+
+// tangent space L (xyz) and environment mip level (w) of every sample with NdotL > 0, the same for
+// all texels of a roughness (IBLReference::prefilterSamples), binding IBL_SAMPLE_BINDING
+layout (std430, binding = 9) readonly buffer PrefilterSamples {
+    vec4 prefilterSample[];
+};
+
+uniform int sampleCount;
+uniform float totalWeight;
+
+// direction through the texel center, the face layout of samplerCube
+vec3 texelDirection(ivec3 texel, int size) {
+    vec2 st = 2.0 * (vec2(texel.xy) + 0.5) / float(size) - 1.0;
+    switch (texel.z) {
+        case 0: return normalize(vec3(1.0, -st.y, -st.x));
+        case 1: return normalize(vec3(-1.0, -st.y, st.x));
+        case 2: return normalize(vec3(st.x, 1.0, st.y));
+        case 3: return normalize(vec3(st.x, -1.0, -st.y));
+        case 4: return normalize(vec3(st.x, -st.y, 1.0));
+        default: return normalize(vec3(-st.x, -st.y, -1.0));
+    }
+}
+
+void main() {
+    int size = imageSize(prefilterMap).x;
+    ivec3 texel = ivec3(gl_GlobalInvocationID);
+    if (texel.x >= size || texel.y >= size)
+        return;
+
+    vec3 N = texelDirection(texel, size);
+
+    // the tangent frame the samples were made in
+    vec3 up        = abs(N.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+    vec3 tangent   = normalize(cross(up, N));
+    vec3 bitangent = cross(N, tangent);
+
+    vec3 prefilteredColor = vec3(0.0);
+    for (int i = 0; i < sampleCount; i++) {
+        vec4 s = prefilterSample[i];
+        vec3 L = tangent * s.x + bitangent * s.y + N * s.z;
+        prefilteredColor += textureLod(environmentMap, L, s.w).rgb * s.z;
+    }
+
+    imageStore(prefilterMap, texel, vec4(prefilteredColor / totalWeight, 1.0));
+}